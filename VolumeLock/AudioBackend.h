@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+
+#include "ProcessInfoCache.h"
+
+// 与平台无关的音频后端接口
+// Windows 上由 CoreAudioAPI.h 中的 Core Audio 实现，AudioSimulator.h 提供内存中的模拟实现
+
+class AudioSession;
+class AudioDevice;
+
+enum class DeviceState
+{
+	Active,
+	Disabled,
+	NotPresent,
+	Unplugged
+};
+
+// 会话因进程退出而移除时 OnSessionRemoved 的 reason
+constexpr int SessionExpiredReason = 1000;
+
+class AudioSessionEvents
+{
+public:
+	virtual void OnVolumeChanged(std::shared_ptr<AudioSession> session, int volume) {}
+	virtual void OnStateChanged(std::shared_ptr<AudioSession> session, bool active) {}
+};
+
+class AudioDeviceEvents
+{
+public:
+	virtual void OnSessionAdded(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session) {}
+	virtual void OnSessionRemoved(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session, int reason) {}
+};
+
+class AudioDeviceEnumeratorEvents
+{
+public:
+	virtual void OnDeviceAdded(std::shared_ptr<AudioDevice> device) {}
+	virtual void OnDeviceRemoved(std::shared_ptr<AudioDevice> device) {}
+	virtual void OnDeviceStateChanged(std::shared_ptr<AudioDevice> device, DeviceState state) {}
+	virtual void OnDefaultDeviceChanged(std::shared_ptr<AudioDevice> device) {}
+};
+
+class AudioSession
+{
+public:
+	virtual ~AudioSession() = default;
+
+	virtual const std::wstring& GetDisplayName() = 0;
+
+	virtual uint32_t GetProcessId() = 0;
+
+	// 同一进程的多个会话共享同一份进程信息
+	virtual const std::shared_ptr<const ProcessInfo>& GetProcessInfo() = 0;
+
+	const std::filesystem::path& GetProcessPath()
+	{
+		return GetProcessInfo()->Path;
+	}
+
+	// 本程序设置的音量不会触发 OnVolumeChanged
+	virtual void SetVolume(int v) = 0;
+
+	virtual int GetVolume() = 0;
+
+	virtual void RegisterNotification(AudioSessionEvents* cb) = 0;
+
+	virtual void UnregisterNotification(AudioSessionEvents* cb) = 0;
+};
+
+class AudioDevice
+{
+public:
+	virtual ~AudioDevice() = default;
+
+	virtual const std::wstring& GetId() = 0;
+
+	virtual const std::wstring& GetFriendlyName() = 0;
+
+	virtual bool IsActive() = 0;
+
+	virtual std::vector<std::shared_ptr<AudioSession>> GetAllSession() = 0;
+
+	virtual void RegisterNotification(AudioDeviceEvents* cb) = 0;
+
+	virtual void UnregisterNotification(AudioDeviceEvents* cb) = 0;
+};
+
+class AudioDeviceEnumerator
+{
+public:
+	virtual ~AudioDeviceEnumerator() = default;
+
+	// 没有默认设备时抛出异常
+	virtual std::shared_ptr<AudioDevice> GetDefaultDevice() = 0;
+
+	// 所有处于启用状态的输出设备
+	virtual std::vector<std::shared_ptr<AudioDevice>> GetActiveDevices() = 0;
+
+	virtual void RegisterNotification(AudioDeviceEnumeratorEvents* cb) = 0;
+
+	virtual void UnregisterNotification(AudioDeviceEnumeratorEvents* cb) = 0;
+};
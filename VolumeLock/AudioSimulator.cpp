@@ -0,0 +1,300 @@
+﻿#include "AudioSimulator.h"
+
+#include <stdexcept>
+#include <thread>
+
+static void Delay(std::chrono::microseconds d)
+{
+	if (d.count() > 0)
+	{
+		std::this_thread::sleep_for(d);
+	}
+}
+
+static int ClampVolume(int v)
+{
+	if (v < 0) return 0;
+	if (v > 100) return 100;
+	return v;
+}
+
+#pragma region SimAudioSession
+
+SimAudioSession::SimAudioSession(std::shared_ptr<const SimContext> context, uint32_t pid, const std::filesystem::path& path, int volume, uint64_t startTime)
+	: m_context(context), m_DisplayName(StringPool::Default().Intern(path.filename().wstring())), m_ProcessInfo(ProcessInfoCache::MakeInfo(pid, startTime, path)), m_volume(ClampVolume(volume))
+{
+}
+
+void SimAudioSession::SetVolume(int v)
+{
+	v = ClampVolume(v);
+	Delay(m_context->Latency.SetVolume);
+	{
+		std::lock_guard lock(m_mutex);
+		ThrowIfExpired();
+		m_volume = v;
+		m_writes++;
+	}
+	if (m_context->OnWrite)
+	{
+		m_context->OnWrite(shared_from_this(), v);
+	}
+}
+
+int SimAudioSession::GetVolume()
+{
+	Delay(m_context->Latency.GetVolume);
+	std::lock_guard lock(m_mutex);
+	ThrowIfExpired();
+	return m_volume;
+}
+
+void SimAudioSession::RegisterNotification(AudioSessionEvents* cb)
+{
+	m_callback.Add(cb);
+}
+
+void SimAudioSession::UnregisterNotification(AudioSessionEvents* cb)
+{
+	m_callback.Remove(cb);
+}
+
+void SimAudioSession::ChangeVolume(int v)
+{
+	v = ClampVolume(v);
+	{
+		std::lock_guard lock(m_mutex);
+		m_volume = v;
+	}
+	Delay(m_context->Latency.Notify);
+	m_callback.ForEach([&](auto cb) { cb->OnVolumeChanged(shared_from_this(), v); });
+}
+
+uint64_t SimAudioSession::GetWriteCount()
+{
+	std::lock_guard lock(m_mutex);
+	return m_writes;
+}
+
+void SimAudioSession::Expire()
+{
+	std::lock_guard lock(m_mutex);
+	m_expired = true;
+}
+
+void SimAudioSession::ThrowIfExpired()
+{
+	if (m_expired)
+	{
+		throw std::runtime_error("audio session expired");
+	}
+}
+
+#pragma endregion
+
+#pragma region SimAudioDevice
+
+SimAudioDevice::SimAudioDevice(std::shared_ptr<const SimContext> context, const std::wstring& id, const std::wstring& name)
+	: m_context(context), m_Id(StringPool::Default().Intern(id)), m_FriendlyName(StringPool::Default().Intern(name))
+{
+}
+
+const std::wstring& SimAudioDevice::GetFriendlyName()
+{
+	std::lock_guard lock(m_mutex);
+	ThrowIfFailed();
+	if (m_propertiesFailed)
+	{
+		throw std::runtime_error("audio device properties unavailable");
+	}
+	return m_FriendlyName.Get();
+}
+
+bool SimAudioDevice::IsActive()
+{
+	std::lock_guard lock(m_mutex);
+	ThrowIfFailed();
+	return m_state == DeviceState::Active;
+}
+
+std::vector<std::shared_ptr<AudioSession>> SimAudioDevice::GetAllSession()
+{
+	std::lock_guard lock(m_mutex);
+	ThrowIfFailed();
+	return std::vector<std::shared_ptr<AudioSession>>(m_sessions.begin(), m_sessions.end());
+}
+
+void SimAudioDevice::RegisterNotification(AudioDeviceEvents* cb)
+{
+	m_callback.Add(cb);
+}
+
+void SimAudioDevice::UnregisterNotification(AudioDeviceEvents* cb)
+{
+	m_callback.Remove(cb);
+}
+
+std::shared_ptr<SimAudioSession> SimAudioDevice::AddSession(uint32_t pid, const std::filesystem::path& path, int volume, uint64_t startTime)
+{
+	auto session = std::make_shared<SimAudioSession>(m_context, pid, path, volume, startTime);
+	{
+		std::lock_guard lock(m_mutex);
+		m_sessions.insert(session);
+	}
+	Delay(m_context->Latency.Notify);
+	m_callback.ForEach([&](auto cb) { cb->OnSessionAdded(shared_from_this(), session); });
+	return session;
+}
+
+void SimAudioDevice::RemoveSession(const std::shared_ptr<SimAudioSession>& session, int reason)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_sessions.erase(session) == 0)
+		{
+			return;
+		}
+	}
+	Delay(m_context->Latency.Notify);
+	m_callback.ForEach([&](auto cb) { cb->OnSessionRemoved(shared_from_this(), session, reason); });
+}
+
+void SimAudioDevice::Fail()
+{
+	std::lock_guard lock(m_mutex);
+	m_failed = true;
+}
+
+void SimAudioDevice::FailProperties()
+{
+	std::lock_guard lock(m_mutex);
+	m_propertiesFailed = true;
+}
+
+void SimAudioDevice::ThrowIfFailed()
+{
+	if (m_failed)
+	{
+		throw std::runtime_error("audio device unavailable");
+	}
+}
+
+#pragma endregion
+
+#pragma region SimAudioDeviceEnumerator
+
+SimAudioDeviceEnumerator::SimAudioDeviceEnumerator(SimContext context) : m_context(std::make_shared<const SimContext>(std::move(context)))
+{
+}
+
+std::shared_ptr<AudioDevice> SimAudioDeviceEnumerator::GetDefaultDevice()
+{
+	std::lock_guard lock(m_mutex);
+	if (!m_default)
+	{
+		throw std::runtime_error("没有默认设备");
+	}
+	return m_default;
+}
+
+std::vector<std::shared_ptr<AudioDevice>> SimAudioDeviceEnumerator::GetActiveDevices()
+{
+	std::lock_guard lock(m_mutex);
+	std::vector<std::shared_ptr<AudioDevice>> result;
+	for (auto&& [id, device] : m_devices)
+	{
+		try
+		{
+			if (device->IsActive())
+			{
+				result.push_back(device);
+			}
+		}
+		catch (const std::exception&)
+		{
+			// 与 Core Audio 后端一样，跳过无法读取状态的设备
+		}
+	}
+	return result;
+}
+
+void SimAudioDeviceEnumerator::RegisterNotification(AudioDeviceEnumeratorEvents* cb)
+{
+	m_callback.Add(cb);
+}
+
+void SimAudioDeviceEnumerator::UnregisterNotification(AudioDeviceEnumeratorEvents* cb)
+{
+	m_callback.Remove(cb);
+}
+
+std::shared_ptr<SimAudioDevice> SimAudioDeviceEnumerator::AddDevice(const std::wstring& id, const std::wstring& name)
+{
+	auto device = std::make_shared<SimAudioDevice>(m_context, id, name);
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_devices.find(id) != m_devices.end())
+		{
+			throw std::invalid_argument("设备 ID 重复");
+		}
+		m_devices[id] = device;
+		if (!m_default)
+		{
+			m_default = device;
+		}
+	}
+	Delay(m_context->Latency.Notify);
+	m_callback.ForEach([&](auto cb) { cb->OnDeviceAdded(device); });
+	return device;
+}
+
+void SimAudioDeviceEnumerator::RemoveDevice(const std::shared_ptr<SimAudioDevice>& device)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_devices.erase(device->GetId()) == 0)
+		{
+			return;
+		}
+		// 默认设备被移除时，系统会另选一个，但这里不模拟随之而来的默认设备变化通知
+		if (m_default == device)
+		{
+			m_default = m_devices.empty() ? nullptr : m_devices.begin()->second;
+		}
+	}
+	Delay(m_context->Latency.Notify);
+	m_callback.ForEach([&](auto cb) { cb->OnDeviceRemoved(device); });
+}
+
+void SimAudioDeviceEnumerator::SetDeviceState(const std::shared_ptr<SimAudioDevice>& device, DeviceState state)
+{
+	{
+		std::lock_guard lock(device->m_mutex);
+		device->m_state = state;
+	}
+	Delay(m_context->Latency.Notify);
+	m_callback.ForEach([&](auto cb) { cb->OnDeviceStateChanged(device, state); });
+}
+
+void SimAudioDeviceEnumerator::SetDefaultDevice(const std::shared_ptr<SimAudioDevice>& device)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_default = device;
+	}
+	Delay(m_context->Latency.Notify);
+	m_callback.ForEach([&](auto cb) { cb->OnDefaultDeviceChanged(device); });
+}
+
+std::optional<std::shared_ptr<SimAudioDevice>> SimAudioDeviceEnumerator::GetDeviceById(const std::wstring& id)
+{
+	std::lock_guard lock(m_mutex);
+	auto it = m_devices.find(id);
+	if (it == m_devices.end())
+	{
+		return {};
+	}
+	return it->second;
+}
+
+#pragma endregion
@@ -0,0 +1,181 @@
+﻿#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <filesystem>
+#include <set>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <chrono>
+#include <optional>
+
+#include "AudioBackend.h"
+#include "StringPool.h"
+#include "ListenerList.h"
+
+// 内存中的模拟音频后端，不依赖任何平台接口，用于在其他平台上测试和测量 VolumeLock
+// 设备和会话的增删、音量变化都由调用方按脚本触发，通知在触发的线程上同步发出，
+// 与 Core Audio 在系统线程上回调的方式一致，相同的脚本总是产生相同的事件序列
+
+class SimAudioSession;
+class SimAudioDevice;
+
+struct SimLatency
+{
+	// 模拟跨进程读写音量的耗时
+	std::chrono::microseconds GetVolume{ 0 };
+	std::chrono::microseconds SetVolume{ 0 };
+	// 事件发生到发出通知的延迟
+	std::chrono::microseconds Notify{ 0 };
+};
+
+// 所有模拟对象共享的设置，需要在开始运行前设置好
+struct SimContext
+{
+	SimLatency Latency;
+	// 本程序每次调用 SetVolume 后回调，可用于测量从事件到纠正的延迟
+	std::function<void(const std::shared_ptr<SimAudioSession>& session, int volume)> OnWrite;
+};
+
+class SimAudioSession : public AudioSession, public std::enable_shared_from_this<SimAudioSession>
+{
+public:
+	SimAudioSession(std::shared_ptr<const SimContext> context, uint32_t pid, const std::filesystem::path& path, int volume, uint64_t startTime = 0);
+
+	virtual const std::wstring& GetDisplayName() override
+	{
+		return m_DisplayName.Get();
+	}
+
+	virtual uint32_t GetProcessId() override
+	{
+		return m_ProcessInfo->Pid;
+	}
+
+	virtual const std::shared_ptr<const ProcessInfo>& GetProcessInfo() override
+	{
+		return m_ProcessInfo;
+	}
+
+	virtual void SetVolume(int v) override;
+
+	virtual int GetVolume() override;
+
+	virtual void RegisterNotification(AudioSessionEvents* cb) override;
+
+	virtual void UnregisterNotification(AudioSessionEvents* cb) override;
+
+	// 模拟其他程序修改音量，会通知所有监听者
+	void ChangeVolume(int v);
+
+	// 本程序调用 SetVolume 的次数
+	uint64_t GetWriteCount();
+
+	// 模拟会话对象失效（例如设备驱动重置），之后读写音量都会抛出异常
+	void Expire();
+
+private:
+	// 调用时需要持有 m_mutex
+	void ThrowIfExpired();
+
+	std::shared_ptr<const SimContext> m_context;
+
+	InternedString m_DisplayName;
+	std::shared_ptr<const ProcessInfo> m_ProcessInfo;
+	int m_volume;
+	uint64_t m_writes = 0;
+	bool m_expired = false;
+
+	ListenerList<AudioSessionEvents> m_callback;
+
+	std::mutex m_mutex;
+};
+
+class SimAudioDevice : public AudioDevice, public std::enable_shared_from_this<SimAudioDevice>
+{
+public:
+	SimAudioDevice(std::shared_ptr<const SimContext> context, const std::wstring& id, const std::wstring& name);
+
+	virtual const std::wstring& GetId() override
+	{
+		return m_Id.Get();
+	}
+
+	// 与 Core Audio 读取属性存储相同，设备异常时抛出异常
+	virtual const std::wstring& GetFriendlyName() override;
+
+	virtual bool IsActive() override;
+
+	virtual std::vector<std::shared_ptr<AudioSession>> GetAllSession() override;
+
+	virtual void RegisterNotification(AudioDeviceEvents* cb) override;
+
+	virtual void UnregisterNotification(AudioDeviceEvents* cb) override;
+
+	// 模拟进程开始播放，创建新的会话。startTime 用于模拟 pid 复用
+	std::shared_ptr<SimAudioSession> AddSession(uint32_t pid, const std::filesystem::path& path, int volume = 100, uint64_t startTime = 0);
+
+	// 模拟会话断开，进程退出时 reason 为 SessionExpiredReason
+	void RemoveSession(const std::shared_ptr<SimAudioSession>& session, int reason = SessionExpiredReason);
+
+	// 模拟驱动异常，之后查询名称、状态和会话都会抛出异常
+	void Fail();
+
+	// 模拟属性存储无法读取（例如设备正在移除），之后查询名称会抛出异常，状态和会话不受影响
+	void FailProperties();
+
+private:
+	friend class SimAudioDeviceEnumerator;
+
+	// 调用时需要持有 m_mutex
+	void ThrowIfFailed();
+
+	std::shared_ptr<const SimContext> m_context;
+
+	InternedString m_Id;
+	InternedString m_FriendlyName;
+	DeviceState m_state = DeviceState::Active;
+	bool m_failed = false;
+	bool m_propertiesFailed = false;
+
+	std::set<std::shared_ptr<SimAudioSession>> m_sessions;
+	ListenerList<AudioDeviceEvents> m_callback;
+
+	std::mutex m_mutex;
+};
+
+class SimAudioDeviceEnumerator : public AudioDeviceEnumerator
+{
+public:
+	explicit SimAudioDeviceEnumerator(SimContext context = {});
+
+	virtual std::shared_ptr<AudioDevice> GetDefaultDevice() override;
+
+	virtual std::vector<std::shared_ptr<AudioDevice>> GetActiveDevices() override;
+
+	virtual void RegisterNotification(AudioDeviceEnumeratorEvents* cb) override;
+
+	virtual void UnregisterNotification(AudioDeviceEnumeratorEvents* cb) override;
+
+	// 第一个添加的设备成为默认设备
+	std::shared_ptr<SimAudioDevice> AddDevice(const std::wstring& id, const std::wstring& name);
+
+	void RemoveDevice(const std::shared_ptr<SimAudioDevice>& device);
+
+	void SetDeviceState(const std::shared_ptr<SimAudioDevice>& device, DeviceState state);
+
+	void SetDefaultDevice(const std::shared_ptr<SimAudioDevice>& device);
+
+	std::optional<std::shared_ptr<SimAudioDevice>> GetDeviceById(const std::wstring& id);
+
+private:
+	std::shared_ptr<const SimContext> m_context;
+
+	std::map<std::wstring, std::shared_ptr<SimAudioDevice>> m_devices;
+	std::shared_ptr<SimAudioDevice> m_default;
+	ListenerList<AudioDeviceEnumeratorEvents> m_callback;
+
+	std::mutex m_mutex;
+};
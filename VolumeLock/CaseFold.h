@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// 路径比较用的大小写折叠：逐个字符映射为小写，结果长度与输入相同
+// ASCII 部分按向量批量处理，其余字符查 Unicode 基本多文种平面的小写映射表
+// 只做一对一映射，不处理 İ 这类映射到多个字符的情况，与 Windows 文件名比较的行为一致
+
+wchar_t FoldCase(wchar_t c);
+
+// 结果写入 out，out 的容量足够时不分配内存
+void FoldCase(std::wstring_view s, std::wstring& out);
+
+std::wstring FoldCase(std::wstring_view s);
+
+// 折叠后的字符串及其哈希值，构造时计算一次，之后比较先比哈希
+struct FoldedKey
+{
+	std::wstring Text;
+	size_t Hash = 0;
+
+	FoldedKey() = default;
+
+	explicit FoldedKey(std::wstring_view s)
+	{
+		Assign(s);
+	}
+
+	void Assign(std::wstring_view s);
+
+	bool operator==(const FoldedKey& other) const
+	{
+		return Hash == other.Hash && Text == other.Text;
+	}
+
+	bool operator!=(const FoldedKey& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+// 直接使用预先计算的哈希值，查找时不需要再遍历字符串
+struct FoldedKeyHash
+{
+	size_t operator()(const FoldedKey& key) const
+	{
+		return key.Hash;
+	}
+};
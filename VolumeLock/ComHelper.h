@@ -83,5 +83,29 @@ private:
     PROPVARIANT m_data;
 };
 
+// 在当前线程初始化 COM（多线程单元），析构时释放
+class ComInitializer
+{
+public:
+    ComInitializer()
+    {
+        m_hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    }
+
+    ~ComInitializer()
+    {
+        if (SUCCEEDED(m_hr))
+        {
+            CoUninitialize();
+        }
+    }
+
+    ComInitializer(const ComInitializer&) = delete;
+    ComInitializer& operator=(const ComInitializer&) = delete;
+
+private:
+    HRESULT m_hr;
+};
+
 #define ThrowIfError(hr) \
     if (FAILED(hr)) { printf("hr = %x\n", hr); throw std::runtime_error(""); }
\ No newline at end of file
@@ -0,0 +1,93 @@
+﻿#include "Config.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <yaml-cpp/yaml.h>
+
+#include "RuleSnapshot.h"
+#include "Utf8.h"
+#include "StringHelper.h"
+
+using namespace std;
+
+namespace YAML {
+    template<>
+    struct convert<wstring> {
+        static bool decode(const Node& node, wstring& rhs) {
+            try
+            {
+                rhs = Utf8ToWide(node.as<string>());
+            }
+            catch (const Utf8Error& e)
+            {
+                // 带上所在的行列，便于定位
+                throw ParserException(node.Mark(), e.what());
+            }
+            return true;
+        }
+    };
+
+    template<>
+    struct convert<ConfigItem> {
+        static bool decode(const Node& node, ConfigItem& rhs) {
+            auto type = ToLower_Copy(node["type"].as<string>());
+            if (type == "fullpath")
+            {
+                rhs.Type = ConfigItem::PathType::FullPath;
+            }
+            else if (type == "filename")
+            {
+                rhs.Type = ConfigItem::PathType::FileName;
+            }
+            else if (type == "regex")
+            {
+                rhs.Type = ConfigItem::PathType::Regex;
+            }
+            else if (type == "prefix")
+            {
+                rhs.Type = ConfigItem::PathType::Prefix;
+            }
+            else if (type == "glob")
+            {
+                rhs.Type = ConfigItem::PathType::Glob;
+            }
+            else
+            {
+                return false;
+            }
+            rhs.Path = node["path"].as<wstring>();
+            rhs.Volume = node["volume"].as<int>();
+            return true;
+        }
+    };
+}
+
+vector<ConfigItem> LoadConfig(const filesystem::path& configpath)
+{
+    ifstream in(configpath, ios::binary);
+    if (!in)
+    {
+        throw runtime_error("无法打开配置文件");
+    }
+    string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    auto hash = HashBytes(content.data(), content.size());
+
+    auto snapshotpath = configpath;
+    snapshotpath += L".cache";
+    auto snapshot = LoadRuleSnapshot(snapshotpath, hash);
+    if (snapshot.has_value())
+    {
+        return std::move(snapshot.value());
+    }
+
+    auto config = YAML::Load(content);
+    vector<ConfigItem> configs;
+    for (size_t i = 0; i < config.size(); i++)
+    {
+        configs.emplace_back(config[i].as<ConfigItem>());
+    }
+    SaveRuleSnapshot(snapshotpath, hash, configs);
+    return configs;
+}
@@ -0,0 +1,11 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "RuleIndex.h"
+
+// 加载失败时抛出异常
+// 配置文件内容未变化时直接读取旁边的二进制快照，跳过 YAML 解析
+std::vector<ConfigItem> LoadConfig(const std::filesystem::path& configpath);
@@ -2,75 +2,127 @@
 
 #include <stdexcept>
 #include <algorithm>
-#include <thread>
+#include <chrono>
 
 #include <Functiondiscoverykeys_devpkey.h>
 
-#pragma region AudioSession
+#include "DeferredReleaser.h"
+#include "WorkerPool.h"
+#include "Log.h"
+#include "SpanTrace.h"
 
-AudioSession::AudioSession(CComPtr<IAudioSessionControl2> s) : session(s), volume(s)
+#pragma region ProcessResolver
+
+class WindowsProcessResolver : public ProcessResolver
+{
+public:
+	virtual std::optional<uint64_t> GetStartTime(uint32_t pid) override
+	{
+		auto hp = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+		if (!hp)
+		{
+			return {};
+		}
+		std::optional<uint64_t> result;
+		FILETIME creation, exit, kernel, user;
+		if (GetProcessTimes(hp, &creation, &exit, &kernel, &user))
+		{
+			result = (static_cast<uint64_t>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime;
+		}
+		CloseHandle(hp);
+		return result;
+	}
+
+	virtual std::optional<std::wstring> GetImagePath(uint32_t pid) override
+	{
+		auto hp = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+		if (!hp)
+		{
+			return {};
+		}
+		std::optional<std::wstring> result;
+		DWORD buflen = 260;
+		std::vector<wchar_t> buf(buflen);
+		if (QueryFullProcessImageName(hp, 0, buf.data(), &buflen))
+		{
+			result = buf.data();
+		}
+		CloseHandle(hp);
+		return result;
+	}
+};
+
+static ProcessInfoCache& GetProcessInfoCache()
+{
+	static ProcessInfoCache cache(std::make_shared<WindowsProcessResolver>());
+	return cache;
+}
+
+#pragma endregion
+
+// 设备预热和会话构造共用的线程池，工作线程在整个进程内只初始化一次 COM
+static WorkerPool& GetWorkerPool()
+{
+	static WorkerPool pool(WorkerPool::DefaultSize(), []() { return std::make_shared<ComInitializer>(); });
+	return pool;
+}
+
+#pragma region CoreAudioSession
+
+// 通过本程序调用 SetMasterVolume 时传入的事件上下文，用于识别并忽略自己引发的通知
+// {BA0A071B-8F86-46D5-9146-3C2F2AE09C48}
+static const GUID VolumeLockEventContext = { 0xba0a071b, 0x8f86, 0x46d5, { 0x91, 0x46, 0x3c, 0x2f, 0x2a, 0xe0, 0x9c, 0x48 } };
+
+CoreAudioSession::CoreAudioSession(CComPtr<IAudioSessionControl2> s) : session(s), volume(s)
 {
 
 	LPWSTR pStr = nullptr;
 	ThrowIfError(session->GetDisplayName(&pStr));
-	m_DisplayName = pStr;
+	m_DisplayName = StringPool::Default().Intern(pStr);
 	CoTaskMemFree(pStr);
 	pStr = nullptr;
 
 	ThrowIfError(session->GetProcessId(&m_ProcessId));
 
 	ThrowIfError(session->GetSessionIdentifier(&pStr));
-	m_Id = pStr;
+	m_Id = StringPool::Default().Intern(pStr);
 	CoTaskMemFree(pStr);
 	pStr = nullptr;
 
 	ThrowIfError(session->GetSessionInstanceIdentifier(&pStr));
-	m_InstanceId = pStr;
+	m_InstanceId = StringPool::Default().Intern(pStr);
 	CoTaskMemFree(pStr);
 	pStr = nullptr;
 
 	ThrowIfError(session->GetIconPath(&pStr));
-	m_IconPath = pStr;
+	m_IconPath = StringPool::Default().Intern(pStr);
 	CoTaskMemFree(pStr);
 	pStr = nullptr;
 
-	if (m_ProcessId)
-	{
-		auto hp = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, m_ProcessId);
-		if (hp)
-		{
-			DWORD buflen = 260;
-			std::vector<wchar_t> buf(buflen);
-			if (QueryFullProcessImageName(hp, 0, buf.data(), &buflen))
-			{
-				m_ProcessPath = buf.data();
-			}
-			CloseHandle(hp);
-		}
-	}
+	m_ProcessInfo = GetProcessInfoCache().Get(m_ProcessId);
 
 	ThrowIfError(session->RegisterAudioSessionNotification(this));
 }
 
-AudioSession::~AudioSession()
+CoreAudioSession::~CoreAudioSession()
 {
 	std::lock_guard lock(m_mutex);
 	volume.Release();
 	session->UnregisterAudioSessionNotification(this);
 	// 在后台线程释放，Windows 系统本身会莫名出现多线程竞争状态，长时间卡死在释放阶段
-	std::thread::thread([](IAudioSessionControl2* session) {
+	DeferredReleaser::Instance().Post([session = session.Detach()]() {
 		session->Release();
-		}, session.Detach()).detach();
+	});
 }
 
-AudioSessionState AudioSession::GetState()
+AudioSessionState CoreAudioSession::GetState()
 {
 	AudioSessionState state;
 	ThrowIfError(session->GetState(&state));
 	return state;
 }
 
-bool AudioSession::IsSystemSoundsSession()
+bool CoreAudioSession::IsSystemSoundsSession()
 {
 	auto hr = session->IsSystemSoundsSession();
 	if (hr == S_OK)
@@ -84,184 +136,198 @@ bool AudioSession::IsSystemSoundsSession()
 	throw new std::runtime_error("");
 }
 
-void AudioSession::SetMute(bool mute)
+void CoreAudioSession::SetMute(bool mute)
 {
 	ThrowIfError(volume->SetMute(mute, nullptr));
 }
 
-bool AudioSession::GetMute()
+bool CoreAudioSession::GetMute()
 {
 	BOOL mute;
 	ThrowIfError(volume->GetMute(&mute));
 	return mute;
 }
 
-void AudioSession::SetVolume(int v)
+void CoreAudioSession::SetVolume(int v)
 {
 	if (v < 0) v = 0;
 	else if (v > 100) v = 100;
-	ThrowIfError(volume->SetMasterVolume(v / 100.0f, nullptr));
+	ThrowIfError(volume->SetMasterVolume(v / 100.0f, &VolumeLockEventContext));
 }
 
-int AudioSession::GetVolume()
+int CoreAudioSession::GetVolume()
 {
 	float v;
 	ThrowIfError(volume->GetMasterVolume(&v));
 	return (int)(v * 100 + 0.5);
 }
 
-void AudioSession::RegisterNotification(AudioSessionEvents* cb)
+void CoreAudioSession::RegisterNotification(AudioSessionEvents* cb)
 {
-	std::lock_guard lock(m_mutex);
-	m_callback.insert(cb);
+	m_callback.Add(cb);
 }
 
-void AudioSession::UnregisterNotification(AudioSessionEvents* cb)
+void CoreAudioSession::UnregisterNotification(AudioSessionEvents* cb)
 {
-	std::lock_guard lock(m_mutex);
-	m_callback.erase(cb);
+	m_callback.Remove(cb);
 }
 
-void AudioSession::RegisterNotification_Inner(AudioSessionEvents_Inner* cb)
+void CoreAudioSession::RegisterNotification_Inner(AudioSessionEvents_Inner* cb)
 {
-	std::lock_guard lock(m_mutex);
-	m_callback_inner.insert(cb);
+	m_callback_inner.Add(cb);
 }
 
-void AudioSession::UnregisterNotification_Inner(AudioSessionEvents_Inner* cb)
+void CoreAudioSession::UnregisterNotification_Inner(AudioSessionEvents_Inner* cb)
 {
-	std::lock_guard lock(m_mutex);
-	m_callback_inner.erase(cb);
+	m_callback_inner.Remove(cb);
 }
 
-void AudioSession::FireVolumeChanged(int volume)
+void CoreAudioSession::FireVolumeChanged(int volume)
 {
-	for (auto&& cb : m_callback)
-	{
-		cb->OnVolumeChanged(shared_from_this(), volume);
-	}
+	m_callback.ForEach([&](auto cb) { cb->OnVolumeChanged(shared_from_this(), volume); });
 }
 
-void AudioSession::FireStateChanged(AudioSessionState state)
+void CoreAudioSession::FireStateChanged(AudioSessionState state)
 {
 	if (state == AudioSessionStateActive || state == AudioSessionStateInactive)
 	{
-		for (auto&& cb : m_callback)
-		{
-			cb->OnStateChanged(shared_from_this(), state == AudioSessionStateActive);
-		}
+		m_callback.ForEach([&](auto cb) { cb->OnStateChanged(shared_from_this(), state == AudioSessionStateActive); });
 	}
 	else
 	{
 		// 以下操作可能导致当前对象被释放，先备份
 		auto self = shared_from_this();
-		std::vector<AudioSessionEvents_Inner*> cb_copy(m_callback_inner.size());
-		std::copy(m_callback_inner.begin(), m_callback_inner.end(), cb_copy.begin());
-		for (auto&& cb : cb_copy)
-		{
-			cb->OnStateChanged(self, state);
-		}
+		m_callback_inner.ForEach([&](auto cb) { cb->OnStateChanged(self, state); });
 	}
 }
 
-void AudioSession::FireSessionDisconnected(AudioSessionDisconnectReason reason)
+void CoreAudioSession::FireSessionDisconnected(AudioSessionDisconnectReason reason)
 {
 	// 以下操作可能导致当前对象被释放，先备份
 	auto self = shared_from_this();
-	std::vector<AudioSessionEvents_Inner*> cb_copy(m_callback_inner.size());
-	std::copy(m_callback_inner.begin(), m_callback_inner.end(), cb_copy.begin());
-	for (auto&& cb : cb_copy)
-	{
-		cb->OnDisconnected(self, reason);
-	}
+	m_callback_inner.ForEach([&](auto cb) { cb->OnDisconnected(self, reason); });
 }
 
-HRESULT __stdcall AudioSession::OnDisplayNameChanged(LPCWSTR NewDisplayName, LPCGUID EventContext)
+HRESULT __stdcall CoreAudioSession::OnDisplayNameChanged(LPCWSTR NewDisplayName, LPCGUID EventContext)
 {
-	m_DisplayName = NewDisplayName;
+	m_DisplayName = StringPool::Default().Intern(NewDisplayName);
 	return S_OK;
 }
 
-HRESULT __stdcall AudioSession::OnIconPathChanged(LPCWSTR NewIconPath, LPCGUID EventContext)
+HRESULT __stdcall CoreAudioSession::OnIconPathChanged(LPCWSTR NewIconPath, LPCGUID EventContext)
 {
-	m_IconPath = NewIconPath;
+	m_IconPath = StringPool::Default().Intern(NewIconPath);
 	return S_OK;
 }
 
-HRESULT __stdcall AudioSession::OnSimpleVolumeChanged(float NewVolume, BOOL NewMute, LPCGUID EventContext)
+HRESULT __stdcall CoreAudioSession::OnSimpleVolumeChanged(float NewVolume, BOOL NewMute, LPCGUID EventContext)
 {
+	TRACE_SPAN("CoreAudio.OnSimpleVolumeChanged");
+	if (EventContext && *EventContext == VolumeLockEventContext)
+	{
+		return S_OK;
+	}
 	FireVolumeChanged((UINT32)(100 * NewVolume + 0.5));
 	return S_OK;
 }
 
-HRESULT __stdcall AudioSession::OnChannelVolumeChanged(DWORD ChannelCount, float NewChannelVolumeArray[], DWORD ChangedChannel, LPCGUID EventContext)
+HRESULT __stdcall CoreAudioSession::OnChannelVolumeChanged(DWORD ChannelCount, float NewChannelVolumeArray[], DWORD ChangedChannel, LPCGUID EventContext)
 {
 	return S_OK;
 }
 
-HRESULT __stdcall AudioSession::OnGroupingParamChanged(LPCGUID NewGroupingParam, LPCGUID EventContext)
+HRESULT __stdcall CoreAudioSession::OnGroupingParamChanged(LPCGUID NewGroupingParam, LPCGUID EventContext)
 {
 	return S_OK;
 }
 
-HRESULT __stdcall AudioSession::OnStateChanged(AudioSessionState NewState)
+HRESULT __stdcall CoreAudioSession::OnStateChanged(AudioSessionState NewState)
 {
+	TRACE_SPAN("CoreAudio.OnStateChanged");
 	FireStateChanged(NewState);
 	return S_OK;
 }
 
-HRESULT __stdcall AudioSession::OnSessionDisconnected(AudioSessionDisconnectReason DisconnectReason)
+HRESULT __stdcall CoreAudioSession::OnSessionDisconnected(AudioSessionDisconnectReason DisconnectReason)
 {
+	TRACE_SPAN("CoreAudio.OnSessionDisconnected");
 	FireSessionDisconnected(DisconnectReason);
 	return S_OK;
 }
 
 #pragma endregion
 
-#pragma region AudioDevice
+#pragma region CoreAudioDevice
 
-AudioDevice::AudioDevice(CComPtr<IMMDevice> mmd) : device(mmd)
+CoreAudioDevice::CoreAudioDevice(CComPtr<IMMDevice> mmd) : device(mmd)
 {
-	ThrowIfError(device->Activate(__uuidof(IAudioSessionManager2), CLSCTX_INPROC_SERVER, NULL, (void**)&manager));
-
-	CComPtr<IPropertyStore> prop;
-	ThrowIfError(device->OpenPropertyStore(STGM_READ, &prop));
-
 	CComHeapPtr<WCHAR> comstr;
 	ThrowIfError(device->GetId(&comstr));
-	m_Id = comstr;
-
-	PropVarStr var;
-	ThrowIfError(prop->GetValue(PKEY_Device_FriendlyName, &var));
-	m_FriendlyName = var;
-
-	var.Clear();
-	ThrowIfError(prop->GetValue(PKEY_Device_DeviceDesc, &var));
-	m_DeviceDesc = var;
-
-	var.Clear();
-	ThrowIfError(prop->GetValue(PKEY_DeviceInterface_FriendlyName, &var));
-	m_InterfaceFriendlyName = var;
+	m_Id = StringPool::Default().Intern(static_cast<LPWSTR>(comstr));
 }
 
-AudioDevice::~AudioDevice()
+CoreAudioDevice::~CoreAudioDevice()
 {
 	std::lock_guard lock(m_mutex);
-	manager->UnregisterSessionNotification(this);
+	if (m_initSessions)
+	{
+		manager->UnregisterSessionNotification(this);
+	}
 	for (auto&& i : m_sessions)
 	{
 		i->UnregisterNotification_Inner(this);
 	}
 }
 
-AudioSessionState AudioDevice::GetState()
+void CoreAudioDevice::Prefetch()
+{
+	LoadProperties();
+	GetManager();
+}
+
+void CoreAudioDevice::LoadProperties()
+{
+	std::call_once(m_propertiesOnce, [this]() {
+		CComPtr<IPropertyStore> prop;
+		ThrowIfError(device->OpenPropertyStore(STGM_READ, &prop));
+
+		PropVarStr var;
+		ThrowIfError(prop->GetValue(PKEY_Device_FriendlyName, &var));
+		m_FriendlyName = StringPool::Default().Intern(static_cast<std::wstring>(var));
+
+		var.Clear();
+		ThrowIfError(prop->GetValue(PKEY_Device_DeviceDesc, &var));
+		m_DeviceDesc = StringPool::Default().Intern(static_cast<std::wstring>(var));
+
+		var.Clear();
+		ThrowIfError(prop->GetValue(PKEY_DeviceInterface_FriendlyName, &var));
+		m_InterfaceFriendlyName = StringPool::Default().Intern(static_cast<std::wstring>(var));
+	});
+}
+
+IAudioSessionManager2* CoreAudioDevice::GetManager()
+{
+	std::call_once(m_managerOnce, [this]() {
+		ThrowIfError(device->Activate(__uuidof(IAudioSessionManager2), CLSCTX_INPROC_SERVER, NULL, (void**)&manager));
+	});
+	return manager;
+}
+
+AudioSessionState CoreAudioDevice::GetState()
 {
 	DWORD state;
 	ThrowIfError(device->GetState(&state));
 	return static_cast<AudioSessionState>(state);
 }
 
-std::vector<std::shared_ptr<AudioSession>> AudioDevice::GetAllSession()
+bool CoreAudioDevice::IsActive()
+{
+	DWORD state;
+	ThrowIfError(device->GetState(&state));
+	return state == DEVICE_STATE_ACTIVE;
+}
+
+std::vector<std::shared_ptr<AudioSession>> CoreAudioDevice::GetAllSession()
 {
 	std::lock_guard lock(m_mutex);
 	InitSessions();
@@ -273,97 +339,104 @@ std::vector<std::shared_ptr<AudioSession>> AudioDevice::GetAllSession()
 	return result;
 }
 
-void AudioDevice::RegisterNotification(AudioDeviceEvents* cb)
+void CoreAudioDevice::RegisterNotification(AudioDeviceEvents* cb)
 {
 	std::lock_guard lock(m_mutex);
 	InitSessions();
-	m_callback.insert(cb);
+	m_callback.Add(cb);
 }
 
-void AudioDevice::UnregisterNotification(AudioDeviceEvents* cb)
+void CoreAudioDevice::UnregisterNotification(AudioDeviceEvents* cb)
 {
-	std::lock_guard lock(m_mutex);
-	m_callback.erase(cb);
+	m_callback.Remove(cb);
 }
 
-void AudioDevice::InitSessions()
+void CoreAudioDevice::InitSessions()
 {
+	TRACE_SPAN("InitSessions");
 	if (m_initSessions)
 	{
 		return;
 	}
+	ThrowIfError(GetManager()->RegisterSessionNotification(this));
 	m_initSessions = true;
 
-	ThrowIfError(manager->RegisterSessionNotification(this));
-
 	CComPtr<IAudioSessionEnumerator> sessionenum;
 	if (SUCCEEDED(manager->GetSessionEnumerator(&sessionenum)))
 	{
 		int sessioncount = 0;
 		ThrowIfError(sessionenum->GetCount(&sessioncount));
+		std::vector<CComPtr<IAudioSessionControl>> controls;
 		for (int i = 0; i < sessioncount; i++)
 		{
+			CComPtr<IAudioSessionControl> session;
+			if (SUCCEEDED(sessionenum->GetSession(i, &session)))
+			{
+				controls.push_back(session);
+			}
+		}
+
+		// 构造会话需要多次跨进程查询，分散到多个线程，全部完成后再统一加入
+		std::vector<std::shared_ptr<CoreAudioSession>> wrappers(controls.size());
+		GetWorkerPool().Run(controls.size(), [&](size_t i) {
+			TRACE_SPAN("CreateSession");
 			try
 			{
-				CComPtr<IAudioSessionControl> session;
-				ThrowIfError(sessionenum->GetSession(i, &session));
-				CComQIPtr<IAudioSessionControl2> session2(session);
-				auto wrapper = std::make_shared<AudioSession>(session2);
-				m_sessions.insert(wrapper);
-				wrapper->RegisterNotification_Inner(this);
+				CComQIPtr<IAudioSessionControl2> session2(controls[i]);
+				wrappers[i] = std::make_shared<CoreAudioSession>(session2);
 			}
 			catch (const std::exception&)
 			{
 				// 任何原因失败都忽略该会话
 			}
+		});
+
+		for (auto&& wrapper : wrappers)
+		{
+			if (wrapper)
+			{
+				m_sessions.insert(wrapper);
+				wrapper->RegisterNotification_Inner(this);
+			}
 		}
 	}
 }
 
-void AudioDevice::FireSessionAdd(std::shared_ptr<AudioSession> session)
+void CoreAudioDevice::FireSessionAdd(std::shared_ptr<CoreAudioSession> session)
 {
-	for (auto&& cb : m_callback)
-	{
-		cb->OnSessionAdded(shared_from_this(), session);
-	}
+	m_callback.ForEach([&](auto cb) { cb->OnSessionAdded(shared_from_this(), session); });
 }
 
-void AudioDevice::FireSessionRemove(std::shared_ptr<AudioSession> session, int reason)
+void CoreAudioDevice::FireSessionRemove(std::shared_ptr<CoreAudioSession> session, int reason)
 {
-	for (auto&& cb : m_callback)
-	{
-		cb->OnSessionRemoved(shared_from_this(), session, reason);
-	}
+	m_callback.ForEach([&](auto cb) { cb->OnSessionRemoved(shared_from_this(), session, reason); });
 }
 
-void AudioDevice::OnStateChanged(std::shared_ptr<AudioSession> session, AudioSessionState state)
+void CoreAudioDevice::OnStateChanged(std::shared_ptr<CoreAudioSession> session, AudioSessionState state)
 {
 	if (state == AudioSessionStateExpired)
 	{
-		OnDisconnected(session, (AudioSessionDisconnectReason)1000);
+		OnDisconnected(session, (AudioSessionDisconnectReason)SessionExpiredReason);
 	}
 }
 
-void AudioDevice::OnDisconnected(std::shared_ptr<AudioSession> session, AudioSessionDisconnectReason reason)
+void CoreAudioDevice::OnDisconnected(std::shared_ptr<CoreAudioSession> session, AudioSessionDisconnectReason reason)
 {
 	std::lock_guard lock(m_mutex);
 	session->UnregisterNotification_Inner(this);
 	// TODO: 猜测 API 内部在一个遍历循环中回调，回调中删除其中的成员会导致崩溃或异常
-	// 暂时解决方案是在后台线程中释放
-	std::thread::thread([](std::shared_ptr<AudioSession> s) {
-		Sleep(1000);
-		s.reset();
-		}, session).detach();
-		m_sessions.erase(session);
-		m_sessions.erase(session);
-		FireSessionRemove(session, reason);
+	// 暂时解决方案是延迟 1 秒后在后台线程中释放
+	DeferredReleaser::Instance().Release(session, std::chrono::seconds(1));
+	m_sessions.erase(session);
+	FireSessionRemove(session, reason);
 }
 
-HRESULT __stdcall AudioDevice::OnSessionCreated(IAudioSessionControl* NewSession)
+HRESULT __stdcall CoreAudioDevice::OnSessionCreated(IAudioSessionControl* NewSession)
 {
+	TRACE_SPAN("CoreAudio.OnSessionCreated");
 	std::lock_guard lock(m_mutex);
 	CComQIPtr<IAudioSessionControl2> session2(NewSession);
-	auto wrapper = std::make_shared<AudioSession>(session2);
+	auto wrapper = std::make_shared<CoreAudioSession>(session2);
 	m_sessions.insert(wrapper);
 	wrapper->RegisterNotification_Inner(this);
 	FireSessionAdd(wrapper);
@@ -372,32 +445,74 @@ HRESULT __stdcall AudioDevice::OnSessionCreated(IAudioSessionControl* NewSession
 
 #pragma endregion
 
-#pragma region AudioDeviceEnumerator
+#pragma region CoreAudioDeviceEnumerator
 
-AudioDeviceEnumerator::AudioDeviceEnumerator()
+CoreAudioDeviceEnumerator::CoreAudioDeviceEnumerator()
 {
 	ThrowIfError(enumerator.CoCreateInstance(__uuidof(MMDeviceEnumerator), NULL, CLSCTX_INPROC_SERVER));
 	ThrowIfError(enumerator->RegisterEndpointNotificationCallback(this));
 
+	auto start = std::chrono::steady_clock::now();
 	CComPtr<IMMDeviceCollection> collection;
 	ThrowIfError(enumerator->EnumAudioEndpoints(eRender, DEVICE_STATEMASK_ALL, &collection));
 	UINT count = 0;
 	ThrowIfError(collection->GetCount(&count));
 	for (UINT i = 0; i < count; i++)
 	{
-		CComPtr<IMMDevice> device;
-		ThrowIfError(collection->Item(i, &device));
-		auto wrapper = std::make_shared<AudioDevice>(device);
-		m_devices[wrapper->GetId()] = wrapper;
+		try
+		{
+			CComPtr<IMMDevice> device;
+			ThrowIfError(collection->Item(i, &device));
+			auto wrapper = std::make_shared<CoreAudioDevice>(device);
+			m_devices[wrapper->GetId()] = wrapper;
+		}
+		catch (const std::exception&)
+		{
+			// 枚举期间被移除的设备，之后如果再出现会收到 OnDeviceAdded
+		}
+	}
+	auto enumerated = std::chrono::steady_clock::now();
+
+	// 设备对象只在使用时才读取属性和激活，这里只为启用的设备并行预热，
+	// 禁用或拔出的设备不产生任何开销
+	std::vector<std::shared_ptr<CoreAudioDevice>> active;
+	for (auto&& [id, device] : m_devices)
+	{
+		try
+		{
+			if (device->IsActive())
+			{
+				active.push_back(device);
+			}
+		}
+		catch (const std::exception&)
+		{
+			// 无法读取状态的设备不预热，与 GetActiveDevices 一样跳过，不影响启动
+		}
 	}
+	GetWorkerPool().Run(active.size(), [&](size_t i) {
+		try
+		{
+			active[i]->Prefetch();
+		}
+		catch (const std::exception&)
+		{
+			// 预热失败不影响使用，第一次访问时会再次尝试
+		}
+	});
+	auto prefetched = std::chrono::steady_clock::now();
+
+	using std::chrono::duration_cast;
+	using std::chrono::milliseconds;
+	Log(L"枚举 ", m_devices.size(), L" 个设备用时 ", duration_cast<milliseconds>(enumerated - start).count(), L" ms，预热 ", active.size(), L" 个启用设备用时 ", duration_cast<milliseconds>(prefetched - enumerated).count(), L" ms");
 }
 
-AudioDeviceEnumerator::~AudioDeviceEnumerator()
+CoreAudioDeviceEnumerator::~CoreAudioDeviceEnumerator()
 {
 	enumerator->UnregisterEndpointNotificationCallback(this);
 }
 
-std::shared_ptr<AudioDevice> AudioDeviceEnumerator::GetDefaultDevice()
+std::shared_ptr<AudioDevice> CoreAudioDeviceEnumerator::GetDefaultDevice()
 {
 	std::lock_guard lock(m_mutex);
 	CComPtr<IMMDevice> device;
@@ -412,19 +527,38 @@ std::shared_ptr<AudioDevice> AudioDeviceEnumerator::GetDefaultDevice()
 	return wrapper.value();
 }
 
-void AudioDeviceEnumerator::RegisterNotification(AudioDeviceEnumeratorEvents* cb)
+std::vector<std::shared_ptr<AudioDevice>> CoreAudioDeviceEnumerator::GetActiveDevices()
 {
 	std::lock_guard lock(m_mutex);
-	m_callback.insert(cb);
+	std::vector<std::shared_ptr<AudioDevice>> result;
+	for (auto&& [id, device] : m_devices)
+	{
+		try
+		{
+			if (device->IsActive())
+			{
+				result.push_back(device);
+			}
+		}
+		catch (const std::exception&)
+		{
+			// 设备可能正在被移除，忽略
+		}
+	}
+	return result;
 }
 
-void AudioDeviceEnumerator::UnregisterNotification(AudioDeviceEnumeratorEvents* cb)
+void CoreAudioDeviceEnumerator::RegisterNotification(AudioDeviceEnumeratorEvents* cb)
 {
-	std::lock_guard lock(m_mutex);
-	m_callback.erase(cb);
+	m_callback.Add(cb);
 }
 
-std::optional<std::shared_ptr<AudioDevice>> AudioDeviceEnumerator::GetDeviceById(const std::wstring& id)
+void CoreAudioDeviceEnumerator::UnregisterNotification(AudioDeviceEnumeratorEvents* cb)
+{
+	m_callback.Remove(cb);
+}
+
+std::optional<std::shared_ptr<CoreAudioDevice>> CoreAudioDeviceEnumerator::GetDeviceById(const std::wstring& id)
 {
 	if (m_devices.find(id) == m_devices.end())
 	{
@@ -433,40 +567,47 @@ std::optional<std::shared_ptr<AudioDevice>> AudioDeviceEnumerator::GetDeviceById
 	return m_devices.at(id);
 }
 
-void AudioDeviceEnumerator::FireDeviceStateChanged(std::shared_ptr<AudioDevice> device, DWORD state)
+void CoreAudioDeviceEnumerator::FireDeviceStateChanged(std::shared_ptr<CoreAudioDevice> device, DWORD state)
 {
-	for (auto&& cb : m_callback)
+	DeviceState newState;
+	switch (state)
 	{
-		cb->OnDeviceStateChanged(device, state);
+	case DEVICE_STATE_ACTIVE:
+		newState = DeviceState::Active;
+		break;
+	case DEVICE_STATE_DISABLED:
+		newState = DeviceState::Disabled;
+		break;
+	case DEVICE_STATE_NOTPRESENT:
+		newState = DeviceState::NotPresent;
+		break;
+	case DEVICE_STATE_UNPLUGGED:
+		newState = DeviceState::Unplugged;
+		break;
+	default:
+		return;
 	}
+	m_callback.ForEach([&](auto cb) { cb->OnDeviceStateChanged(device, newState); });
 }
 
-void AudioDeviceEnumerator::FireDeviceAdded(std::shared_ptr<AudioDevice> device)
+void CoreAudioDeviceEnumerator::FireDeviceAdded(std::shared_ptr<CoreAudioDevice> device)
 {
-	for (auto&& cb : m_callback)
-	{
-		cb->OnDeviceAdded(device);
-	}
+	m_callback.ForEach([&](auto cb) { cb->OnDeviceAdded(device); });
 }
 
-void AudioDeviceEnumerator::FireDeviceRemoved(std::shared_ptr<AudioDevice> device)
+void CoreAudioDeviceEnumerator::FireDeviceRemoved(std::shared_ptr<CoreAudioDevice> device)
 {
-	for (auto&& cb : m_callback)
-	{
-		cb->OnDeviceRemoved(device);
-	}
+	m_callback.ForEach([&](auto cb) { cb->OnDeviceRemoved(device); });
 }
 
-void AudioDeviceEnumerator::FireDefaultDeviceChanged(std::shared_ptr<AudioDevice> device)
+void CoreAudioDeviceEnumerator::FireDefaultDeviceChanged(std::shared_ptr<CoreAudioDevice> device)
 {
-	for (auto&& cb : m_callback)
-	{
-		cb->OnDefaultDeviceChanged(device);
-	}
+	m_callback.ForEach([&](auto cb) { cb->OnDefaultDeviceChanged(device); });
 }
 
-HRESULT __stdcall AudioDeviceEnumerator::OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState)
+HRESULT __stdcall CoreAudioDeviceEnumerator::OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState)
 {
+	TRACE_SPAN("CoreAudio.OnDeviceStateChanged");
 	std::lock_guard lock(m_mutex);
 	auto device = GetDeviceById(pwstrDeviceId);
 	if (device.has_value())
@@ -476,19 +617,28 @@ HRESULT __stdcall AudioDeviceEnumerator::OnDeviceStateChanged(LPCWSTR pwstrDevic
 	return S_OK;
 }
 
-HRESULT __stdcall AudioDeviceEnumerator::OnDeviceAdded(LPCWSTR pwstrDeviceId)
+HRESULT __stdcall CoreAudioDeviceEnumerator::OnDeviceAdded(LPCWSTR pwstrDeviceId)
 {
+	TRACE_SPAN("CoreAudio.OnDeviceAdded");
 	std::lock_guard lock(m_mutex);
 	CComPtr<IMMDevice> device;
 	ThrowIfError(enumerator->GetDevice(pwstrDeviceId, &device));
-	auto wrapper = std::make_shared<AudioDevice>(device);
+	// 只关心输出设备，与构造时枚举的范围一致
+	CComQIPtr<IMMEndpoint> endpoint(device);
+	EDataFlow flow;
+	if (!endpoint || FAILED(endpoint->GetDataFlow(&flow)) || flow != eRender)
+	{
+		return S_OK;
+	}
+	auto wrapper = std::make_shared<CoreAudioDevice>(device);
 	m_devices[wrapper->GetId()] = wrapper;
 	FireDeviceAdded(wrapper);
 	return S_OK;
 }
 
-HRESULT __stdcall AudioDeviceEnumerator::OnDeviceRemoved(LPCWSTR pwstrDeviceId)
+HRESULT __stdcall CoreAudioDeviceEnumerator::OnDeviceRemoved(LPCWSTR pwstrDeviceId)
 {
+	TRACE_SPAN("CoreAudio.OnDeviceRemoved");
 	std::lock_guard lock(m_mutex);
 	auto device = GetDeviceById(pwstrDeviceId);
 	if (device.has_value())
@@ -499,8 +649,9 @@ HRESULT __stdcall AudioDeviceEnumerator::OnDeviceRemoved(LPCWSTR pwstrDeviceId)
 	return S_OK;
 }
 
-HRESULT __stdcall AudioDeviceEnumerator::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDefaultDeviceId)
+HRESULT __stdcall CoreAudioDeviceEnumerator::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDefaultDeviceId)
 {
+	TRACE_SPAN("CoreAudio.OnDefaultDeviceChanged");
 	std::lock_guard lock(m_mutex);
 	if (flow == eRender && role == eConsole)
 	{
@@ -513,7 +664,7 @@ HRESULT __stdcall AudioDeviceEnumerator::OnDefaultDeviceChanged(EDataFlow flow,
 	return S_OK;
 }
 
-HRESULT __stdcall AudioDeviceEnumerator::OnPropertyValueChanged(LPCWSTR pwstrDeviceId, const PROPERTYKEY key)
+HRESULT __stdcall CoreAudioDeviceEnumerator::OnPropertyValueChanged(LPCWSTR pwstrDeviceId, const PROPERTYKEY key)
 {
 	return S_OK;
 }
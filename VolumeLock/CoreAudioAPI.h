@@ -17,75 +17,56 @@
 #include <audiopolicy.h>
 
 #include "ComHelper.h"
+#include "AudioBackend.h"
+#include "ListenerList.h"
+#include "ProcessInfoCache.h"
+#include "StringPool.h"
 
-class AudioSession;
-class AudioDevice;
-
-class AudioSessionEvents
-{
-public:
-	virtual void OnVolumeChanged(std::shared_ptr<AudioSession> session, int volume) {}
-	virtual void OnStateChanged(std::shared_ptr<AudioSession> session, bool active) {}
-};
+class CoreAudioSession;
+class CoreAudioDevice;
 
 class AudioSessionEvents_Inner
 {
 public:
-	virtual void OnStateChanged(std::shared_ptr<AudioSession> session, AudioSessionState state) {}
-	virtual void OnDisconnected(std::shared_ptr<AudioSession> session, AudioSessionDisconnectReason reason) {}
+	virtual void OnStateChanged(std::shared_ptr<CoreAudioSession> session, AudioSessionState state) {}
+	virtual void OnDisconnected(std::shared_ptr<CoreAudioSession> session, AudioSessionDisconnectReason reason) {}
 };
 
-class AudioDeviceEvents
+class CoreAudioSession : public AudioSession, private UnknownImp<IAudioSessionEvents>, public std::enable_shared_from_this<CoreAudioSession>
 {
 public:
-	virtual void OnSessionAdded(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session) {}
-	virtual void OnSessionRemoved(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session, int reason) {}
-};
+	CoreAudioSession(CComPtr<IAudioSessionControl2> s);
 
-class AudioDeviceEnumeratorEvents
-{
-public:
-	virtual void OnDeviceAdded(std::shared_ptr<AudioDevice> device) {}
-	virtual void OnDeviceRemoved(std::shared_ptr<AudioDevice> device) {}
-	virtual void OnDeviceStateChanged(std::shared_ptr<AudioDevice> device, DWORD state) {}
-	virtual void OnDefaultDeviceChanged(std::shared_ptr<AudioDevice> device) {}
-};
+	virtual ~CoreAudioSession();
 
-class AudioSession : private UnknownImp<IAudioSessionEvents>, public std::enable_shared_from_this<AudioSession>
-{
-public:
-	AudioSession(CComPtr<IAudioSessionControl2> s);
-
-	virtual ~AudioSession();
-
-	const std::wstring& GetDisplayName()
+	virtual const std::wstring& GetDisplayName() override
 	{
-		return m_DisplayName;
+		return m_DisplayName.Get();
 	}
 
-	DWORD GetProcessId()
+	virtual uint32_t GetProcessId() override
 	{
 		return m_ProcessId;
 	}
 
 	const std::wstring& GetId()
 	{
-		return m_Id;
+		return m_Id.Get();
 	}
 
 	const std::wstring& GetInstanceId()
 	{
-		return m_InstanceId;
+		return m_InstanceId.Get();
 	}
 
 	const std::wstring& GetIconPath()
 	{
-		return m_IconPath;
+		return m_IconPath.Get();
 	}
 
-	const std::filesystem::path& GetProcessPath()
+	virtual const std::shared_ptr<const ProcessInfo>& GetProcessInfo() override
 	{
-		return m_ProcessPath;
+		return m_ProcessInfo;
 	}
 
 	AudioSessionState GetState();
@@ -96,16 +77,16 @@ public:
 
 	bool GetMute();
 
-	void SetVolume(int v);
+	virtual void SetVolume(int v) override;
 
-	int GetVolume();
+	virtual int GetVolume() override;
 
-	void RegisterNotification(AudioSessionEvents* cb);
+	virtual void RegisterNotification(AudioSessionEvents* cb) override;
 
-	void UnregisterNotification(AudioSessionEvents* cb);
+	virtual void UnregisterNotification(AudioSessionEvents* cb) override;
 
 private:
-	friend class AudioDevice;
+	friend class CoreAudioDevice;
 
 	void RegisterNotification_Inner(AudioSessionEvents_Inner* cb);
 
@@ -139,66 +120,79 @@ private:
 	CComPtr<IAudioSessionControl2> session;
 	CComQIPtr<ISimpleAudioVolume> volume;
 
-	std::wstring m_DisplayName;
+	InternedString m_DisplayName;
 	DWORD m_ProcessId;
-	std::wstring m_Id;
-	std::wstring m_InstanceId;
-	std::wstring m_IconPath;
-	std::filesystem::path m_ProcessPath;
+	InternedString m_Id;
+	InternedString m_InstanceId;
+	InternedString m_IconPath;
+	std::shared_ptr<const ProcessInfo> m_ProcessInfo;
 
-	std::set<AudioSessionEvents*> m_callback;
-	std::set<AudioSessionEvents_Inner*> m_callback_inner;
+	ListenerList<AudioSessionEvents> m_callback;
+	ListenerList<AudioSessionEvents_Inner> m_callback_inner;
 
 	std::mutex m_mutex;
 };
 
-class AudioDevice : private UnknownImp<IAudioSessionNotification>, public std::enable_shared_from_this<AudioDevice>, private AudioSessionEvents_Inner
+class CoreAudioDevice : public AudioDevice, private UnknownImp<IAudioSessionNotification>, public std::enable_shared_from_this<CoreAudioDevice>, private AudioSessionEvents_Inner
 {
 public:
-	AudioDevice(CComPtr<IMMDevice> mmd);
+	CoreAudioDevice(CComPtr<IMMDevice> mmd);
 
-	virtual ~AudioDevice();
+	virtual ~CoreAudioDevice();
 
-	const std::wstring& GetId()
+	virtual const std::wstring& GetId() override
 	{
-		return m_Id;
+		return m_Id.Get();
 	}
 
-	const std::wstring& GetFriendlyName()
+	virtual const std::wstring& GetFriendlyName() override
 	{
-		return m_FriendlyName;
+		LoadProperties();
+		return m_FriendlyName.Get();
 	}
 
 	const std::wstring& GetDeviceDesc()
 	{
-		return m_DeviceDesc;
+		LoadProperties();
+		return m_DeviceDesc.Get();
 	}
 
 	const std::wstring& GetInterfaceFriendlyName()
 	{
-		return m_InterfaceFriendlyName;
+		LoadProperties();
+		return m_InterfaceFriendlyName.Get();
 	}
 
+	// 提前读取属性并激活会话管理器，可在其他线程中调用
+	void Prefetch();
+
 	AudioSessionState GetState();
 
-	std::vector<std::shared_ptr<AudioSession>> GetAllSession();
+	virtual bool IsActive() override;
+
+	virtual std::vector<std::shared_ptr<AudioSession>> GetAllSession() override;
 
-	void RegisterNotification(AudioDeviceEvents* cb);
+	virtual void RegisterNotification(AudioDeviceEvents* cb) override;
 
-	void UnregisterNotification(AudioDeviceEvents* cb);
+	virtual void UnregisterNotification(AudioDeviceEvents* cb) override;
 
 private:
+	// 属性和会话管理器都在第一次使用时才读取
+	void LoadProperties();
+
+	IAudioSessionManager2* GetManager();
+
 	void InitSessions();
 
-	void FireSessionAdd(std::shared_ptr<AudioSession> session);
+	void FireSessionAdd(std::shared_ptr<CoreAudioSession> session);
 
-	void FireSessionRemove(std::shared_ptr<AudioSession> session, int reason);
+	void FireSessionRemove(std::shared_ptr<CoreAudioSession> session, int reason);
 
 #pragma region AudioSessionEvents_Inner
 
-	virtual void OnStateChanged(std::shared_ptr<AudioSession> session, AudioSessionState state) override;
+	virtual void OnStateChanged(std::shared_ptr<CoreAudioSession> session, AudioSessionState state) override;
 
-	virtual void OnDisconnected(std::shared_ptr<AudioSession> session, AudioSessionDisconnectReason reason) override;
+	virtual void OnDisconnected(std::shared_ptr<CoreAudioSession> session, AudioSessionDisconnectReason reason) override;
 
 #pragma endregion
 
@@ -212,41 +206,46 @@ private:
 	CComPtr<IMMDevice> device;
 	CComPtr<IAudioSessionManager2> manager;
 
-	std::wstring m_Id;
-	std::wstring m_FriendlyName;
-	std::wstring m_DeviceDesc;
-	std::wstring m_InterfaceFriendlyName;
+	InternedString m_Id;
+	InternedString m_FriendlyName;
+	InternedString m_DeviceDesc;
+	InternedString m_InterfaceFriendlyName;
 
-	std::set<std::shared_ptr<AudioSession>> m_sessions;
-	std::set<AudioDeviceEvents*> m_callback;
+	std::set<std::shared_ptr<CoreAudioSession>> m_sessions;
+	ListenerList<AudioDeviceEvents> m_callback;
+
+	std::once_flag m_propertiesOnce;
+	std::once_flag m_managerOnce;
 
 	std::mutex m_mutex;
 	bool m_initSessions = false;
 };
 
-class AudioDeviceEnumerator : private UnknownImp<IMMNotificationClient>
+class CoreAudioDeviceEnumerator : public AudioDeviceEnumerator, private UnknownImp<IMMNotificationClient>
 {
 public:
-	AudioDeviceEnumerator();
+	CoreAudioDeviceEnumerator();
+
+	virtual ~CoreAudioDeviceEnumerator();
 
-	virtual ~AudioDeviceEnumerator();
+	virtual std::shared_ptr<AudioDevice> GetDefaultDevice() override;
 
-	std::shared_ptr<AudioDevice> GetDefaultDevice();
+	virtual std::vector<std::shared_ptr<AudioDevice>> GetActiveDevices() override;
 
-	void RegisterNotification(AudioDeviceEnumeratorEvents* cb);
+	virtual void RegisterNotification(AudioDeviceEnumeratorEvents* cb) override;
 
-	void UnregisterNotification(AudioDeviceEnumeratorEvents* cb);
+	virtual void UnregisterNotification(AudioDeviceEnumeratorEvents* cb) override;
 
 private:
-	std::optional<std::shared_ptr<AudioDevice>> GetDeviceById(const std::wstring& id);
+	std::optional<std::shared_ptr<CoreAudioDevice>> GetDeviceById(const std::wstring& id);
 
-	void FireDeviceStateChanged(std::shared_ptr<AudioDevice> device, DWORD state);
+	void FireDeviceStateChanged(std::shared_ptr<CoreAudioDevice> device, DWORD state);
 
-	void FireDeviceAdded(std::shared_ptr<AudioDevice> device);
+	void FireDeviceAdded(std::shared_ptr<CoreAudioDevice> device);
 
-	void FireDeviceRemoved(std::shared_ptr<AudioDevice> device);
+	void FireDeviceRemoved(std::shared_ptr<CoreAudioDevice> device);
 
-	void FireDefaultDeviceChanged(std::shared_ptr<AudioDevice> device);
+	void FireDefaultDeviceChanged(std::shared_ptr<CoreAudioDevice> device);
 
 #pragma region IMMNotificationClient
 
@@ -265,8 +264,8 @@ private:
 private:
 	CComPtr<IMMDeviceEnumerator> enumerator;
 
-	std::map<std::wstring, std::shared_ptr<AudioDevice>> m_devices;
-	std::set<AudioDeviceEnumeratorEvents*> m_callback;
+	std::map<std::wstring, std::shared_ptr<CoreAudioDevice>> m_devices;
+	ListenerList<AudioDeviceEnumeratorEvents> m_callback;
 
 	std::mutex m_mutex;
 };
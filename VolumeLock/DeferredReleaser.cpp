@@ -0,0 +1,125 @@
+﻿#include "DeferredReleaser.h"
+
+#include "Metrics.h"
+
+DeferredReleaser::DeferredReleaser(size_t workers)
+{
+	if (workers == 0)
+	{
+		workers = 1;
+	}
+	for (size_t i = 0; i < workers; i++)
+	{
+		m_workers.emplace_back(&DeferredReleaser::WorkerProc, this);
+	}
+}
+
+DeferredReleaser::~DeferredReleaser()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_cv.notify_all();
+	for (auto&& t : m_workers)
+	{
+		t.join();
+	}
+}
+
+void DeferredReleaser::Post(std::function<void()> task, Clock::duration delay)
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_queue.push(Item{ Clock::now() + delay, m_seq++, std::move(task) });
+	}
+	m_cv.notify_one();
+}
+
+DeferredReleaser::Stats DeferredReleaser::GetStats() const
+{
+	Stats stats;
+	{
+		std::lock_guard lock(m_mutex);
+		stats.QueueDepth = m_queue.size();
+	}
+	stats.Released = m_released;
+	stats.TotalLatency = Clock::duration(m_totalLatency.load());
+	stats.MaxLatency = Clock::duration(m_maxLatency.load());
+	return stats;
+}
+
+void DeferredReleaser::RegisterMetrics(MetricsRegistry& registry)
+{
+	auto& depth = registry.AddGauge("volumelock_deferred_queue_depth", "Deferred releases waiting in the queue.");
+	auto& released = registry.AddCounter("volumelock_deferred_released_total", "Deferred releases executed.");
+	auto& totalLatency = registry.AddCounter("volumelock_deferred_release_latency_microseconds_total", "Total time from due time to completion of deferred releases.");
+	auto& maxLatency = registry.AddGauge("volumelock_deferred_release_latency_max_microseconds", "Longest time from due time to completion of a deferred release.");
+
+	// 计数器只能增加，每次按与上次采样的差值累加；采样在注册表的锁内进行，不会并发
+	registry.AddCollector([this, &depth, &released, &totalLatency, &maxLatency, last = Stats{}]() mutable {
+		auto stats = GetStats();
+		depth.Set(static_cast<int64_t>(stats.QueueDepth));
+		released.Add(stats.Released - last.Released);
+		auto total = std::chrono::duration_cast<std::chrono::microseconds>(stats.TotalLatency).count();
+		auto lastTotal = std::chrono::duration_cast<std::chrono::microseconds>(last.TotalLatency).count();
+		totalLatency.Add(static_cast<uint64_t>(total - lastTotal));
+		maxLatency.Set(std::chrono::duration_cast<std::chrono::microseconds>(stats.MaxLatency).count());
+		last = stats;
+	});
+}
+
+DeferredReleaser& DeferredReleaser::Instance()
+{
+	// 故意不析构：退出时可能仍有工作线程卡在系统的释放调用中，无法等待其结束
+	static auto instance = new DeferredReleaser();
+	return *instance;
+}
+
+void DeferredReleaser::WorkerProc()
+{
+	std::unique_lock lock(m_mutex);
+	for (;;)
+	{
+		if (m_queue.empty())
+		{
+			if (m_stop)
+			{
+				return;
+			}
+			m_cv.wait(lock);
+			continue;
+		}
+		auto due = m_queue.top().Due;
+		if (!m_stop && Clock::now() < due)
+		{
+			m_cv.wait_until(lock, due);
+			continue;
+		}
+
+		// priority_queue::top 只能取 const 引用，任务对象要移出来再执行
+		auto task = std::move(const_cast<Item&>(m_queue.top()).Task);
+		m_queue.pop();
+		lock.unlock();
+
+		try
+		{
+			task();
+		}
+		catch (...)
+		{
+		}
+		// 任务中持有的对象在这里析构，可能再次调用 Post，不能持有锁
+		task = nullptr;
+
+		auto latency = (Clock::now() - due).count();
+		m_released++;
+		m_totalLatency += latency;
+		auto max = m_maxLatency.load();
+		while (latency > max && !m_maxLatency.compare_exchange_weak(max, latency))
+		{
+		}
+
+		lock.lock();
+	}
+}
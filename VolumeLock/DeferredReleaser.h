@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include <functional>
+#include <chrono>
+#include <queue>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+class MetricsRegistry;
+
+// 延迟释放服务，固定数量的工作线程按到期时间执行释放任务，
+// 代替每次释放都新建一个分离线程
+class DeferredReleaser
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Stats
+	{
+		size_t QueueDepth;
+		uint64_t Released;
+		// 从到期到执行完毕的耗时
+		Clock::duration TotalLatency;
+		Clock::duration MaxLatency;
+	};
+
+	explicit DeferredReleaser(size_t workers = 2);
+
+	// 不再等待延迟，立即执行剩余任务后退出
+	~DeferredReleaser();
+
+	DeferredReleaser(const DeferredReleaser&) = delete;
+	DeferredReleaser& operator=(const DeferredReleaser&) = delete;
+
+	void Post(std::function<void()> task, Clock::duration delay = Clock::duration::zero());
+
+	// 延迟丢弃一个引用，最后一个引用在工作线程上释放
+	template <typename T>
+	void Release(std::shared_ptr<T> p, Clock::duration delay = Clock::duration::zero())
+	{
+		Post([p = std::move(p)]() mutable { p.reset(); }, delay);
+	}
+
+	Stats GetStats() const;
+
+	// 把 GetStats 的结果注册为指标，每次导出时采样，当前对象必须比 registry 存活更久
+	void RegisterMetrics(MetricsRegistry& registry);
+
+	static DeferredReleaser& Instance();
+
+private:
+	struct Item
+	{
+		Clock::time_point Due;
+		uint64_t Seq;
+		std::function<void()> Task;
+
+		bool operator>(const Item& other) const
+		{
+			return Due != other.Due ? Due > other.Due : Seq > other.Seq;
+		}
+	};
+
+	void WorkerProc();
+
+	std::priority_queue<Item, std::vector<Item>, std::greater<Item>> m_queue;
+	uint64_t m_seq = 0;
+	bool m_stop = false;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::vector<std::thread> m_workers;
+
+	std::atomic<uint64_t> m_released{ 0 };
+	std::atomic<int64_t> m_totalLatency{ 0 };
+	std::atomic<int64_t> m_maxLatency{ 0 };
+};
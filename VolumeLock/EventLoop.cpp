@@ -0,0 +1,125 @@
+﻿#include "EventLoop.h"
+#include "Log.h"
+
+EventLoop::~EventLoop()
+{
+	Stop();
+}
+
+void EventLoop::Start()
+{
+	if (m_thread.joinable())
+	{
+		return;
+	}
+	m_stop = false;
+	m_thread = std::thread(&EventLoop::Run, this);
+}
+
+void EventLoop::Stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+	m_stop = true;
+	{
+		std::lock_guard lock(m_wakeMutex);
+		m_signaled = true;
+	}
+	m_wakeCv.notify_one();
+	m_thread.join();
+
+	// 循环线程已退出，当前线程成为唯一的消费者
+	while (m_queue.Pop().has_value())
+	{
+	}
+	m_timers = {};
+}
+
+void EventLoop::Post(Task task)
+{
+	m_queue.Push(std::move(task));
+	if (m_sleeping.load())
+	{
+		{
+			std::lock_guard lock(m_wakeMutex);
+			m_signaled = true;
+		}
+		m_wakeCv.notify_one();
+	}
+}
+
+void EventLoop::PostDelayed(Clock::duration delay, Task task)
+{
+	auto due = Clock::now() + delay;
+	Post([this, due, task = std::move(task)]() {
+		m_timers.push(Timer{ due, m_timerSeq++, std::move(task) });
+	});
+}
+
+void EventLoop::Run()
+{
+	while (!m_stop)
+	{
+		while (auto task = m_queue.Pop())
+		{
+			Execute(*task);
+			if (m_stop)
+			{
+				return;
+			}
+		}
+
+		RunDueTimers();
+
+		// 先声明即将等待，再检查一次队列，避免错过生产者的唤醒
+		m_sleeping.store(true);
+		if (!m_queue.IsEmpty())
+		{
+			m_sleeping.store(false);
+			continue;
+		}
+
+		std::unique_lock lock(m_wakeMutex);
+		auto ready = [this] { return m_signaled || m_stop; };
+		if (m_timers.empty())
+		{
+			m_wakeCv.wait(lock, ready);
+		}
+		else
+		{
+			m_wakeCv.wait_until(lock, m_timers.top().Due, ready);
+		}
+		m_signaled = false;
+		m_sleeping.store(false);
+	}
+}
+
+void EventLoop::RunDueTimers()
+{
+	auto now = Clock::now();
+	while (!m_timers.empty() && m_timers.top().Due <= now && !m_stop)
+	{
+		auto task = std::move(const_cast<Timer&>(m_timers.top()).Action);
+		m_timers.pop();
+		Execute(task);
+	}
+}
+
+void EventLoop::Execute(Task& task)
+{
+	// 任务大多会调用后端接口，会话在事件排队期间失效时后端会抛出异常
+	try
+	{
+		task();
+	}
+	catch (const std::exception& e)
+	{
+		LogError(L"处理事件时出错：", e.what());
+	}
+	catch (...)
+	{
+		LogError(L"处理事件时出现未知错误");
+	}
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <queue>
+#include <vector>
+#include <cstdint>
+
+#include "MpscQueue.h"
+
+// 单线程事件循环：任意线程通过无锁队列投递任务，所有任务都在同一个线程上按顺序执行，
+// 任务访问的状态因此不需要加锁
+class EventLoop
+{
+public:
+	using Task = std::function<void()>;
+	using Clock = std::chrono::steady_clock;
+
+	EventLoop() = default;
+
+	~EventLoop();
+
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	void Start();
+
+	// 等待当前任务完成后退出，尚未执行的任务被丢弃
+	void Stop();
+
+	// 可在任意线程调用，不会阻塞
+	void Post(Task task);
+
+	// 可在任意线程调用，到期后在循环线程上执行
+	void PostDelayed(Clock::duration delay, Task task);
+
+	bool IsRunning() const
+	{
+		return m_thread.joinable();
+	}
+
+	bool IsInLoopThread() const
+	{
+		return std::this_thread::get_id() == m_thread.get_id();
+	}
+
+private:
+	struct Timer
+	{
+		Clock::time_point Due;
+		uint64_t Seq;
+		Task Action;
+
+		bool operator>(const Timer& other) const
+		{
+			return Due != other.Due ? Due > other.Due : Seq > other.Seq;
+		}
+	};
+
+	void Run();
+
+	void RunDueTimers();
+
+	// 任务抛出的异常在这里记录后丢弃，一个任务出错不影响循环继续运行
+	static void Execute(Task& task);
+
+	MpscQueue<Task> m_queue;
+
+	// 以下只在循环线程上访问
+	std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+	uint64_t m_timerSeq = 0;
+
+	// 循环线程空闲时在这里等待，生产者只在对方等待时才需要加锁唤醒
+	std::atomic<bool> m_sleeping{ false };
+	std::atomic<bool> m_stop{ false };
+	bool m_signaled = false;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCv;
+
+	std::thread m_thread;
+};
@@ -0,0 +1,227 @@
+﻿#include "EventTrace.h"
+
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+
+#include "RuleSnapshot.h"
+
+namespace
+{
+	constexpr uint32_t kMagic = 0x52544c56; // "VLTR"
+	constexpr uint32_t kVersion = 2;
+
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t CharSize;
+		uint32_t RecordSize;
+		uint32_t InitialCount;
+		uint32_t EventCount;
+		uint32_t ProcessCount;
+		uint32_t Reserved;
+	};
+
+	struct ProcessHeader
+	{
+		uint32_t Pid;
+		uint32_t PathLength;
+		uint64_t StartTime;
+	};
+}
+
+uint64_t HashDeviceId(const std::wstring& id)
+{
+	return HashBytes(id.data(), id.size() * sizeof(wchar_t));
+}
+
+TraceRecorder::TraceRecorder(size_t capacity) : m_start(Clock::now()), m_ring(new Slot[capacity]), m_capacity(capacity)
+{
+}
+
+void TraceRecorder::Record(TraceKind kind, uint32_t pid, uint64_t startTime, uint64_t device, int32_t volume, int32_t reason)
+{
+	auto time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count());
+	auto seq = m_next.fetch_add(1, std::memory_order_relaxed);
+	auto& slot = m_ring[seq % m_capacity];
+	TraceRecord record{ time, kind, pid, startTime, device, volume, reason };
+	uint64_t words[kRecordWords];
+	std::memcpy(words, &record, sizeof(record));
+	slot.Seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t i = 0; i < kRecordWords; i++)
+	{
+		slot.Data[i].store(words[i], std::memory_order_relaxed);
+	}
+	slot.Seq.store(seq + 1, std::memory_order_release);
+}
+
+void TraceRecorder::RecordInitial(TraceKind kind, uint32_t pid, uint64_t startTime, uint64_t device, int32_t volume, int32_t reason)
+{
+	std::lock_guard lock(m_mutex);
+	m_initial.push_back(TraceRecord{ 0, kind, pid, startTime, device, volume, reason });
+}
+
+void TraceRecorder::AddProcess(uint32_t pid, uint64_t startTime, const std::filesystem::path& path)
+{
+	std::lock_guard lock(m_mutex);
+	m_processes[{ pid, startTime }] = path;
+}
+
+uint64_t TraceRecorder::GetDroppedCount() const
+{
+	auto next = m_next.load(std::memory_order_relaxed);
+	return next > m_capacity ? next - m_capacity : 0;
+}
+
+bool TraceRecorder::Save(const std::filesystem::path& path) const
+{
+	// 按序号排好，只取环形缓冲区中最近的 capacity 条
+	std::vector<std::pair<uint64_t, TraceRecord>> events;
+	for (size_t i = 0; i < m_capacity; i++)
+	{
+		auto& slot = m_ring[i];
+		auto seq = slot.Seq.load(std::memory_order_acquire);
+		if (seq == 0)
+		{
+			continue;
+		}
+		uint64_t words[kRecordWords];
+		for (size_t j = 0; j < kRecordWords; j++)
+		{
+			words[j] = slot.Data[j].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.Seq.load(std::memory_order_relaxed) != seq)
+		{
+			continue;
+		}
+		TraceRecord record;
+		std::memcpy(&record, words, sizeof(record));
+		events.emplace_back(seq, record);
+	}
+	std::sort(events.begin(), events.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	std::lock_guard lock(m_mutex);
+	Header header{ kMagic, kVersion, sizeof(wchar_t), sizeof(TraceRecord), static_cast<uint32_t>(m_initial.size()), static_cast<uint32_t>(events.size()), static_cast<uint32_t>(m_processes.size()), 0 };
+
+	// 先写临时文件再替换，保存到一半时退出不会破坏上一次保存的文件
+	auto tmp = path;
+	tmp += L".tmp";
+	std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(m_initial.data()), m_initial.size() * sizeof(TraceRecord));
+	for (auto&& [seq, record] : events)
+	{
+		out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	}
+	for (auto&& [key, process] : m_processes)
+	{
+		auto str = process.wstring();
+		ProcessHeader entry{ key.first, static_cast<uint32_t>(str.size()), key.second };
+		out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+		out.write(reinterpret_cast<const char*>(str.data()), str.size() * sizeof(wchar_t));
+	}
+	out.close();
+	if (!out)
+	{
+		return false;
+	}
+	std::error_code ec;
+	std::filesystem::rename(tmp, path, ec);
+	return !ec;
+}
+
+TraceSaver::TraceSaver(const TraceRecorder& recorder, const std::filesystem::path& path, std::chrono::milliseconds interval)
+	: m_recorder(recorder), m_path(path), m_interval(interval)
+{
+	m_thread = std::thread(&TraceSaver::Run, this);
+}
+
+TraceSaver::~TraceSaver()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_cv.notify_one();
+	m_thread.join();
+}
+
+void TraceSaver::Run()
+{
+	std::unique_lock lock(m_mutex);
+	while (!m_cv.wait_for(lock, m_interval, [this] { return m_stop; }))
+	{
+		lock.unlock();
+		m_recorder.Save(m_path);
+		lock.lock();
+	}
+}
+
+std::optional<Trace> LoadTrace(const std::filesystem::path& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		return {};
+	}
+	std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	Header header;
+	if (buf.size() < sizeof(header))
+	{
+		return {};
+	}
+	std::memcpy(&header, buf.data(), sizeof(header));
+	if (header.Magic != kMagic || header.Version != kVersion || header.CharSize != sizeof(wchar_t) || header.RecordSize != sizeof(TraceRecord))
+	{
+		return {};
+	}
+	size_t pos = sizeof(header);
+	auto readRecords = [&](uint32_t count, std::vector<TraceRecord>& records) {
+		if ((buf.size() - pos) / sizeof(TraceRecord) < count)
+		{
+			return false;
+		}
+		records.resize(count);
+		std::memcpy(records.data(), buf.data() + pos, count * sizeof(TraceRecord));
+		pos += count * sizeof(TraceRecord);
+		return true;
+	};
+
+	Trace trace;
+	if (!readRecords(header.InitialCount, trace.Initial) || !readRecords(header.EventCount, trace.Events))
+	{
+		return {};
+	}
+	for (uint32_t i = 0; i < header.ProcessCount; i++)
+	{
+		ProcessHeader entry;
+		if (buf.size() - pos < sizeof(entry))
+		{
+			return {};
+		}
+		std::memcpy(&entry, buf.data() + pos, sizeof(entry));
+		pos += sizeof(entry);
+		if ((buf.size() - pos) / sizeof(wchar_t) < entry.PathLength)
+		{
+			return {};
+		}
+		std::wstring str(entry.PathLength, L'\0');
+		std::memcpy(str.data(), buf.data() + pos, entry.PathLength * sizeof(wchar_t));
+		pos += entry.PathLength * sizeof(wchar_t);
+		trace.Processes[{ entry.Pid, entry.StartTime }] = str;
+	}
+	if (pos != buf.size())
+	{
+		return {};
+	}
+	return trace;
+}
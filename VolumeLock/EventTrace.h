@@ -0,0 +1,131 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <optional>
+#include <filesystem>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+// 记录后端发给 VolumeLock 的事件，出现问题时可以用 TraceReplay.h 在模拟后端上重现
+
+enum class TraceKind : uint32_t
+{
+	DeviceAdded,
+	DeviceRemoved,
+	// Reason 为 DeviceState
+	DeviceStateChanged,
+	DefaultDeviceChanged,
+	// Volume 为会话的初始音量
+	SessionAdded,
+	SessionRemoved,
+	VolumeChanged
+};
+
+// 固定大小的记录，直接按内存布局写入文件
+struct TraceRecord
+{
+	// 距开始记录的纳秒数，初始状态的记录为 0
+	uint64_t Time;
+	TraceKind Kind;
+	uint32_t Pid;
+	// 进程的启动时间，与 Pid 一起区分被复用的 pid
+	uint64_t StartTime;
+	// 设备 ID 的哈希，音量变化事件为会话所在的设备
+	uint64_t Device;
+	int32_t Volume;
+	int32_t Reason;
+};
+
+// 从文件读出的完整记录
+struct Trace
+{
+	// 开始记录时已经存在的设备和会话
+	std::vector<TraceRecord> Initial;
+	std::vector<TraceRecord> Events;
+	// (pid, 启动时间) => 进程路径，用于重现规则匹配
+	std::map<std::pair<uint32_t, uint64_t>, std::filesystem::path> Processes;
+};
+
+uint64_t HashDeviceId(const std::wstring& id);
+
+// 把事件写入固定容量的环形缓冲区，只保留最近的记录，Save 时才写入文件
+// Record 不加锁，可在多个通知线程中同时调用，也可与 Save 同时进行
+class TraceRecorder
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit TraceRecorder(size_t capacity = 65536);
+
+	TraceRecorder(const TraceRecorder&) = delete;
+	TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+	void Record(TraceKind kind, uint32_t pid, uint64_t startTime, uint64_t device, int32_t volume, int32_t reason);
+
+	// 初始状态单独保存，不会被环形缓冲区覆盖
+	void RecordInitial(TraceKind kind, uint32_t pid, uint64_t startTime, uint64_t device, int32_t volume, int32_t reason);
+
+	void AddProcess(uint32_t pid, uint64_t startTime, const std::filesystem::path& path);
+
+	// 已被覆盖而丢失的记录数
+	uint64_t GetDroppedCount() const;
+
+	// 先写临时文件再替换。与 Record 同时调用时，正在写入的记录不会保存
+	bool Save(const std::filesystem::path& path) const;
+
+private:
+	static constexpr size_t kRecordWords = sizeof(TraceRecord) / sizeof(uint64_t);
+	static_assert(sizeof(TraceRecord) % sizeof(uint64_t) == 0);
+
+	// 按顺序锁的方式读写：写入前把 Seq 置 0，写完再设为序号 + 1，读取前后 Seq 不同则丢弃
+	struct Slot
+	{
+		// 0 表示空或正在写入，否则为序号 + 1
+		std::atomic<uint64_t> Seq{ 0 };
+		std::atomic<uint64_t> Data[kRecordWords] = {};
+	};
+
+	Clock::time_point m_start;
+	std::unique_ptr<Slot[]> m_ring;
+	size_t m_capacity;
+	std::atomic<uint64_t> m_next{ 0 };
+
+	std::vector<TraceRecord> m_initial;
+	std::map<std::pair<uint32_t, uint64_t>, std::filesystem::path> m_processes;
+	mutable std::mutex m_mutex;
+};
+
+// 每隔一段时间把记录保存到文件，进程异常退出时最多丢失一个间隔内的事件
+// 析构时不再保存，正常退出时由调用方在不再产生事件之后调用 Save
+class TraceSaver
+{
+public:
+	TraceSaver(const TraceRecorder& recorder, const std::filesystem::path& path, std::chrono::milliseconds interval);
+
+	~TraceSaver();
+
+	TraceSaver(const TraceSaver&) = delete;
+	TraceSaver& operator=(const TraceSaver&) = delete;
+
+private:
+	void Run();
+
+	const TraceRecorder& m_recorder;
+	std::filesystem::path m_path;
+	std::chrono::milliseconds m_interval;
+
+	bool m_stop = false;
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::thread m_thread;
+};
+
+// 文件不存在或格式错误时返回空
+std::optional<Trace> LoadTrace(const std::filesystem::path& path);
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <unordered_map>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+// 检测与其他程序争夺音量的循环：在 Window 时间内纠正次数达到 Threshold 次即视为争夺，
+// 之后每次纠正前按指数退避等待，直到争夺平息。时间由调用方传入，便于使用模拟时钟
+template <typename Key, typename Clock = std::chrono::steady_clock>
+class FightGovernor
+{
+public:
+    using TimePoint = typename Clock::time_point;
+    using Duration = typename Clock::duration;
+
+    struct Options
+    {
+        size_t Threshold = 5;
+        Duration Window = std::chrono::milliseconds(1000);
+        Duration InitialBackoff = std::chrono::milliseconds(250);
+        Duration MaxBackoff = std::chrono::seconds(30);
+    };
+
+    enum class Verdict
+    {
+        // 允许纠正
+        Allow,
+        // 允许纠正，且刚刚检测到争夺，调用方可记录一次日志
+        AllowFightDetected,
+        // 需要等待 RetryAfter 后再纠正
+        Throttle
+    };
+
+    FightGovernor() : FightGovernor(Options()) {}
+
+    explicit FightGovernor(const Options& options) : m_options(options) {}
+
+    // 纠正前调用，返回 Allow* 时视为已执行一次纠正
+    Verdict Request(const Key& key, TimePoint now, Duration& retryAfter)
+    {
+        auto&& state = m_states[key];
+        if (state.Fighting)
+        {
+            if (now < state.NextAllowed)
+            {
+                retryAfter = state.NextAllowed - now;
+                state.Throttled++;
+                return Verdict::Throttle;
+            }
+            if (now - state.LastCorrection <= state.Backoff + m_options.Window)
+            {
+                // 对方仍在修改，退避时间加倍
+                state.Backoff = std::min(state.Backoff * 2, m_options.MaxBackoff);
+                state.NextAllowed = now + state.Backoff;
+                state.LastCorrection = now;
+                return Verdict::Allow;
+            }
+            // 对方已经停下一段时间，视为争夺结束
+            state.Fighting = false;
+            state.History.clear();
+        }
+
+        while (!state.History.empty() && now - state.History.front() > m_options.Window)
+        {
+            state.History.pop_front();
+        }
+        state.History.push_back(now);
+        state.LastCorrection = now;
+
+        if (state.History.size() >= m_options.Threshold)
+        {
+            state.Fighting = true;
+            state.Fights++;
+            state.Backoff = m_options.InitialBackoff;
+            state.NextAllowed = now + state.Backoff;
+            state.History.clear();
+            return Verdict::AllowFightDetected;
+        }
+        return Verdict::Allow;
+    }
+
+    // 会话结束时调用，释放它的全部状态
+    void Erase(const Key& key)
+    {
+        m_states.erase(key);
+    }
+
+    // 正在跟踪的会话数
+    size_t Size() const
+    {
+        return m_states.size();
+    }
+
+    // 检测到争夺的次数
+    uint64_t GetFightCount(const Key& key) const
+    {
+        auto it = m_states.find(key);
+        return it == m_states.end() ? 0 : it->second.Fights;
+    }
+
+    // 因退避而推迟的纠正次数
+    uint64_t GetThrottledCount(const Key& key) const
+    {
+        auto it = m_states.find(key);
+        return it == m_states.end() ? 0 : it->second.Throttled;
+    }
+
+    bool IsFighting(const Key& key) const
+    {
+        auto it = m_states.find(key);
+        return it != m_states.end() && it->second.Fighting;
+    }
+
+private:
+    struct State
+    {
+        std::deque<TimePoint> History;
+        bool Fighting = false;
+        Duration Backoff{};
+        TimePoint NextAllowed{};
+        TimePoint LastCorrection{};
+        uint64_t Fights = 0;
+        uint64_t Throttled = 0;
+    };
+
+    Options m_options;
+    std::unordered_map<Key, State> m_states;
+};
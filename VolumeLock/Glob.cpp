@@ -0,0 +1,298 @@
+﻿#include "Glob.h"
+#include "CaseFold.h"
+
+#include <algorithm>
+
+namespace
+{
+	bool IsSeparator(wchar_t c)
+	{
+		return c == L'\\' || c == L'/';
+	}
+
+	template<size_t N>
+	void SetBit(std::array<uint64_t, N>& bits, size_t k)
+	{
+		bits[k / 64] |= uint64_t(1) << (k % 64);
+	}
+}
+
+Glob::Glob(std::wstring_view pattern)
+{
+	Parse(pattern);
+	Build();
+}
+
+void Glob::Parse(std::wstring_view pattern)
+{
+	size_t i = 0;
+	while (i < pattern.size())
+	{
+		auto c = pattern[i];
+		if (c == L'*')
+		{
+			size_t stars = 0;
+			while (i < pattern.size() && pattern[i] == L'*')
+			{
+				stars++;
+				i++;
+			}
+			if (stars == 1)
+			{
+				m_tokens.push_back({ Kind::Star });
+			}
+			else if (i < pattern.size() && IsSeparator(pattern[i]))
+			{
+				m_tokens.push_back({ Kind::DirStar });
+				m_tokens.push_back({ Kind::DoubleStar });
+				m_tokens.push_back({ Kind::Separator });
+				i++;
+			}
+			else
+			{
+				m_tokens.push_back({ Kind::DoubleStar });
+			}
+			continue;
+		}
+		if (c == L'[')
+		{
+			i = ParseClass(pattern, i);
+			continue;
+		}
+		if (c == L'?')
+		{
+			m_tokens.push_back({ Kind::Any });
+		}
+		else if (IsSeparator(c))
+		{
+			m_tokens.push_back({ Kind::Separator });
+		}
+		else
+		{
+			m_tokens.push_back({ Kind::Literal, FoldCase(c) });
+		}
+		i++;
+	}
+	if (m_tokens.size() > MaxTokens)
+	{
+		throw GlobError("通配符过长，最多支持 " + std::to_string(MaxTokens) + " 个字符或通配符");
+	}
+}
+
+size_t Glob::ParseClass(std::wstring_view pattern, size_t pos)
+{
+	CharClass cls;
+	auto i = pos + 1;
+	if (i < pattern.size() && (pattern[i] == L'!' || pattern[i] == L'^'))
+	{
+		cls.Negated = true;
+		i++;
+	}
+
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+	// 紧跟在 [ 或取反符号后面的 ] 是普通字符
+	auto first = true;
+	for (;;)
+	{
+		if (i >= pattern.size())
+		{
+			throw GlobError("通配符的字符类缺少 ]，位于第 " + std::to_string(pos + 1) + " 个字符");
+		}
+		auto c = pattern[i];
+		if (c == L']' && !first)
+		{
+			break;
+		}
+		first = false;
+		uint32_t lo = static_cast<uint32_t>(c);
+		uint32_t hi = lo;
+		i++;
+		if (i + 1 < pattern.size() && pattern[i] == L'-' && pattern[i + 1] != L']')
+		{
+			hi = static_cast<uint32_t>(pattern[i + 1]);
+			i += 2;
+			if (hi < lo)
+			{
+				throw GlobError("通配符的字符类范围无效，位于第 " + std::to_string(pos + 1) + " 个字符");
+			}
+		}
+		// 输入已经折叠过大小写，这里把范围内的每个字符也折叠后再保存。基本多文种平面以外的字符没有大小写
+		for (auto x = lo; x <= hi && x <= 0xffff; x++)
+		{
+			auto folded = static_cast<uint32_t>(FoldCase(static_cast<wchar_t>(x)));
+			ranges.emplace_back(folded, folded);
+		}
+		if (hi > 0xffff)
+		{
+			ranges.emplace_back(std::max<uint32_t>(lo, 0x10000), hi);
+		}
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+	for (auto&& [lo, hi] : ranges)
+	{
+		if (!cls.Ranges.empty() && lo <= static_cast<uint32_t>(cls.Ranges.back().second) + 1)
+		{
+			if (hi > static_cast<uint32_t>(cls.Ranges.back().second))
+			{
+				cls.Ranges.back().second = static_cast<wchar_t>(hi);
+			}
+		}
+		else
+		{
+			cls.Ranges.emplace_back(static_cast<wchar_t>(lo), static_cast<wchar_t>(hi));
+		}
+	}
+
+	m_tokens.push_back({ Kind::Class, 0, m_classes.size() });
+	m_classes.push_back(std::move(cls));
+	return i + 1;
+}
+
+void Glob::Build()
+{
+	// 状态 k 表示已经匹配了前 k 个记号，状态 m_tokens.size() 为接受状态
+	m_words = (m_tokens.size() + 1 + 63) / 64;
+	for (size_t k = 0; k < m_tokens.size(); k++)
+	{
+		auto&& token = m_tokens[k];
+		switch (token.Type)
+		{
+		case Kind::Star:
+			SetBit(m_loopOther, k);
+			SetBit(m_skip1, k);
+			break;
+		case Kind::DoubleStar:
+			SetBit(m_loopOther, k);
+			SetBit(m_loopSeparator, k);
+			SetBit(m_skip1, k);
+			break;
+		case Kind::DirStar:
+			// 零级目录时连同分隔符一起跳过。只有进入时能跳，** 消耗过字符后必须再遇到分隔符
+			SetBit(m_skip1, k);
+			SetBit(m_skip3, k);
+			break;
+		default:
+			for (wchar_t c = 0; c < 128; c++)
+			{
+				if (Accepts(token, c))
+				{
+					SetBit(m_ascii[c], k);
+				}
+			}
+			if (token.Type == Kind::Any)
+			{
+				SetBit(m_anyMask, k);
+			}
+			else if (token.Type == Kind::Class || (token.Type == Kind::Literal && static_cast<uint32_t>(token.Char) >= 128))
+			{
+				m_wideTokens.push_back(k);
+			}
+			break;
+		}
+	}
+}
+
+bool Glob::Accepts(const Token& token, wchar_t c) const
+{
+	switch (token.Type)
+	{
+	case Kind::Literal:
+		return c == token.Char;
+	case Kind::Separator:
+		return IsSeparator(c);
+	case Kind::Any:
+		return !IsSeparator(c);
+	case Kind::Class:
+	{
+		if (IsSeparator(c))
+		{
+			return false;
+		}
+		auto&& cls = m_classes[token.Class];
+		auto it = std::upper_bound(cls.Ranges.begin(), cls.Ranges.end(), c, [](wchar_t value, const std::pair<wchar_t, wchar_t>& range) { return value < range.first; });
+		auto found = it != cls.Ranges.begin() && c <= std::prev(it)->second;
+		return found != cls.Negated;
+	}
+	default:
+		return false;
+	}
+}
+
+void Glob::Closure(Bits& bits) const
+{
+	// 空转移只向后跳，连续的星号需要多传播几轮
+	for (;;)
+	{
+		auto changed = false;
+		uint64_t carry1 = 0;
+		uint64_t carry3 = 0;
+		for (size_t w = 0; w < m_words; w++)
+		{
+			auto s1 = bits[w] & m_skip1[w];
+			auto s3 = bits[w] & m_skip3[w];
+			auto add = (s1 << 1) | carry1 | (s3 << 3) | carry3;
+			carry1 = s1 >> 63;
+			carry3 = s3 >> 61;
+			if (add & ~bits[w])
+			{
+				bits[w] |= add;
+				changed = true;
+			}
+		}
+		if (!changed)
+		{
+			return;
+		}
+	}
+}
+
+bool Glob::Match(std::wstring_view foldedPath) const
+{
+	Bits state{};
+	state[0] = 1;
+	Closure(state);
+
+	Bits wide;
+	for (auto c : foldedPath)
+	{
+		const Bits* advance;
+		if (static_cast<uint32_t>(c) < 128)
+		{
+			advance = &m_ascii[c];
+		}
+		else
+		{
+			wide = m_anyMask;
+			for (auto k : m_wideTokens)
+			{
+				if (Accepts(m_tokens[k], c))
+				{
+					SetBit(wide, k);
+				}
+			}
+			advance = &wide;
+		}
+		auto&& loop = IsSeparator(c) ? m_loopSeparator : m_loopOther;
+
+		Bits next{};
+		uint64_t carry = 0;
+		uint64_t alive = 0;
+		for (size_t w = 0; w < m_words; w++)
+		{
+			auto moved = state[w] & (*advance)[w];
+			next[w] = (moved << 1) | carry | (state[w] & loop[w]);
+			carry = moved >> 63;
+			alive |= next[w];
+		}
+		if (!alive)
+		{
+			return false;
+		}
+		Closure(next);
+		state = next;
+	}
+
+	auto accept = m_tokens.size();
+	return (state[accept / 64] >> (accept % 64)) & 1;
+}
@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include <cstdint>
+
+// 通配符模式，加载时编译为按位并行的 NFA，匹配时对输入只扫描一遍，不分配内存
+// 支持的语法：
+//   ?      一个字符，不含路径分隔符
+//   *      任意个字符，不含路径分隔符
+//   **     任意个字符，可以跨越目录；后面紧跟分隔符时（**\）匹配零到多级目录
+//   [abc]  字符类，支持范围 [a-z] 和取反 [!a-z] / [^a-z]，不匹配路径分隔符
+//   \ 和 / 都表示路径分隔符，可以匹配两者中的任意一个
+// 没有转义字符，字面的 [ 写作 [[]。必须匹配整个路径，不区分大小写
+
+class GlobError : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+class Glob
+{
+public:
+	// 状态数上限，超过时构造函数抛出 GlobError
+	static constexpr size_t MaxTokens = 255;
+
+	// 语法错误时抛出 GlobError
+	explicit Glob(std::wstring_view pattern);
+
+	// foldedPath 必须已经折叠过大小写
+	bool Match(std::wstring_view foldedPath) const;
+
+private:
+	static constexpr size_t Words = (MaxTokens + 1 + 63) / 64;
+	using Bits = std::array<uint64_t, Words>;
+
+	enum class Kind : uint8_t
+	{
+		Literal,
+		Separator,
+		Any,
+		Class,
+		// *：在非分隔符上自循环
+		Star,
+		// **：在任意字符上自循环
+		DoubleStar,
+		// **\ 的入口，不消耗字符，后面跟着 DoubleStar 和 Separator，可以直接跳过这两个记号
+		DirStar
+	};
+
+	struct Token
+	{
+		Kind Type;
+		wchar_t Char = 0;
+		size_t Class = 0;
+	};
+
+	struct CharClass
+	{
+		bool Negated = false;
+		// 折叠后的闭区间，已排序并合并
+		std::vector<std::pair<wchar_t, wchar_t>> Ranges;
+	};
+
+	void Parse(std::wstring_view pattern);
+	size_t ParseClass(std::wstring_view pattern, size_t pos);
+	void Build();
+
+	bool Accepts(const Token& token, wchar_t c) const;
+	void Closure(Bits& bits) const;
+
+	std::vector<Token> m_tokens;
+	std::vector<CharClass> m_classes;
+	size_t m_words = 1;
+
+	// ASCII 字符的前进掩码：第 k 位表示第 k 个记号能消耗该字符
+	std::array<Bits, 128> m_ascii{};
+	// 非 ASCII 字符一定被 ? 接受
+	Bits m_anyMask{};
+	// 非 ASCII 字符需要逐个检查的记号
+	std::vector<size_t> m_wideTokens;
+
+	// 自循环：读到分隔符时只有 ** 保持，读到其他字符时所有星号都保持
+	Bits m_loopSeparator{};
+	Bits m_loopOther{};
+
+	// 空转移：第 k 位表示可以从状态 k 跳到 k+1 / k+3
+	Bits m_skip1{};
+	Bits m_skip3{};
+};
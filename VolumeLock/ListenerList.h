@@ -0,0 +1,184 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// 回调列表，注册和注销时复制出新的不可变快照并原子地替换
+// 分发时只需原子地取得当前快照，然后遍历连续的数组，不加锁也不分配内存
+// 分发期间注册或注销的回调不影响本次分发。注销会等待取得旧快照的分发结束后才返回，
+// 返回后即可释放回调对象；在本列表的回调中注销时不等待（否则等待的就是自己），
+// 此时其他线程上正在进行的分发仍可能调用到它
+template <typename T>
+class ListenerList
+{
+public:
+    ListenerList()
+    {
+        m_snapshots.push_back(std::make_unique<const std::vector<T*>>());
+        m_current.store(m_snapshots.back().get());
+    }
+
+    ListenerList(const ListenerList&) = delete;
+    ListenerList& operator=(const ListenerList&) = delete;
+
+    // 已存在时返回 false
+    bool Add(T* listener)
+    {
+        std::lock_guard lock(m_writeMutex);
+        auto current = m_current.load();
+        if (std::find(current->begin(), current->end(), listener) != current->end())
+        {
+            return false;
+        }
+        std::vector<T*> next;
+        next.reserve(current->size() + 1);
+        next.assign(current->begin(), current->end());
+        next.push_back(listener);
+        Publish(std::move(next));
+        return true;
+    }
+
+    // 不存在时返回 false。返回前等待正在进行的分发结束，只在回调中调用时例外
+    bool Remove(T* listener)
+    {
+        {
+            std::lock_guard lock(m_writeMutex);
+            auto current = m_current.load();
+            auto it = std::find(current->begin(), current->end(), listener);
+            if (it == current->end())
+            {
+                return false;
+            }
+            std::vector<T*> next;
+            next.reserve(current->size() - 1);
+            next.insert(next.end(), current->begin(), it);
+            next.insert(next.end(), it + 1, current->end());
+            Publish(std::move(next));
+        }
+        if (!IsDispatching())
+        {
+            WaitForReaders();
+        }
+        return true;
+    }
+
+    // 对当前快照中的每个回调调用 f，回调中可以安全地注册或注销
+    template <typename F>
+    void ForEach(F&& f) const
+    {
+        // 先登记读者再读取快照，登记在新纪元中的读者一定读到写者发布的新快照
+        ReaderGuard guard(*this);
+        auto snapshot = m_current.load();
+        for (auto listener : *snapshot)
+        {
+            f(listener);
+        }
+    }
+
+private:
+    // 读者按纪元计数。写者切换纪元后只等待旧纪元的读者，持续不断的新分发不会让写者一直等下去
+    // 回调抛出异常时也要注销读者，否则写者会一直等待
+    struct ReaderGuard
+    {
+        explicit ReaderGuard(const ListenerList& list) : List(list), Prev(s_dispatching)
+        {
+            while (true)
+            {
+                auto epoch = List.m_epoch.load();
+                List.m_readers[epoch].fetch_add(1);
+                // 登记期间写者切换了纪元，需要登记到新纪元，否则写者可能看不到这个读者
+                if (List.m_epoch.load() == epoch)
+                {
+                    Epoch = epoch;
+                    break;
+                }
+                List.m_readers[epoch].fetch_sub(1);
+            }
+            s_dispatching = this;
+        }
+
+        ~ReaderGuard()
+        {
+            s_dispatching = Prev;
+            List.m_readers[Epoch].fetch_sub(1);
+        }
+
+        const ListenerList& List;
+        const ReaderGuard* Prev;
+        size_t Epoch = 0;
+    };
+
+    // 当前线程是否正在分发本列表（可能嵌套在其他列表的分发中）
+    bool IsDispatching() const
+    {
+        for (auto guard = s_dispatching; guard; guard = guard->Prev)
+        {
+            if (&guard->List == this)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 调用者持有 m_writeMutex
+    void Publish(std::vector<T*>&& next)
+    {
+        m_snapshots.push_back(std::make_unique<const std::vector<T*>>(std::move(next)));
+        m_published++;
+        m_current.store(m_snapshots.back().get());
+        // 没有正在分发的读者时释放旧快照，否则留到以后的写入或析构时再释放
+        if (m_readers[0].load() == 0 && m_readers[1].load() == 0)
+        {
+            m_snapshots.erase(m_snapshots.begin(), m_snapshots.end() - 1);
+        }
+    }
+
+    // 调用者不持有 m_writeMutex，且不在本列表的分发中。等待期间其他线程的回调仍可以注册和注销
+    // 切换纪元后，所有可能持有旧快照的读者都登记在旧纪元，等它们结束后旧快照不再被使用
+    void WaitForReaders()
+    {
+        std::lock_guard wait(m_waitMutex);
+        size_t old;
+        uint64_t keep;
+        {
+            std::lock_guard lock(m_writeMutex);
+            keep = m_published - 1;
+            old = m_epoch.load();
+            m_epoch.store(1 - old);
+        }
+        while (m_readers[old].load() != 0)
+        {
+            std::this_thread::yield();
+        }
+
+        // 切换纪元时已经替换下来的快照都可以释放，期间其他写者可能已经释放了一部分
+        std::lock_guard lock(m_writeMutex);
+        auto first = m_published - m_snapshots.size();
+        if (keep > first)
+        {
+            m_snapshots.erase(m_snapshots.begin(), m_snapshots.begin() + static_cast<ptrdiff_t>(keep - first));
+        }
+    }
+
+    // 当前线程上正在进行的分发，按嵌套顺序链接
+    static inline thread_local const ReaderGuard* s_dispatching = nullptr;
+
+    std::atomic<const std::vector<T*>*> m_current{ nullptr };
+    std::atomic<size_t> m_epoch{ 0 };
+    mutable std::atomic<size_t> m_readers[2]{};
+    // 最后一个是当前快照，其余是等待释放的旧快照
+    std::vector<std::unique_ptr<const std::vector<T*>>> m_snapshots;
+    // 发布过的快照总数，第一个快照由构造函数发布，m_snapshots 中的快照按发布顺序排列
+    uint64_t m_published = 1;
+    // 只用于串行化写者，读者不需要
+    std::mutex m_writeMutex;
+    // 串行化等待读者的注销，切换纪元前上一次切换的旧纪元一定已经没有读者
+    std::mutex m_waitMutex;
+};
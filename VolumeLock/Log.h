@@ -1,43 +1,45 @@
 ﻿#pragma once
 
-#include <iostream>
-#include <string>
-#include <chrono>
-#include <ctime>
-#include <iomanip>
+#include "Logger.h"
 
-inline void PrintTime()
-{
-    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    tm t;
-    localtime_s(&t, &now);
-    std::cout << std::put_time(&t, "[%H:%M:%S] ");
-}
+// 低于该级别的日志在编译时直接去掉，例如定义为 0 时保留调试日志
+#ifndef VOLUMELOCK_MIN_LOG_LEVEL
+#define VOLUMELOCK_MIN_LOG_LEVEL 1
+#endif
+
+constexpr LogLevel MinLogLevel = static_cast<LogLevel>(VOLUMELOCK_MIN_LOG_LEVEL);
 
-inline void Log(const std::string& msg)
+// 参数依次拼接成一条消息，支持字符串、整数、浮点数和路径
+// 只把参数复制到日志缓冲区，不会阻塞，输出由后台线程完成
+template <LogLevel Level, typename... Args>
+inline void LogAt(const Args&... args)
 {
-    PrintTime();
-    std::cout << msg << std::endl;
+    if constexpr (Level >= MinLogLevel)
+    {
+        Logger::Instance().Write(Level, args...);
+    }
 }
 
-inline void Log(const std::wstring& msg)
+template <typename... Args>
+inline void LogDebug(const Args&... args)
 {
-    PrintTime();
-    std::wcout << msg << std::endl;
+    LogAt<LogLevel::Debug>(args...);
 }
 
-inline void Log(const char* msg)
+template <typename... Args>
+inline void Log(const Args&... args)
 {
-    Log(std::string(msg));
+    LogAt<LogLevel::Info>(args...);
 }
 
-inline void Log(const wchar_t* msg)
+template <typename... Args>
+inline void LogWarning(const Args&... args)
 {
-    Log(std::wstring(msg));
+    LogAt<LogLevel::Warning>(args...);
 }
 
-template <typename T>
-inline void Log(const T& ss)
+template <typename... Args>
+inline void LogError(const Args&... args)
 {
-    Log(ss.str());
+    LogAt<LogLevel::Error>(args...);
 }
@@ -0,0 +1,294 @@
+﻿#include "Logger.h"
+
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+#include <cstdio>
+
+static tm ToLocalTime(std::chrono::system_clock::time_point time)
+{
+	auto t = std::chrono::system_clock::to_time_t(time);
+	tm result;
+#ifdef _WIN32
+	localtime_s(&result, &t);
+#else
+	localtime_r(&t, &result);
+#endif
+	return result;
+}
+
+static const wchar_t* LevelName(LogLevel level)
+{
+	switch (level)
+	{
+	case LogLevel::Debug:
+		return L"调试";
+	case LogLevel::Info:
+		return L"信息";
+	case LogLevel::Warning:
+		return L"警告";
+	case LogLevel::Error:
+		return L"错误";
+	}
+	return L"";
+}
+
+static void AppendUtf8(std::string& out, const wchar_t* s, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		uint32_t c = static_cast<uint32_t>(s[i]);
+		// wchar_t 为 16 位时需要合并代理对
+		if (c >= 0xd800 && c < 0xdc00 && i + 1 < length && static_cast<uint32_t>(s[i + 1]) >= 0xdc00 && static_cast<uint32_t>(s[i + 1]) < 0xe000)
+		{
+			c = 0x10000 + ((c - 0xd800) << 10) + (static_cast<uint32_t>(s[++i]) - 0xdc00);
+		}
+		if (c < 0x80)
+		{
+			out += static_cast<char>(c);
+		}
+		else if (c < 0x800)
+		{
+			out += static_cast<char>(0xc0 | (c >> 6));
+			out += static_cast<char>(0x80 | (c & 0x3f));
+		}
+		else if (c < 0x10000)
+		{
+			out += static_cast<char>(0xe0 | (c >> 12));
+			out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (c & 0x3f));
+		}
+		else
+		{
+			out += static_cast<char>(0xf0 | (c >> 18));
+			out += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+			out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (c & 0x3f));
+		}
+	}
+}
+
+Logger& Logger::Instance()
+{
+	// 故意不析构：其他静态对象析构时可能仍在写日志
+	static auto instance = new Logger();
+	return *instance;
+}
+
+Logger::Logger() : m_cells(new Cell[Capacity])
+{
+	for (size_t i = 0; i < Capacity; i++)
+	{
+		m_cells[i].Seq.store(i, std::memory_order_relaxed);
+	}
+	m_thread = std::thread(&Logger::Run, this);
+	m_thread.detach();
+}
+
+Logger::Cell* Logger::Acquire(uint64_t& pos)
+{
+	// 有界 MPMC 队列的入队部分：Seq 等于 pos 表示该格空闲
+	pos = m_enqueuePos.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		auto cell = &m_cells[pos % Capacity];
+		auto seq = cell->Seq.load(std::memory_order_acquire);
+		auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+		if (diff == 0)
+		{
+			if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+			{
+				return cell;
+			}
+		}
+		else if (diff < 0)
+		{
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		else
+		{
+			pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void Logger::Publish(Cell* cell, uint64_t pos)
+{
+	cell->Seq.store(pos + 1, std::memory_order_release);
+	if (m_sleeping.load())
+	{
+		{
+			std::lock_guard lock(m_wakeMutex);
+			m_signaled = true;
+		}
+		m_wakeCv.notify_one();
+	}
+}
+
+void Logger::SetFile(const std::filesystem::path& path, uint64_t maxSize, size_t maxFiles)
+{
+	std::lock_guard lock(m_fileMutex);
+	m_filePath = path;
+	m_maxFileSize = maxSize;
+	m_maxFiles = maxFiles;
+	m_fileChanged = true;
+}
+
+void Logger::Flush()
+{
+	auto target = m_enqueuePos.load();
+	{
+		std::lock_guard lock(m_wakeMutex);
+		m_signaled = true;
+	}
+	m_wakeCv.notify_one();
+	std::unique_lock lock(m_flushMutex);
+	m_flushCv.wait(lock, [&] { return m_written >= target; });
+}
+
+void Logger::Run()
+{
+	for (;;)
+	{
+		{
+			std::lock_guard lock(m_fileMutex);
+			if (m_fileChanged)
+			{
+				m_fileChanged = false;
+				m_activePath = m_filePath;
+				m_activeMaxSize = m_maxFileSize;
+				m_activeMaxFiles = m_maxFiles;
+				m_file.close();
+				m_file.open(m_activePath, std::ios::binary | std::ios::app);
+				std::error_code ec;
+				auto size = std::filesystem::file_size(m_activePath, ec);
+				m_fileSize = ec ? 0 : size;
+			}
+		}
+
+		bool written = false;
+		for (;;)
+		{
+			auto& cell = m_cells[m_dequeuePos % Capacity];
+			if (cell.Seq.load(std::memory_order_acquire) != m_dequeuePos + 1)
+			{
+				break;
+			}
+			Output(cell.Entry);
+			cell.Seq.store(m_dequeuePos + Capacity, std::memory_order_release);
+			m_dequeuePos++;
+			written = true;
+		}
+
+		auto dropped = m_dropped.load(std::memory_order_relaxed);
+		if (dropped != m_reportedDropped)
+		{
+			LogEntry entry;
+			entry.Time = std::chrono::system_clock::now();
+			entry.Level = LogLevel::Warning;
+			entry.Length = 0;
+			entry.Append(L"日志缓冲区已满，丢弃了 ");
+			entry.Append(dropped - m_reportedDropped);
+			entry.Append(L" 条消息");
+			m_reportedDropped = dropped;
+			Output(entry);
+			written = true;
+		}
+
+		if (written)
+		{
+			if (m_console.load(std::memory_order_relaxed))
+			{
+				std::wcout.flush();
+				std::wcerr.flush();
+			}
+			if (m_file.is_open())
+			{
+				m_file.flush();
+			}
+		}
+		{
+			std::lock_guard lock(m_flushMutex);
+			m_written = m_dequeuePos;
+		}
+		m_flushCv.notify_all();
+
+		// 先声明即将等待，再检查一次队列，避免错过生产者的唤醒
+		m_sleeping.store(true);
+		if (m_cells[m_dequeuePos % Capacity].Seq.load(std::memory_order_acquire) == m_dequeuePos + 1)
+		{
+			m_sleeping.store(false);
+			continue;
+		}
+		std::unique_lock lock(m_wakeMutex);
+		m_wakeCv.wait(lock, [this] { return m_signaled; });
+		m_signaled = false;
+		m_sleeping.store(false);
+	}
+}
+
+void Logger::Output(const LogEntry& entry)
+{
+	auto t = ToLocalTime(entry.Time);
+	std::wstring_view text(entry.Text, entry.Length);
+	if (m_console.load(std::memory_order_relaxed))
+	{
+		auto& console = entry.Level >= LogLevel::Warning ? std::wcerr : std::wcout;
+		console << std::put_time(&t, L"[%H:%M:%S] ");
+		if (entry.Level != LogLevel::Info)
+		{
+			console << LevelName(entry.Level) << L"：";
+		}
+		console << text << L'\n';
+	}
+
+	if (m_file.is_open())
+	{
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(entry.Time.time_since_epoch()).count() % 1000;
+		char head[64];
+		auto n = std::strftime(head, sizeof(head), "[%Y-%m-%d %H:%M:%S", &t);
+		std::string line(head, n);
+		char msbuf[8];
+		std::snprintf(msbuf, sizeof(msbuf), ".%03d] ", static_cast<int>(ms));
+		line += msbuf;
+		auto level = LevelName(entry.Level);
+		AppendUtf8(line, level, std::wcslen(level));
+		line += ' ';
+		AppendUtf8(line, entry.Text, entry.Length);
+		line += '\n';
+		WriteFile(line);
+	}
+}
+
+void Logger::WriteFile(const std::string& line)
+{
+	if (m_activeMaxSize > 0 && m_fileSize + line.size() > m_activeMaxSize && m_fileSize > 0)
+	{
+		RotateFile();
+	}
+	m_file.write(line.data(), line.size());
+	m_fileSize += line.size();
+}
+
+void Logger::RotateFile()
+{
+	m_file.close();
+	std::error_code ec;
+	auto backup = [this](size_t i) {
+		auto path = m_activePath;
+		path += L"." + std::to_wstring(i);
+		return path;
+	};
+	if (m_activeMaxFiles > 0)
+	{
+		std::filesystem::remove(backup(m_activeMaxFiles), ec);
+		for (size_t i = m_activeMaxFiles - 1; i >= 1; i--)
+		{
+			std::filesystem::rename(backup(i), backup(i + 1), ec);
+		}
+		std::filesystem::rename(m_activePath, backup(1), ec);
+	}
+	m_file.open(m_activePath, std::ios::binary | std::ios::trunc);
+	m_fileSize = 0;
+}
@@ -0,0 +1,186 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <charconv>
+#include <cstdint>
+#include <cwchar>
+
+#include "Utf8.h"
+
+enum class LogLevel
+{
+	Debug,
+	Info,
+	Warning,
+	Error
+};
+
+// 固定大小的日志条目，生产者直接把参数格式化到这里，不需要分配内存，超长的消息被截断
+struct LogEntry
+{
+	static constexpr size_t MaxLength = 250;
+
+	std::chrono::system_clock::time_point Time;
+	LogLevel Level;
+	uint32_t Length;
+	wchar_t Text[MaxLength];
+
+	void Append(std::wstring_view s)
+	{
+		auto n = std::min(s.size(), MaxLength - Length);
+		std::wmemcpy(Text + Length, s.data(), n);
+		Length += static_cast<uint32_t>(n);
+	}
+
+	// 窄字符串按 UTF-8 解码，本程序和 yaml-cpp 的异常消息都是 UTF-8，无效的字节显示为 U+FFFD
+	void Append(std::string_view s)
+	{
+		Length += static_cast<uint32_t>(DecodeUtf8Lossy(s, Text + Length, MaxLength - Length));
+	}
+
+	template <typename T>
+	void Append(const T& value)
+	{
+		if constexpr (std::is_convertible_v<const T&, std::wstring_view>)
+		{
+			Append(std::wstring_view(value));
+		}
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+		{
+			Append(std::string_view(value));
+		}
+		else if constexpr (std::is_same_v<T, std::filesystem::path>)
+		{
+			Append(value.native());
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			wchar_t buf[32];
+			auto n = std::swprintf(buf, 32, L"%g", static_cast<double>(value));
+			Append(std::wstring_view(buf, n > 0 ? n : 0));
+		}
+		else
+		{
+			static_assert(std::is_integral_v<T>, "不支持的日志参数类型");
+			char buf[24];
+			auto result = std::to_chars(buf, buf + sizeof(buf), value);
+			auto n = std::min(static_cast<size_t>(result.ptr - buf), MaxLength - Length);
+			std::copy(buf, buf + n, Text + Length);
+			Length += static_cast<uint32_t>(n);
+		}
+	}
+};
+
+// 异步日志：生产者把消息写入有界的无锁环形缓冲区，不阻塞也不分配内存，
+// 缓冲区满时丢弃消息并计数；后台线程负责格式化时间、输出到控制台和滚动的日志文件
+class Logger
+{
+public:
+	static Logger& Instance();
+
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	template <typename... Args>
+	void Write(LogLevel level, const Args&... args)
+	{
+		uint64_t pos;
+		auto cell = Acquire(pos);
+		if (!cell)
+		{
+			return;
+		}
+		auto& entry = cell->Entry;
+		entry.Time = std::chrono::system_clock::now();
+		entry.Level = level;
+		entry.Length = 0;
+		(entry.Append(args), ...);
+		Publish(cell, pos);
+	}
+
+	// 同时写入日志文件，文件超过 maxSize 字节时改名为 path.1，最多保留 maxFiles 个旧文件
+	void SetFile(const std::filesystem::path& path, uint64_t maxSize = 1 << 20, size_t maxFiles = 3);
+
+	// 关闭后只写入日志文件，测试和基准程序用它保持标准输出干净
+	void SetConsole(bool enabled)
+	{
+		m_console.store(enabled, std::memory_order_relaxed);
+	}
+
+	// 等待此前写入的消息全部输出
+	void Flush();
+
+	uint64_t GetDroppedCount() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr size_t Capacity = 1024;
+
+	struct Cell
+	{
+		std::atomic<uint64_t> Seq;
+		LogEntry Entry;
+	};
+
+	Logger();
+
+	// 缓冲区满时返回空
+	Cell* Acquire(uint64_t& pos);
+
+	void Publish(Cell* cell, uint64_t pos);
+
+	void Run();
+
+	void Output(const LogEntry& entry);
+
+	void WriteFile(const std::string& line);
+
+	void RotateFile();
+
+	std::unique_ptr<Cell[]> m_cells;
+	std::atomic<uint64_t> m_enqueuePos{ 0 };
+	uint64_t m_dequeuePos = 0;
+	std::atomic<uint64_t> m_dropped{ 0 };
+	uint64_t m_reportedDropped = 0;
+	std::atomic<bool> m_console{ true };
+
+	// 与 EventLoop 相同，后台线程空闲时等待，生产者只在对方等待时才加锁唤醒
+	std::atomic<bool> m_sleeping{ false };
+	bool m_signaled = false;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCv;
+
+	// 已输出的消息数，Flush 在这里等待
+	uint64_t m_written = 0;
+	std::mutex m_flushMutex;
+	std::condition_variable m_flushCv;
+
+	// 日志文件设置，由 SetFile 修改，受 m_fileMutex 保护
+	std::mutex m_fileMutex;
+	std::filesystem::path m_filePath;
+	uint64_t m_maxFileSize = 0;
+	size_t m_maxFiles = 0;
+	bool m_fileChanged = false;
+
+	// 后台线程在 m_fileChanged 时复制的设置和打开的文件，只在后台线程中使用
+	std::filesystem::path m_activePath;
+	uint64_t m_activeMaxSize = 0;
+	size_t m_activeMaxFiles = 0;
+	std::ofstream m_file;
+	uint64_t m_fileSize = 0;
+
+	std::thread m_thread;
+};
@@ -0,0 +1,185 @@
+﻿#include "Metrics.h"
+
+#include <fstream>
+#include <sstream>
+#include <limits>
+
+void CounterFamily::Add(const std::string& value, uint64_t n)
+{
+	std::lock_guard lock(m_mutex);
+	m_values[value] += n;
+}
+
+void CounterFamily::Remove(const std::string& value)
+{
+	std::lock_guard lock(m_mutex);
+	m_values.erase(value);
+}
+
+uint64_t CounterFamily::Get(const std::string& value) const
+{
+	std::lock_guard lock(m_mutex);
+	auto it = m_values.find(value);
+	return it == m_values.end() ? 0 : it->second;
+}
+
+void CounterFamily::Write(std::ostream& out, const std::string& name) const
+{
+	std::lock_guard lock(m_mutex);
+	for (auto&& [value, count] : m_values)
+	{
+		out << name << "{" << m_label << "=\"";
+		// 标签值中的反斜杠、引号和换行需要转义
+		for (auto c : value)
+		{
+			if (c == '\\' || c == '"')
+			{
+				out << '\\' << c;
+			}
+			else if (c == '\n')
+			{
+				out << "\\n";
+			}
+			else
+			{
+				out << c;
+			}
+		}
+		out << "\"} " << count << "\n";
+	}
+}
+
+Counter& MetricsRegistry::AddCounter(const std::string& name, const std::string& help)
+{
+	std::lock_guard lock(m_mutex);
+	m_counters.push_back({ name, help, std::make_unique<Counter>() });
+	return *m_counters.back().Metric;
+}
+
+Gauge& MetricsRegistry::AddGauge(const std::string& name, const std::string& help)
+{
+	std::lock_guard lock(m_mutex);
+	m_gauges.push_back({ name, help, std::make_unique<Gauge>() });
+	return *m_gauges.back().Metric;
+}
+
+Histogram& MetricsRegistry::AddHistogram(const std::string& name, const std::string& help)
+{
+	std::lock_guard lock(m_mutex);
+	m_histograms.push_back({ name, help, std::make_unique<Histogram>() });
+	return *m_histograms.back().Metric;
+}
+
+CounterFamily& MetricsRegistry::AddCounterFamily(const std::string& name, const std::string& help, const std::string& label)
+{
+	std::lock_guard lock(m_mutex);
+	m_families.push_back({ name, help, std::make_unique<CounterFamily>(label) });
+	return *m_families.back().Metric;
+}
+
+void MetricsRegistry::AddCollector(std::function<void()> collect)
+{
+	std::lock_guard lock(m_mutex);
+	m_collectors.push_back(std::move(collect));
+}
+
+void MetricsRegistry::WritePrometheus(std::ostream& out) const
+{
+	std::lock_guard lock(m_mutex);
+	for (auto&& collect : m_collectors)
+	{
+		collect();
+	}
+	for (auto&& i : m_counters)
+	{
+		out << "# HELP " << i.Name << " " << i.Help << "\n";
+		out << "# TYPE " << i.Name << " counter\n";
+		out << i.Name << " " << i.Metric->Get() << "\n";
+	}
+	for (auto&& i : m_families)
+	{
+		out << "# HELP " << i.Name << " " << i.Help << "\n";
+		out << "# TYPE " << i.Name << " counter\n";
+		i.Metric->Write(out, i.Name);
+	}
+	for (auto&& i : m_gauges)
+	{
+		out << "# HELP " << i.Name << " " << i.Help << "\n";
+		out << "# TYPE " << i.Name << " gauge\n";
+		out << i.Name << " " << i.Metric->Get() << "\n";
+	}
+	for (auto&& i : m_histograms)
+	{
+		out << "# HELP " << i.Name << " " << i.Help << "\n";
+		out << "# TYPE " << i.Name << " histogram\n";
+		// Prometheus 的桶是累计的
+		uint64_t count = 0;
+		for (size_t b = 0; b < Histogram::Bounds.size(); b++)
+		{
+			count += i.Metric->GetBucket(b);
+			out << i.Name << "_bucket{le=\"" << std::chrono::duration<double>(Histogram::Bounds[b]).count() << "\"} " << count << "\n";
+		}
+		count += i.Metric->GetBucket(Histogram::Bounds.size());
+		out << i.Name << "_bucket{le=\"+Inf\"} " << count << "\n";
+		// 总和会一直增长，默认的 6 位有效数字很快就不够，保留到纳秒
+		auto precision = out.precision(std::numeric_limits<double>::digits10);
+		out << i.Name << "_sum " << std::chrono::duration<double>(i.Metric->GetSum()).count() << "\n";
+		out.precision(precision);
+		out << i.Name << "_count " << count << "\n";
+	}
+}
+
+MetricsExporter::MetricsExporter(const MetricsRegistry& registry, const std::filesystem::path& path, std::chrono::milliseconds interval)
+	: m_registry(registry), m_path(path), m_interval(interval)
+{
+	m_thread = std::thread(&MetricsExporter::Run, this);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_cv.notify_one();
+	m_thread.join();
+	Export();
+}
+
+bool MetricsExporter::Export()
+{
+	std::ostringstream ss;
+	ss.imbue(std::locale::classic());
+	m_registry.WritePrometheus(ss);
+	auto text = ss.str();
+
+	// 先写临时文件再替换，收集器不会读到写了一半的内容
+	auto tmp = m_path;
+	tmp += L".tmp";
+	{
+		std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			return false;
+		}
+		out.write(text.data(), text.size());
+		if (!out)
+		{
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename(tmp, m_path, ec);
+	return !ec;
+}
+
+void MetricsExporter::Run()
+{
+	std::unique_lock lock(m_mutex);
+	while (!m_cv.wait_for(lock, m_interval, [this] { return m_stop; }))
+	{
+		lock.unlock();
+		Export();
+		lock.lock();
+	}
+}
@@ -0,0 +1,179 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <filesystem>
+#include <ostream>
+#include <cstdint>
+
+// 运行时指标，更新只是一次原子加法，可以一直开启
+// 导出为 Prometheus 文本格式
+
+class Counter
+{
+public:
+	void Add(uint64_t n = 1)
+	{
+		m_value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	uint64_t Get() const
+	{
+		return m_value.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<uint64_t> m_value{ 0 };
+};
+
+class Gauge
+{
+public:
+	void Set(int64_t value)
+	{
+		m_value.store(value, std::memory_order_relaxed);
+	}
+
+	int64_t Get() const
+	{
+		return m_value.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::atomic<int64_t> m_value{ 0 };
+};
+
+// 固定分桶的耗时直方图，桶的上限从 100 微秒到 5 秒
+class Histogram
+{
+public:
+	static constexpr std::array<std::chrono::microseconds, 10> Bounds{ {
+		std::chrono::microseconds(100), std::chrono::microseconds(500),
+		std::chrono::milliseconds(1), std::chrono::milliseconds(5),
+		std::chrono::milliseconds(10), std::chrono::milliseconds(50),
+		std::chrono::milliseconds(100), std::chrono::milliseconds(500),
+		std::chrono::seconds(1), std::chrono::seconds(5)
+	} };
+
+	void Observe(std::chrono::nanoseconds duration)
+	{
+		size_t i = 0;
+		while (i < Bounds.size() && duration > Bounds[i])
+		{
+			i++;
+		}
+		m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+		m_sumNs.fetch_add(static_cast<uint64_t>(duration.count() > 0 ? duration.count() : 0), std::memory_order_relaxed);
+	}
+
+	// 第 i 个桶（不累计）的计数，最后一个为超出所有上限的部分
+	uint64_t GetBucket(size_t i) const
+	{
+		return m_buckets[i].load(std::memory_order_relaxed);
+	}
+
+	std::chrono::nanoseconds GetSum() const
+	{
+		return std::chrono::nanoseconds(m_sumNs.load(std::memory_order_relaxed));
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, Bounds.size() + 1> m_buckets{};
+	std::atomic<uint64_t> m_sumNs{ 0 };
+};
+
+// 按一个标签区分的一组计数器，例如按进程 ID 统计
+// 只适合更新不频繁的统计，每次更新都要加锁查找；标签值由调用方在不再需要时移除，避免序列无限增长
+class CounterFamily
+{
+public:
+	explicit CounterFamily(std::string label) : m_label(std::move(label)) {}
+
+	void Add(const std::string& value, uint64_t n = 1);
+
+	// 移除一个标签值的序列，之后再次 Add 从 0 开始计数
+	void Remove(const std::string& value);
+
+	// 标签值不存在时返回 0
+	uint64_t Get(const std::string& value) const;
+
+	// 写出所有序列，按标签值排序
+	void Write(std::ostream& out, const std::string& name) const;
+
+private:
+	std::string m_label;
+	std::map<std::string, uint64_t> m_values;
+	mutable std::mutex m_mutex;
+};
+
+// 持有所有指标，返回的引用在注册表的生命周期内有效
+// 注册通常在初始化时完成，更新指标不需要经过注册表
+class MetricsRegistry
+{
+public:
+	Counter& AddCounter(const std::string& name, const std::string& help);
+
+	Gauge& AddGauge(const std::string& name, const std::string& help);
+
+	Histogram& AddHistogram(const std::string& name, const std::string& help);
+
+	CounterFamily& AddCounterFamily(const std::string& name, const std::string& help, const std::string& label);
+
+	// 每次导出前依次调用，把其他模块自己维护的统计数据同步到已注册的指标中
+	// 调用时持有注册表的锁，collect 中不能再访问注册表
+	void AddCollector(std::function<void()> collect);
+
+	void WritePrometheus(std::ostream& out) const;
+
+private:
+	template <typename T>
+	struct Entry
+	{
+		std::string Name;
+		std::string Help;
+		std::unique_ptr<T> Metric;
+	};
+
+	std::vector<Entry<Counter>> m_counters;
+	std::vector<Entry<Gauge>> m_gauges;
+	std::vector<Entry<Histogram>> m_histograms;
+	std::vector<Entry<CounterFamily>> m_families;
+	std::vector<std::function<void()>> m_collectors;
+	mutable std::mutex m_mutex;
+};
+
+// 后台线程定期把指标写入文件，可供 node_exporter 的 textfile 收集器读取
+class MetricsExporter
+{
+public:
+	MetricsExporter(const MetricsRegistry& registry, const std::filesystem::path& path, std::chrono::milliseconds interval);
+
+	// 退出前再写一次
+	~MetricsExporter();
+
+	MetricsExporter(const MetricsExporter&) = delete;
+	MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+	bool Export();
+
+private:
+	void Run();
+
+	const MetricsRegistry& m_registry;
+	std::filesystem::path m_path;
+	std::chrono::milliseconds m_interval;
+
+	bool m_stop = false;
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::thread m_thread;
+};
@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// 无锁多生产者单消费者队列（Dmitry Vyukov 的侵入式链表算法）
+// Push 可在任意线程调用，Pop 和 IsEmpty 只能由唯一的消费者线程调用
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+    {
+        auto stub = new Node();
+        m_head.store(stub);
+        m_tail = stub;
+    }
+
+    ~MpscQueue()
+    {
+        while (Pop().has_value())
+        {
+        }
+        delete m_tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void Push(T value)
+    {
+        auto node = new Node();
+        node->Value.emplace(std::move(value));
+        auto prev = m_head.exchange(node);
+        prev->Next.store(node);
+    }
+
+    // 生产者已取得位置但尚未链接时会暂时返回空，稍后可再次读取
+    std::optional<T> Pop()
+    {
+        auto tail = m_tail;
+        auto next = tail->Next.load();
+        if (!next)
+        {
+            return {};
+        }
+        std::optional<T> value(std::move(next->Value));
+        next->Value.reset();
+        m_tail = next;
+        delete tail;
+        return value;
+    }
+
+    bool IsEmpty() const
+    {
+        return m_tail->Next.load() == nullptr;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> Next{ nullptr };
+        std::optional<T> Value;
+    };
+
+    std::atomic<Node*> m_head;
+    Node* m_tail;
+};
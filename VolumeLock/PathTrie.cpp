@@ -0,0 +1,76 @@
+﻿#include "PathTrie.h"
+#include "CaseFold.h"
+
+namespace
+{
+	bool IsSeparator(wchar_t c)
+	{
+		return c == L'\\' || c == L'/';
+	}
+
+	// 从 pos 开始取下一个分量，跳过前面的分隔符，没有更多分量时返回空
+	std::wstring_view NextComponent(std::wstring_view path, size_t& pos)
+	{
+		while (pos < path.size() && IsSeparator(path[pos]))
+		{
+			pos++;
+		}
+		auto start = pos;
+		while (pos < path.size() && !IsSeparator(path[pos]))
+		{
+			pos++;
+		}
+		return path.substr(start, pos - start);
+	}
+}
+
+PathTrie::PathTrie()
+{
+	// 根节点对应空前缀
+	m_nodes.emplace_back();
+}
+
+void PathTrie::Add(std::wstring_view prefix, size_t id)
+{
+	auto folded = FoldCase(prefix);
+	auto node = &m_nodes.front();
+	size_t pos = 0;
+	for (auto component = NextComponent(folded, pos); !component.empty(); component = NextComponent(folded, pos))
+	{
+		auto it = node->Children.find(component);
+		if (it == node->Children.end())
+		{
+			auto& child = m_nodes.emplace_back();
+			child.Component.assign(component);
+			it = node->Children.emplace(child.Component, &child).first;
+		}
+		node = it->second;
+	}
+	if (node->Id == npos)
+	{
+		node->Id = id;
+	}
+	m_count++;
+}
+
+size_t PathTrie::Match(std::wstring_view foldedPath) const
+{
+	auto node = &m_nodes.front();
+	auto best = node->Id;
+	size_t pos = 0;
+	for (auto component = NextComponent(foldedPath, pos); !component.empty(); component = NextComponent(foldedPath, pos))
+	{
+		auto it = node->Children.find(component);
+		if (it == node->Children.end())
+		{
+			break;
+		}
+		node = it->second;
+		// 越深的前缀越长，后找到的覆盖先找到的
+		if (node->Id != npos)
+		{
+			best = node->Id;
+		}
+	}
+	return best;
+}
@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+// 按路径分量组织的前缀树，用于目录前缀匹配
+// 分量以 \ 或 / 分隔，连续的分隔符视为一个，比较前做大小写折叠
+// 查找只沿输入路径向下走一遍，耗时与路径深度有关，与规则数量无关
+class PathTrie
+{
+public:
+	static constexpr size_t npos = SIZE_MAX;
+
+	PathTrie();
+
+	// 同一前缀重复添加时保留最先添加的 id
+	void Add(std::wstring_view prefix, size_t id);
+
+	// foldedPath 必须已经折叠过大小写。返回最长的匹配前缀对应的 id，没有匹配时返回 npos
+	size_t Match(std::wstring_view foldedPath) const;
+
+	bool IsEmpty() const
+	{
+		return m_count == 0;
+	}
+
+private:
+	struct Node
+	{
+		size_t Id = npos;
+		std::wstring Component;
+		// 键指向子节点自身的 Component，节点放在 deque 中，地址不会变化
+		std::unordered_map<std::wstring_view, Node*> Children;
+	};
+
+	std::deque<Node> m_nodes;
+	size_t m_count = 0;
+};
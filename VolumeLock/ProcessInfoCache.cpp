@@ -0,0 +1,75 @@
+﻿#include "ProcessInfoCache.h"
+
+ProcessInfoCache::ProcessInfoCache(std::shared_ptr<ProcessResolver> resolver, size_t capacity) : m_resolver(std::move(resolver)), m_capacity(capacity ? capacity : 1)
+{
+}
+
+std::shared_ptr<const ProcessInfo> ProcessInfoCache::Get(uint32_t pid)
+{
+	if (pid == 0)
+	{
+		return MakeInfo(0, 0, {});
+	}
+
+	auto startTime = m_resolver->GetStartTime(pid);
+	if (!startTime.has_value())
+	{
+		// 进程已不存在，不缓存
+		std::lock_guard lock(m_mutex);
+		m_misses++;
+		return MakeInfo(pid, 0, {});
+	}
+
+	Key key{ pid, startTime.value() };
+	{
+		std::lock_guard lock(m_mutex);
+		auto it = m_index.find(key);
+		if (it != m_index.end())
+		{
+			m_hits++;
+			m_lru.splice(m_lru.begin(), m_lru, it->second);
+			return it->second->second;
+		}
+		m_misses++;
+	}
+
+	// 查询路径较慢，不持有锁；多个线程同时查询同一进程时以先插入的为准
+	auto path = m_resolver->GetImagePath(pid);
+	auto info = MakeInfo(pid, key.StartTime, path.value_or(std::wstring()));
+	if (!path.has_value())
+	{
+		return info;
+	}
+
+	std::lock_guard lock(m_mutex);
+	auto it = m_index.find(key);
+	if (it != m_index.end())
+	{
+		return it->second->second;
+	}
+	m_lru.emplace_front(key, info);
+	m_index.emplace(key, m_lru.begin());
+	if (m_lru.size() > m_capacity)
+	{
+		m_index.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+	return info;
+}
+
+ProcessInfoCache::Stats ProcessInfoCache::GetStats() const
+{
+	std::lock_guard lock(m_mutex);
+	return Stats{ m_hits, m_misses, m_lru.size() };
+}
+
+std::shared_ptr<const ProcessInfo> ProcessInfoCache::MakeInfo(uint32_t pid, uint64_t startTime, const std::filesystem::path& path)
+{
+	auto info = std::make_shared<ProcessInfo>();
+	info->Pid = pid;
+	info->StartTime = startTime;
+	info->Path = path;
+	info->FoldedPath.Assign(path.wstring());
+	info->FoldedFileName.Assign(path.filename().wstring());
+	return info;
+}
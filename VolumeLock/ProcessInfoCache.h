@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <string>
+#include <memory>
+#include <optional>
+#include <filesystem>
+#include <unordered_map>
+#include <list>
+#include <mutex>
+#include <cstdint>
+
+#include "CaseFold.h"
+
+struct ProcessInfo
+{
+	uint32_t Pid = 0;
+	uint64_t StartTime = 0;
+	std::filesystem::path Path;
+
+	// 预先计算好的折叠形式和哈希，供规则匹配使用
+	FoldedKey FoldedPath;
+	FoldedKey FoldedFileName;
+};
+
+// 查询进程信息的平台接口
+class ProcessResolver
+{
+public:
+	virtual ~ProcessResolver() = default;
+
+	// 进程已退出或无权访问时返回空
+	virtual std::optional<uint64_t> GetStartTime(uint32_t pid) = 0;
+
+	virtual std::optional<std::wstring> GetImagePath(uint32_t pid) = 0;
+};
+
+// 以 (pid, 进程启动时间) 为键缓存进程路径，pid 被复用时不会取到旧进程的信息
+// 容量有限，超出后淘汰最久未使用的项。可在多个线程中同时使用
+class ProcessInfoCache
+{
+public:
+	struct Stats
+	{
+		uint64_t Hits;
+		uint64_t Misses;
+		size_t Size;
+	};
+
+	explicit ProcessInfoCache(std::shared_ptr<ProcessResolver> resolver, size_t capacity = 256);
+
+	// 总是返回非空对象，无法查询时路径为空
+	std::shared_ptr<const ProcessInfo> Get(uint32_t pid);
+
+	Stats GetStats() const;
+
+	static std::shared_ptr<const ProcessInfo> MakeInfo(uint32_t pid, uint64_t startTime, const std::filesystem::path& path);
+
+private:
+	struct Key
+	{
+		uint32_t Pid;
+		uint64_t StartTime;
+
+		bool operator==(const Key& other) const
+		{
+			return Pid == other.Pid && StartTime == other.StartTime;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const
+		{
+			return std::hash<uint64_t>()(key.StartTime * 31 + key.Pid);
+		}
+	};
+
+	using Entry = std::pair<Key, std::shared_ptr<const ProcessInfo>>;
+
+	std::shared_ptr<ProcessResolver> m_resolver;
+	size_t m_capacity;
+
+	// 最近使用的在前
+	std::list<Entry> m_lru;
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+	uint64_t m_hits = 0;
+	uint64_t m_misses = 0;
+	mutable std::mutex m_mutex;
+};
@@ -0,0 +1,776 @@
+﻿#include "RegexSet.h"
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+
+namespace
+{
+	// 单个表达式展开后的状态数上限，避免 {n,m} 展开导致状态爆炸
+	constexpr size_t kMaxStatesPerPattern = 4096;
+
+	// DFA 缓存上限，超出后清空重建
+	constexpr size_t kMaxDfaStates = 2048;
+
+	// 表达式使用了不支持的语法
+	struct Unsupported {};
+
+	// \d \w \s 及其取反形式
+	struct NamedClass
+	{
+		enum class Kind
+		{
+			Digit,
+			Word,
+			Space
+		} Type;
+		bool Negate;
+	};
+
+	struct CharClass
+	{
+		bool Negate = false;
+		std::vector<std::pair<wchar_t, wchar_t>> Ranges;
+		std::vector<NamedClass> Named;
+	};
+
+	struct Node
+	{
+		enum class Kind
+		{
+			Empty,
+			Char,
+			Any,
+			Class,
+			Concat,
+			Alt,
+			Repeat
+		} Type;
+		wchar_t Ch = 0;
+		size_t Cls = 0;
+		int Min = 0;
+		int Max = -1;
+		std::vector<Node> Children{};
+	};
+
+	int HexValue(wchar_t c)
+	{
+		if (c >= L'0' && c <= L'9') return c - L'0';
+		if (c >= L'a' && c <= L'f') return c - L'a' + 10;
+		if (c >= L'A' && c <= L'F') return c - L'A' + 10;
+		return -1;
+	}
+
+	bool IsAsciiAlnum(wchar_t c)
+	{
+		return (c >= L'0' && c <= L'9') || (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z');
+	}
+
+	// ECMAScript 语法子集的递归下降解析
+	class Parser
+	{
+	public:
+		Parser(const std::wstring& s, std::vector<CharClass>& classes) : m_s(s), m_classes(classes) {}
+
+		Node Parse()
+		{
+			auto node = ParseAlt();
+			if (m_pos != m_s.size())
+			{
+				throw Unsupported();
+			}
+			return node;
+		}
+
+	private:
+		bool AtEnd() const
+		{
+			return m_pos >= m_s.size();
+		}
+
+		bool Peek(wchar_t c) const
+		{
+			return !AtEnd() && m_s[m_pos] == c;
+		}
+
+		bool Eat(wchar_t c)
+		{
+			if (Peek(c))
+			{
+				m_pos++;
+				return true;
+			}
+			return false;
+		}
+
+		wchar_t Next()
+		{
+			if (AtEnd())
+			{
+				throw Unsupported();
+			}
+			return m_s[m_pos++];
+		}
+
+		Node ParseAlt()
+		{
+			auto first = ParseConcat();
+			if (!Peek(L'|'))
+			{
+				return first;
+			}
+			Node alt{ Node::Kind::Alt };
+			alt.Children.push_back(std::move(first));
+			while (Eat(L'|'))
+			{
+				alt.Children.push_back(ParseConcat());
+			}
+			return alt;
+		}
+
+		Node ParseConcat()
+		{
+			Node concat{ Node::Kind::Concat };
+			while (!AtEnd() && !Peek(L'|') && !Peek(L')'))
+			{
+				concat.Children.push_back(ParseRepeat());
+			}
+			return concat;
+		}
+
+		Node ParseRepeat()
+		{
+			auto atom = ParseAtom();
+			for (;;)
+			{
+				int min = 0, max = -1;
+				if (Eat(L'*'))
+				{
+				}
+				else if (Eat(L'+'))
+				{
+					min = 1;
+				}
+				else if (Eat(L'?'))
+				{
+					max = 1;
+				}
+				else if (Eat(L'{'))
+				{
+					min = ParseNumber();
+					max = min;
+					if (Eat(L','))
+					{
+						max = Peek(L'}') ? -1 : ParseNumber();
+					}
+					if (!Eat(L'}') || (max >= 0 && max < min))
+					{
+						throw Unsupported();
+					}
+				}
+				else
+				{
+					break;
+				}
+				// 非贪婪标记对完整匹配的结果没有影响
+				Eat(L'?');
+				Node repeat{ Node::Kind::Repeat };
+				repeat.Min = min;
+				repeat.Max = max;
+				repeat.Children.push_back(std::move(atom));
+				atom = std::move(repeat);
+			}
+			return atom;
+		}
+
+		int ParseNumber()
+		{
+			int n = 0;
+			size_t digits = 0;
+			while (!AtEnd() && m_s[m_pos] >= L'0' && m_s[m_pos] <= L'9')
+			{
+				n = n * 10 + (m_s[m_pos++] - L'0');
+				if (n > 1000)
+				{
+					throw Unsupported();
+				}
+				digits++;
+			}
+			if (digits == 0)
+			{
+				throw Unsupported();
+			}
+			return n;
+		}
+
+		Node ParseAtom()
+		{
+			auto start = m_pos;
+			auto c = Next();
+			switch (c)
+			{
+			case L'(':
+			{
+				if (Eat(L'?'))
+				{
+					// 只支持 (?:...)，不支持先行断言
+					if (!Eat(L':'))
+					{
+						throw Unsupported();
+					}
+				}
+				auto inner = ParseAlt();
+				if (!Eat(L')'))
+				{
+					throw Unsupported();
+				}
+				return inner;
+			}
+			case L'[':
+				return ParseClass();
+			case L'.':
+				return Node{ Node::Kind::Any };
+			case L'^':
+				// 完整匹配时，开头的 ^ 和结尾的 $ 没有作用
+				if (start != 0)
+				{
+					throw Unsupported();
+				}
+				return Node{ Node::Kind::Empty };
+			case L'$':
+				if (m_pos != m_s.size())
+				{
+					throw Unsupported();
+				}
+				return Node{ Node::Kind::Empty };
+			case L'\\':
+			{
+				wchar_t ch = 0;
+				NamedClass named{};
+				if (ParseEscape(ch, named, false))
+				{
+					return CharNode(ch);
+				}
+				CharClass cls;
+				cls.Named.push_back(named);
+				return ClassNode(std::move(cls));
+			}
+			case L'*':
+			case L'+':
+			case L'?':
+			case L'{':
+				throw Unsupported();
+			default:
+				return CharNode(c);
+			}
+		}
+
+		// 返回 true 表示得到单个字符，false 表示得到 \d \w \s 等字符类
+		bool ParseEscape(wchar_t& ch, NamedClass& named, bool inClass)
+		{
+			auto c = Next();
+			switch (c)
+			{
+			case L'd': named = { NamedClass::Kind::Digit, false }; return false;
+			case L'D': named = { NamedClass::Kind::Digit, true }; return false;
+			case L'w': named = { NamedClass::Kind::Word, false }; return false;
+			case L'W': named = { NamedClass::Kind::Word, true }; return false;
+			case L's': named = { NamedClass::Kind::Space, false }; return false;
+			case L'S': named = { NamedClass::Kind::Space, true }; return false;
+			case L't': ch = L'\t'; return true;
+			case L'n': ch = L'\n'; return true;
+			case L'r': ch = L'\r'; return true;
+			case L'v': ch = L'\v'; return true;
+			case L'f': ch = L'\f'; return true;
+			case L'b':
+				// 字符类中的 \b 是退格，其他位置是单词边界
+				if (!inClass)
+				{
+					throw Unsupported();
+				}
+				ch = L'\b';
+				return true;
+			case L'0':
+				if (!AtEnd() && m_s[m_pos] >= L'0' && m_s[m_pos] <= L'9')
+				{
+					throw Unsupported();
+				}
+				ch = 0;
+				return true;
+			case L'x':
+			case L'u':
+			{
+				int digits = c == L'x' ? 2 : 4;
+				int value = 0;
+				for (int i = 0; i < digits; i++)
+				{
+					auto h = HexValue(Next());
+					if (h < 0)
+					{
+						throw Unsupported();
+					}
+					value = value * 16 + h;
+				}
+				ch = static_cast<wchar_t>(value);
+				return true;
+			}
+			default:
+				// 反向引用、\B、\c 等不支持；其余符号按字面处理
+				if (IsAsciiAlnum(c))
+				{
+					throw Unsupported();
+				}
+				ch = c;
+				return true;
+			}
+		}
+
+		Node ParseClass()
+		{
+			CharClass cls;
+			cls.Negate = Eat(L'^');
+			if (Peek(L']'))
+			{
+				throw Unsupported();
+			}
+			while (!Eat(L']'))
+			{
+				// POSIX 字符类 [:alpha:] 等
+				if (Peek(L'[') && m_pos + 1 < m_s.size())
+				{
+					auto n = m_s[m_pos + 1];
+					if (n == L':' || n == L'.' || n == L'=')
+					{
+						throw Unsupported();
+					}
+				}
+				wchar_t lo = 0;
+				if (!ParseClassItem(lo, cls))
+				{
+					continue;
+				}
+				if (Peek(L'-') && m_pos + 1 < m_s.size() && m_s[m_pos + 1] != L']')
+				{
+					m_pos++;
+					wchar_t hi = 0;
+					if (!ParseClassItem(hi, cls) || hi < lo)
+					{
+						throw Unsupported();
+					}
+					cls.Ranges.emplace_back(lo, hi);
+				}
+				else
+				{
+					cls.Ranges.emplace_back(lo, lo);
+				}
+			}
+			return ClassNode(std::move(cls));
+		}
+
+		// 返回 false 表示读到的是 \d 等字符类，已直接加入 cls
+		bool ParseClassItem(wchar_t& ch, CharClass& cls)
+		{
+			auto c = Next();
+			if (c != L'\\')
+			{
+				ch = c;
+				return true;
+			}
+			NamedClass named{};
+			if (ParseEscape(ch, named, true))
+			{
+				return true;
+			}
+			cls.Named.push_back(named);
+			return false;
+		}
+
+		Node CharNode(wchar_t c)
+		{
+			Node node{ Node::Kind::Char };
+			node.Ch = c;
+			return node;
+		}
+
+		Node ClassNode(CharClass&& cls)
+		{
+			Node node{ Node::Kind::Class };
+			node.Cls = m_classes.size();
+			m_classes.push_back(std::move(cls));
+			return node;
+		}
+
+		const std::wstring& m_s;
+		std::vector<CharClass>& m_classes;
+		size_t m_pos = 0;
+	};
+}
+
+struct RegexSet::Impl
+{
+	struct State
+	{
+		enum class Kind
+		{
+			Char,
+			Any,
+			Class,
+			Split,
+			Match
+		} Type;
+		wchar_t Ch = 0;
+		size_t Cls = 0;
+		size_t Id = 0;
+		int Out = -1;
+		std::vector<int> Outs{};
+	};
+
+	struct DState
+	{
+		std::vector<int> Nfa;
+		size_t Match = npos;
+		int Ascii[128];
+		std::unordered_map<wchar_t, int> Other;
+	};
+
+	explicit Impl(const std::locale& loc) : Locale(loc), Ctype(std::use_facet<std::ctype<wchar_t>>(Locale)) {}
+
+	std::locale Locale;
+	const std::ctype<wchar_t>& Ctype;
+
+	std::vector<State> States;
+	std::vector<CharClass> Classes;
+	std::vector<int> Starts;
+	size_t PatternStart = 0;
+
+	// 以下为按需构建的 DFA 缓存
+	std::mutex Mutex;
+	std::vector<DState> DStates;
+	std::map<std::vector<int>, int> DIndex;
+	int DStart = -1;
+	std::vector<unsigned> Mark;
+	unsigned Generation = 0;
+
+	int NewState(State::Kind kind)
+	{
+		if (States.size() - PatternStart >= kMaxStatesPerPattern)
+		{
+			throw Unsupported();
+		}
+		States.push_back(State{ kind });
+		return static_cast<int>(States.size() - 1);
+	}
+
+	// 从后往前构建，返回进入 node 的状态，node 匹配完成后转到 next
+	int Compile(const Node& node, int next)
+	{
+		switch (node.Type)
+		{
+		case Node::Kind::Empty:
+			return next;
+		case Node::Kind::Char:
+		{
+			auto s = NewState(State::Kind::Char);
+			States[s].Ch = Ctype.tolower(node.Ch);
+			States[s].Out = next;
+			return s;
+		}
+		case Node::Kind::Any:
+		{
+			auto s = NewState(State::Kind::Any);
+			States[s].Out = next;
+			return s;
+		}
+		case Node::Kind::Class:
+		{
+			auto s = NewState(State::Kind::Class);
+			States[s].Cls = node.Cls;
+			States[s].Out = next;
+			return s;
+		}
+		case Node::Kind::Concat:
+			for (auto it = node.Children.rbegin(); it != node.Children.rend(); ++it)
+			{
+				next = Compile(*it, next);
+			}
+			return next;
+		case Node::Kind::Alt:
+		{
+			std::vector<int> outs;
+			for (auto&& child : node.Children)
+			{
+				outs.push_back(Compile(child, next));
+			}
+			auto s = NewState(State::Kind::Split);
+			States[s].Outs = std::move(outs);
+			return s;
+		}
+		case Node::Kind::Repeat:
+		{
+			auto&& child = node.Children.front();
+			if (node.Max < 0)
+			{
+				auto loop = NewState(State::Kind::Split);
+				auto body = Compile(child, loop);
+				States[loop].Outs = { body, next };
+				next = loop;
+			}
+			else
+			{
+				// x{0,3} => (x(x(x)?)?)?，任意一次跳过都直接结束
+				auto after = next;
+				for (int i = node.Min; i < node.Max; i++)
+				{
+					auto body = Compile(child, next);
+					auto s = NewState(State::Kind::Split);
+					States[s].Outs = { body, after };
+					next = s;
+				}
+			}
+			for (int i = 0; i < node.Min; i++)
+			{
+				next = Compile(child, next);
+			}
+			return next;
+		}
+		}
+		throw Unsupported();
+	}
+
+	bool TestNamed(const NamedClass& named, wchar_t c) const
+	{
+		bool result = false;
+		switch (named.Type)
+		{
+		case NamedClass::Kind::Digit:
+			result = Ctype.is(std::ctype_base::digit, c);
+			break;
+		case NamedClass::Kind::Word:
+			result = c == L'_' || Ctype.is(std::ctype_base::alnum, c);
+			break;
+		case NamedClass::Kind::Space:
+			result = Ctype.is(std::ctype_base::space, c);
+			break;
+		}
+		return result != named.Negate;
+	}
+
+	bool TestClass(const CharClass& cls, wchar_t c) const
+	{
+		auto lower = Ctype.tolower(c);
+		auto upper = Ctype.toupper(c);
+		bool in = false;
+		for (auto&& [lo, hi] : cls.Ranges)
+		{
+			if ((c >= lo && c <= hi) || (lower >= lo && lower <= hi) || (upper >= lo && upper <= hi))
+			{
+				in = true;
+				break;
+			}
+		}
+		if (!in)
+		{
+			for (auto&& named : cls.Named)
+			{
+				if (TestNamed(named, c))
+				{
+					in = true;
+					break;
+				}
+			}
+		}
+		return in != cls.Negate;
+	}
+
+	bool Test(const State& s, wchar_t c) const
+	{
+		switch (s.Type)
+		{
+		case State::Kind::Char:
+			return Ctype.tolower(c) == s.Ch;
+		case State::Kind::Any:
+			// 与 ECMAScript 的 . 相同，不匹配任何行终止符
+			return c != L'\n' && c != L'\r' && c != L'\u2028' && c != L'\u2029';
+		case State::Kind::Class:
+			return TestClass(Classes[s.Cls], c);
+		default:
+			return false;
+		}
+	}
+
+	// 展开空转移，结果只包含消耗字符的状态和接受状态
+	std::vector<int> Closure(const std::vector<int>& seeds)
+	{
+		if (Mark.size() < States.size())
+		{
+			Mark.assign(States.size(), 0);
+			Generation = 0;
+		}
+		if (++Generation == 0)
+		{
+			std::fill(Mark.begin(), Mark.end(), 0);
+			Generation = 1;
+		}
+		std::vector<int> result;
+		std::vector<int> stack(seeds.rbegin(), seeds.rend());
+		while (!stack.empty())
+		{
+			auto s = stack.back();
+			stack.pop_back();
+			if (Mark[s] == Generation)
+			{
+				continue;
+			}
+			Mark[s] = Generation;
+			auto&& state = States[s];
+			if (state.Type == State::Kind::Split)
+			{
+				stack.insert(stack.end(), state.Outs.rbegin(), state.Outs.rend());
+			}
+			else
+			{
+				result.push_back(s);
+			}
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	int GetDState(std::vector<int>&& nfa)
+	{
+		auto it = DIndex.find(nfa);
+		if (it != DIndex.end())
+		{
+			return it->second;
+		}
+		DState d;
+		for (auto s : nfa)
+		{
+			if (States[s].Type == State::Kind::Match)
+			{
+				d.Match = std::min(d.Match, States[s].Id);
+			}
+		}
+		std::fill(std::begin(d.Ascii), std::end(d.Ascii), -1);
+		d.Nfa = nfa;
+		auto index = static_cast<int>(DStates.size());
+		DStates.push_back(std::move(d));
+		DIndex.emplace(std::move(nfa), index);
+		return index;
+	}
+
+	int Step(int d, wchar_t c)
+	{
+		auto ascii = static_cast<unsigned>(c) < 128;
+		if (ascii)
+		{
+			auto next = DStates[d].Ascii[c];
+			if (next >= 0)
+			{
+				return next;
+			}
+		}
+		else
+		{
+			auto it = DStates[d].Other.find(c);
+			if (it != DStates[d].Other.end())
+			{
+				return it->second;
+			}
+		}
+
+		std::vector<int> seeds;
+		for (auto s : DStates[d].Nfa)
+		{
+			if (Test(States[s], c))
+			{
+				seeds.push_back(States[s].Out);
+			}
+		}
+		auto next = GetDState(Closure(seeds));
+		if (ascii)
+		{
+			DStates[d].Ascii[c] = next;
+		}
+		else
+		{
+			DStates[d].Other.emplace(c, next);
+		}
+		return next;
+	}
+
+	void ClearCache()
+	{
+		DStates.clear();
+		DIndex.clear();
+		DStart = -1;
+	}
+};
+
+RegexSet::RegexSet(const std::locale& loc) : m_impl(std::make_unique<Impl>(loc))
+{
+}
+
+RegexSet::RegexSet(RegexSet&&) noexcept = default;
+
+RegexSet& RegexSet::operator=(RegexSet&&) noexcept = default;
+
+RegexSet::~RegexSet() = default;
+
+bool RegexSet::Add(const std::wstring& pattern, size_t id)
+{
+	std::lock_guard lock(m_impl->Mutex);
+	auto&& impl = *m_impl;
+	auto stateMark = impl.States.size();
+	auto classMark = impl.Classes.size();
+	impl.PatternStart = stateMark;
+	try
+	{
+		auto root = Parser(pattern, impl.Classes).Parse();
+		auto match = impl.NewState(Impl::State::Kind::Match);
+		impl.States[match].Id = id;
+		impl.Starts.push_back(impl.Compile(root, match));
+	}
+	catch (const Unsupported&)
+	{
+		impl.States.resize(stateMark);
+		impl.Classes.resize(classMark);
+		return false;
+	}
+	impl.ClearCache();
+	return true;
+}
+
+size_t RegexSet::Match(const std::wstring& s) const
+{
+	std::lock_guard lock(m_impl->Mutex);
+	auto&& impl = *m_impl;
+	if (impl.Starts.empty())
+	{
+		return npos;
+	}
+	if (impl.DStates.size() > kMaxDfaStates)
+	{
+		impl.ClearCache();
+	}
+	if (impl.DStart < 0)
+	{
+		impl.DStart = impl.GetDState(impl.Closure(impl.Starts));
+	}
+	auto d = impl.DStart;
+	for (auto c : s)
+	{
+		d = impl.Step(d, c);
+		if (impl.DStates[d].Nfa.empty())
+		{
+			return npos;
+		}
+	}
+	return impl.DStates[d].Match;
+}
+
+bool RegexSet::IsEmpty() const
+{
+	return m_impl->Starts.empty();
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <locale>
+#include <cstdint>
+
+// 多个正则表达式合并成一个自动机（Thompson NFA + 按需构建的 DFA），
+// 对输入只扫描一遍，返回完整匹配的、序号最小的表达式。
+// 匹配语义与 std::regex_match(ECMAScript | icase) 一致，
+// 只支持其中不依赖回溯的子集，不支持的表达式由 Add 返回 false，调用方自行回退到 std::wregex
+class RegexSet
+{
+public:
+	static constexpr size_t npos = SIZE_MAX;
+
+	explicit RegexSet(const std::locale& loc = std::locale());
+
+	RegexSet(RegexSet&&) noexcept;
+	RegexSet& operator=(RegexSet&&) noexcept;
+	~RegexSet();
+
+	// id 必须按递增顺序添加，Match 返回最小的 id
+	bool Add(const std::wstring& pattern, size_t id);
+
+	size_t Match(const std::wstring& s) const;
+
+	bool IsEmpty() const;
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
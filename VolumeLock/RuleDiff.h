@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <optional>
+
+#include "RuleIndex.h"
+
+struct RuleSetDiff
+{
+    size_t Added = 0;
+    size_t Removed = 0;
+    // 规则内容或顺序有任何变化
+    bool Changed = false;
+};
+
+// 比较新旧规则集，顺序变化也会影响首个匹配的结果，同样视为变化
+inline RuleSetDiff DiffRules(const std::vector<ConfigItem>& oldConfigs, const std::vector<ConfigItem>& newConfigs)
+{
+    using Key = std::tuple<ConfigItem::PathType, std::wstring, int>;
+    std::map<Key, int> count;
+    for (auto&& i : oldConfigs)
+    {
+        count[Key(i.Type, i.Path, i.Volume)]--;
+    }
+    for (auto&& i : newConfigs)
+    {
+        count[Key(i.Type, i.Path, i.Volume)]++;
+    }
+
+    RuleSetDiff diff;
+    for (auto&& [key, n] : count)
+    {
+        if (n > 0)
+        {
+            diff.Added += n;
+        }
+        else if (n < 0)
+        {
+            diff.Removed += -n;
+        }
+    }
+    diff.Changed = oldConfigs != newConfigs;
+    return diff;
+}
+
+template <typename T>
+struct SessionChange
+{
+    T Session;
+    // 为空表示不是目标会话
+    std::optional<int> OldVolume;
+    std::optional<int> NewVolume;
+};
+
+// 用新旧规则分别匹配每个会话，只返回目标音量发生变化的会话
+// infoOf(session) 返回会话的 ProcessInfo
+template <typename Session, typename InfoOf>
+std::vector<SessionChange<Session>> ReevaluateSessions(const std::vector<Session>& sessions, const RuleIndex& oldRules, const RuleIndex& newRules, InfoOf&& infoOf)
+{
+    auto volumeOf = [](const ConfigItem* config) -> std::optional<int> {
+        if (config)
+        {
+            return config->Volume;
+        }
+        return {};
+    };
+
+    std::vector<SessionChange<Session>> changes;
+    for (auto&& session : sessions)
+    {
+        const ProcessInfo& info = infoOf(session);
+        auto oldVolume = volumeOf(oldRules.Find(info));
+        auto newVolume = volumeOf(newRules.Find(info));
+        if (oldVolume != newVolume)
+        {
+            changes.push_back(SessionChange<Session>{ session, oldVolume, newVolume });
+        }
+    }
+    return changes;
+}
@@ -0,0 +1,119 @@
+﻿#include "RuleIndex.h"
+
+RuleIndex::RuleIndex(std::vector<ConfigItem> configs) : m_configs(std::move(configs))
+{
+	for (size_t i = 0; i < m_configs.size(); i++)
+	{
+		auto&& item = m_configs[i];
+		switch (item.Type)
+		{
+		case ConfigItem::PathType::FullPath:
+			m_fullPath.emplace(FoldedKey(item.Path), i);
+			break;
+		case ConfigItem::PathType::FileName:
+			m_fileName.emplace(FoldedKey(item.Path), i);
+			break;
+		case ConfigItem::PathType::Prefix:
+			m_prefix.Add(item.Path, i);
+			break;
+		case ConfigItem::PathType::Glob:
+			m_glob.emplace_back(i, Glob(item.Path));
+			break;
+		case ConfigItem::PathType::Regex:
+		{
+			// 总是用 std::wregex 编译一次，保证语法检查与之前一致
+			std::wregex re(item.Path, std::regex::ECMAScript | std::regex::icase);
+			if (!m_regexSet.Add(item.Path, i))
+			{
+				m_regex.emplace_back(i, std::move(re));
+			}
+			break;
+		}
+		}
+	}
+}
+
+const ConfigItem* RuleIndex::Find(const std::filesystem::path& path) const
+{
+	return Find(path, FoldedKey(path.wstring()), FoldedKey(path.filename().wstring()));
+}
+
+const ConfigItem* RuleIndex::Find(const ProcessInfo& info) const
+{
+	return Find(info.Path, info.FoldedPath, info.FoldedFileName);
+}
+
+const ConfigItem* RuleIndex::Find(const std::filesystem::path& path, const FoldedKey& foldedPath, const FoldedKey& foldedFileName) const
+{
+	auto best = m_configs.size();
+
+	if (!m_fullPath.empty())
+	{
+		auto it = m_fullPath.find(foldedPath);
+		if (it != m_fullPath.end())
+		{
+			best = it->second;
+		}
+	}
+
+	if (!m_fileName.empty())
+	{
+		auto it = m_fileName.find(foldedFileName);
+		if (it != m_fileName.end() && it->second < best)
+		{
+			best = it->second;
+		}
+	}
+
+	if (!m_prefix.IsEmpty())
+	{
+		auto matched = m_prefix.Match(foldedPath.Text);
+		if (matched < best)
+		{
+			best = matched;
+		}
+	}
+
+	// 只需检查排在当前最佳结果之前的通配符
+	for (auto&& [index, glob] : m_glob)
+	{
+		if (index >= best)
+		{
+			break;
+		}
+		if (glob.Match(foldedPath.Text))
+		{
+			best = index;
+			break;
+		}
+	}
+
+	if (!m_regexSet.IsEmpty() || !m_regex.empty())
+	{
+		auto wide = path.wstring();
+		auto matched = m_regexSet.Match(wide);
+		if (matched < best)
+		{
+			best = matched;
+		}
+		// 只需检查排在当前最佳结果之前的正则
+		for (auto&& [index, re] : m_regex)
+		{
+			if (index >= best)
+			{
+				break;
+			}
+			if (std::regex_match(wide, re))
+			{
+				best = index;
+				break;
+			}
+		}
+	}
+
+	if (best == m_configs.size())
+	{
+		return nullptr;
+	}
+	return &m_configs[best];
+}
@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <regex>
+#include <unordered_map>
+#include <filesystem>
+
+#include "RegexSet.h"
+#include "ProcessInfoCache.h"
+#include "CaseFold.h"
+#include "PathTrie.h"
+#include "Glob.h"
+
+struct ConfigItem
+{
+	enum class PathType
+	{
+		FullPath,
+		FileName,
+		Regex,
+		// 目录前缀，按路径分量比较
+		Prefix,
+		// 通配符，语法见 Glob.h
+		Glob
+	} Type;
+	std::wstring Path;
+	int Volume;
+
+	bool operator==(const ConfigItem& other) const
+	{
+		return Type == other.Type && Path == other.Path && Volume == other.Volume;
+	}
+
+	bool operator!=(const ConfigItem& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+// 配置规则的预编译索引，加载时构建一次
+// FullPath 和 FileName 规则放入哈希表，Prefix 规则放入前缀树，Glob 规则各自编译为线性时间的匹配器，正则表达式合并为一个自动机，
+// 自动机不支持的表达式单独编译为 std::wregex
+// 查找结果与按顺序逐条匹配完全一致：返回第一个匹配的规则。
+// 唯一的例外是多条 Prefix 规则同时匹配时，只有最长的前缀参与排序，便于为子目录单独设置音量
+class RuleIndex
+{
+public:
+	RuleIndex() = default;
+
+	// 正则表达式语法错误时抛出 std::regex_error，通配符语法错误时抛出 GlobError
+	explicit RuleIndex(std::vector<ConfigItem> configs);
+
+	const ConfigItem* Find(const std::filesystem::path& path) const;
+
+	// 使用进程信息中预先计算好的折叠路径和哈希，查找时不分配内存
+	const ConfigItem* Find(const ProcessInfo& info) const;
+
+	const std::vector<ConfigItem>& GetConfigs() const
+	{
+		return m_configs;
+	}
+
+	bool IsEmpty() const
+	{
+		return m_configs.empty();
+	}
+
+private:
+	// 只有配置了正则规则时才需要原始路径的宽字符串形式
+	const ConfigItem* Find(const std::filesystem::path& path, const FoldedKey& foldedPath, const FoldedKey& foldedFileName) const;
+
+	std::vector<ConfigItem> m_configs;
+
+	// 折叠后的路径 => 规则序号，相同路径只保留最靠前的规则
+	std::unordered_map<FoldedKey, size_t, FoldedKeyHash> m_fullPath;
+	std::unordered_map<FoldedKey, size_t, FoldedKeyHash> m_fileName;
+
+	PathTrie m_prefix;
+
+	// 按规则顺序排列
+	std::vector<std::pair<size_t, Glob>> m_glob;
+
+	RegexSet m_regexSet;
+
+	// 自动机不支持的正则，按规则顺序排列
+	std::vector<std::pair<size_t, std::wregex>> m_regex;
+};
@@ -0,0 +1,146 @@
+﻿#include "RuleSnapshot.h"
+
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t kMagic = 0x53524c56; // "VLRS"
+	// 格式或 PathType 的取值变化时递增，旧快照会被拒绝并从 YAML 重建
+	// 2：增加 Prefix 和 Glob，Glob 的取值与版本 1 不兼容
+	constexpr uint32_t kVersion = 2;
+
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		// wchar_t 的大小随平台不同，不一致时快照无效
+		uint32_t CharSize;
+		uint32_t Count;
+		uint64_t SourceHash;
+		uint64_t PayloadHash;
+	};
+
+	struct RuleHeader
+	{
+		uint32_t Type;
+		int32_t Volume;
+		uint32_t PathLength;
+	};
+
+	template <typename T>
+	void Append(std::vector<char>& buf, const T& value)
+	{
+		auto p = reinterpret_cast<const char*>(&value);
+		buf.insert(buf.end(), p, p + sizeof(T));
+	}
+}
+
+uint64_t HashBytes(const void* data, size_t size)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ull;
+	auto p = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= p[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+bool SaveRuleSnapshot(const std::filesystem::path& path, uint64_t sourceHash, const std::vector<ConfigItem>& configs)
+{
+	std::vector<char> payload;
+	for (auto&& item : configs)
+	{
+		Append(payload, RuleHeader{ static_cast<uint32_t>(item.Type), item.Volume, static_cast<uint32_t>(item.Path.size()) });
+		auto p = reinterpret_cast<const char*>(item.Path.data());
+		payload.insert(payload.end(), p, p + item.Path.size() * sizeof(wchar_t));
+	}
+
+	Header header{ kMagic, kVersion, sizeof(wchar_t), static_cast<uint32_t>(configs.size()), sourceHash, HashBytes(payload.data(), payload.size()) };
+
+	// 先写临时文件再替换，避免另一个进程读到写了一半的快照
+	auto tmp = path;
+	tmp += L".tmp";
+	{
+		std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			return false;
+		}
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(payload.data(), payload.size());
+		if (!out)
+		{
+			return false;
+		}
+	}
+	std::error_code ec;
+	std::filesystem::rename(tmp, path, ec);
+	return !ec;
+}
+
+std::optional<std::vector<ConfigItem>> LoadRuleSnapshot(const std::filesystem::path& path, uint64_t sourceHash)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		return {};
+	}
+	std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	Header header;
+	if (buf.size() < sizeof(header))
+	{
+		return {};
+	}
+	std::memcpy(&header, buf.data(), sizeof(header));
+	if (header.Magic != kMagic || header.Version != kVersion || header.CharSize != sizeof(wchar_t) || header.SourceHash != sourceHash)
+	{
+		return {};
+	}
+	auto payload = buf.data() + sizeof(header);
+	auto payloadSize = buf.size() - sizeof(header);
+	if (HashBytes(payload, payloadSize) != header.PayloadHash)
+	{
+		return {};
+	}
+
+	// 校验值不覆盖文件头，Count 可能已经损坏，按数据长度能容纳的规则数限制，再据此预留空间
+	if (header.Count > payloadSize / sizeof(RuleHeader))
+	{
+		return {};
+	}
+	std::vector<ConfigItem> configs;
+	configs.reserve(header.Count);
+	size_t pos = 0;
+	for (uint32_t i = 0; i < header.Count; i++)
+	{
+		RuleHeader rule;
+		if (payloadSize - pos < sizeof(rule))
+		{
+			return {};
+		}
+		std::memcpy(&rule, payload + pos, sizeof(rule));
+		pos += sizeof(rule);
+		if (rule.Type > static_cast<uint32_t>(ConfigItem::PathType::Glob) || (payloadSize - pos) / sizeof(wchar_t) < rule.PathLength)
+		{
+			return {};
+		}
+		ConfigItem item;
+		item.Type = static_cast<ConfigItem::PathType>(rule.Type);
+		item.Volume = rule.Volume;
+		item.Path.resize(rule.PathLength);
+		std::memcpy(item.Path.data(), payload + pos, rule.PathLength * sizeof(wchar_t));
+		pos += rule.PathLength * sizeof(wchar_t);
+		configs.push_back(std::move(item));
+	}
+	if (pos != payloadSize)
+	{
+		return {};
+	}
+	return configs;
+}
@@ -0,0 +1,19 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+#include "RuleIndex.h"
+
+// 规则的二进制快照，保存在配置文件旁边，配置文件内容不变时跳过 YAML 解析和编码转换
+// 快照记录源文件内容的哈希，源文件有任何修改都会使快照失效
+
+uint64_t HashBytes(const void* data, size_t size);
+
+bool SaveRuleSnapshot(const std::filesystem::path& path, uint64_t sourceHash, const std::vector<ConfigItem>& configs);
+
+// 快照不存在、已损坏或与源文件不一致时返回空
+std::optional<std::vector<ConfigItem>> LoadRuleSnapshot(const std::filesystem::path& path, uint64_t sourceHash);
@@ -0,0 +1,141 @@
+﻿#include "SessionTable.h"
+
+// 初始索引大小，足够容纳常见数量的会话而不扩容
+constexpr size_t InitialIndexSize = 32;
+
+SessionTable::SessionTable() : m_index(InitialIndexSize, EmptyIndex)
+{
+}
+
+size_t SessionTable::Bucket(const AudioSession* session) const
+{
+	// 对象地址的低位总是 0，乘以黄金分割常数后取高位
+	auto h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(session)) * 0x9e3779b97f4a7c15ull;
+	return static_cast<size_t>(h >> 32) & (m_index.size() - 1);
+}
+
+size_t SessionTable::Probe(const AudioSession* session) const
+{
+	auto mask = m_index.size() - 1;
+	auto i = Bucket(session);
+	while (m_index[i] != EmptyIndex && m_slots[m_index[i]].Entry.Session.get() != session)
+	{
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+SessionHandle SessionTable::Find(const AudioSession* session) const
+{
+	auto slot = m_index[Probe(session)];
+	if (slot == EmptyIndex)
+	{
+		return {};
+	}
+	return SessionHandle{ slot, m_slots[slot].Generation };
+}
+
+SessionEntry* SessionTable::Get(SessionHandle handle)
+{
+	return const_cast<SessionEntry*>(static_cast<const SessionTable*>(this)->Get(handle));
+}
+
+const SessionEntry* SessionTable::Get(SessionHandle handle) const
+{
+	if (handle.Index >= m_slots.size())
+	{
+		return nullptr;
+	}
+	auto& slot = m_slots[handle.Index];
+	if (!slot.Used || slot.Generation != handle.Generation)
+	{
+		return nullptr;
+	}
+	return &slot.Entry;
+}
+
+SessionHandle SessionTable::Insert(const std::shared_ptr<AudioSession>& session, const std::shared_ptr<AudioDevice>& device, int targetVolume)
+{
+	auto existing = Find(session.get());
+	if (Get(existing))
+	{
+		return existing;
+	}
+	if ((m_size + 1) * 2 > m_index.size())
+	{
+		Grow();
+	}
+
+	uint32_t slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = static_cast<uint32_t>(m_slots.size());
+		m_slots.emplace_back();
+	}
+	auto& s = m_slots[slot];
+	s.Used = true;
+	s.Entry = SessionEntry();
+	s.Entry.Session = session;
+	s.Entry.Device = device;
+	s.Entry.Pid = session->GetProcessId();
+	s.Entry.TargetVolume = targetVolume;
+
+	m_index[Probe(session.get())] = slot;
+	m_size++;
+	return SessionHandle{ slot, s.Generation };
+}
+
+bool SessionTable::Erase(SessionHandle handle)
+{
+	if (!Get(handle))
+	{
+		return false;
+	}
+	auto mask = m_index.size() - 1;
+	auto i = Probe(m_slots[handle.Index].Entry.Session.get());
+
+	// 把后面探测链上的项往前补，保证查找时不会在空位提前停止
+	auto j = i;
+	for (;;)
+	{
+		j = (j + 1) & mask;
+		if (m_index[j] == EmptyIndex)
+		{
+			break;
+		}
+		auto home = Bucket(m_slots[m_index[j]].Entry.Session.get());
+		// home 不在 (i, j] 之间时，j 上的项可以移到 i
+		if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j))
+		{
+			m_index[i] = m_index[j];
+			i = j;
+		}
+	}
+	m_index[i] = EmptyIndex;
+
+	auto& s = m_slots[handle.Index];
+	s.Entry = SessionEntry();
+	s.Used = false;
+	s.Generation++;
+	m_freeSlots.push_back(handle.Index);
+	m_size--;
+	return true;
+}
+
+void SessionTable::Grow()
+{
+	std::vector<uint32_t> old(m_index.size() * 2, EmptyIndex);
+	old.swap(m_index);
+	for (auto slot : old)
+	{
+		if (slot != EmptyIndex)
+		{
+			m_index[Probe(m_slots[slot].Entry.Session.get())] = slot;
+		}
+	}
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+#include "AudioBackend.h"
+
+// 指向表中一项的句柄，该项被移除后句柄失效，即使槽位被复用也不会指向新的会话
+struct SessionHandle
+{
+	uint32_t Index = UINT32_MAX;
+	uint32_t Generation = 0;
+
+	bool operator==(const SessionHandle& other) const
+	{
+		return Index == other.Index && Generation == other.Generation;
+	}
+};
+
+// 目标会话及其纠正状态
+struct SessionEntry
+{
+	std::shared_ptr<AudioSession> Session;
+	std::shared_ptr<AudioDevice> Device;
+	uint32_t Pid = 0;
+	int TargetVolume = 0;
+	// 已安排了一次延迟的重试
+	bool RetryPending = false;
+	// 最早一个尚未纠正的音量变化通知的时间，没有时为空
+	bool HasPending = false;
+	std::chrono::steady_clock::time_point PendingSince;
+};
+
+// 以会话对象为键的开放寻址哈希表，线性探测，删除时后移补位而不留墓碑
+// 数据项连续存放在槽位数组中，哈希索引只保存槽位下标，索引扩容不影响句柄
+// 槽位数组增长时数据项会被移动，Get 返回的指针和 ForEach 中的引用不能跨越 Insert 持有，需要时重新用句柄获取
+// 不是线程安全的，只在事件循环线程上使用
+class SessionTable
+{
+public:
+	SessionTable();
+
+	// 不存在时返回无效句柄
+	SessionHandle Find(const AudioSession* session) const;
+
+	// 句柄已失效时返回空
+	SessionEntry* Get(SessionHandle handle);
+
+	const SessionEntry* Get(SessionHandle handle) const;
+
+	// 会话不在表中时返回空
+	SessionEntry* Get(const std::shared_ptr<AudioSession>& session)
+	{
+		return Get(Find(session.get()));
+	}
+
+	// 会话已存在时返回已有的项。可能使之前取得的数据项指针失效
+	SessionHandle Insert(const std::shared_ptr<AudioSession>& session, const std::shared_ptr<AudioDevice>& device, int targetVolume);
+
+	bool Erase(SessionHandle handle);
+
+	size_t Size() const
+	{
+		return m_size;
+	}
+
+	// 遍历期间不能插入或删除
+	template <typename F>
+	void ForEach(F&& f)
+	{
+		for (uint32_t i = 0; i < m_slots.size(); i++)
+		{
+			if (m_slots[i].Used)
+			{
+				f(SessionHandle{ i, m_slots[i].Generation }, m_slots[i].Entry);
+			}
+		}
+	}
+
+private:
+	struct Slot
+	{
+		SessionEntry Entry;
+		uint32_t Generation = 0;
+		bool Used = false;
+	};
+
+	static constexpr uint32_t EmptyIndex = UINT32_MAX;
+
+	size_t Bucket(const AudioSession* session) const;
+
+	// 返回会话所在的索引位置，不存在时返回应插入的空位
+	size_t Probe(const AudioSession* session) const;
+
+	void Grow();
+
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	// 槽位下标，EmptyIndex 表示空位；长度总是 2 的幂，装载率不超过一半
+	std::vector<uint32_t> m_index;
+	size_t m_size = 0;
+};
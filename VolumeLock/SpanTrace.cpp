@@ -0,0 +1,110 @@
+﻿#include "SpanTrace.h"
+
+#include <fstream>
+
+SpanCollector& SpanCollector::Instance()
+{
+	// 故意不析构：其他线程可能在退出过程中仍在记录
+	static auto instance = new SpanCollector();
+	return *instance;
+}
+
+SpanCollector::SpanCollector() : m_start(Clock::now())
+{
+}
+
+SpanCollector::ThreadBuffer& SpanCollector::GetThreadBuffer()
+{
+	// 线程退出后缓冲区仍由收集器持有，导出时不会丢失
+	thread_local std::shared_ptr<ThreadBuffer> buffer;
+	if (!buffer)
+	{
+		buffer = std::make_shared<ThreadBuffer>();
+		std::lock_guard lock(m_mutex);
+		m_buffers.push_back(buffer);
+	}
+	return *buffer;
+}
+
+void SpanCollector::Add(const char* name, uint64_t startNs, uint64_t durationNs)
+{
+	auto& buffer = GetThreadBuffer();
+	std::lock_guard lock(buffer.Mutex);
+	if (buffer.Events.size() >= MaxEventsPerThread)
+	{
+		buffer.Dropped++;
+		return;
+	}
+	buffer.Events.push_back(SpanEvent{ name, startNs, durationNs });
+}
+
+void SpanCollector::WriteChromeTrace(std::ostream& out) const
+{
+	// tid 为线程首次记录区间的顺序，从 1 开始
+	auto threads = GetEvents();
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	for (size_t tid = 0; tid < threads.size(); tid++)
+	{
+		for (auto&& e : threads[tid])
+		{
+			if (!first)
+			{
+				out << ",";
+			}
+			first = false;
+			// 时间单位为微秒，名称都是代码中的标识符，不需要转义
+			out << "\n{\"name\":\"" << e.Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid + 1
+				<< ",\"ts\":" << e.StartNs / 1000 << "." << (e.StartNs % 1000) / 100
+				<< ",\"dur\":" << e.DurationNs / 1000 << "." << (e.DurationNs % 1000) / 100 << "}";
+		}
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+bool SpanCollector::Save(const std::filesystem::path& path) const
+{
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out)
+	{
+		return false;
+	}
+	out.imbue(std::locale::classic());
+	WriteChromeTrace(out);
+	return static_cast<bool>(out);
+}
+
+std::vector<std::vector<SpanEvent>> SpanCollector::GetEvents() const
+{
+	std::lock_guard lock(m_mutex);
+	std::vector<std::vector<SpanEvent>> result;
+	for (auto&& buffer : m_buffers)
+	{
+		std::lock_guard bufferLock(buffer->Mutex);
+		result.push_back(buffer->Events);
+	}
+	return result;
+}
+
+uint64_t SpanCollector::GetDroppedCount() const
+{
+	std::lock_guard lock(m_mutex);
+	uint64_t dropped = 0;
+	for (auto&& buffer : m_buffers)
+	{
+		std::lock_guard bufferLock(buffer->Mutex);
+		dropped += buffer->Dropped;
+	}
+	return dropped;
+}
+
+void SpanCollector::Clear()
+{
+	std::lock_guard lock(m_mutex);
+	for (auto&& buffer : m_buffers)
+	{
+		std::lock_guard bufferLock(buffer->Mutex);
+		buffer->Events.clear();
+		buffer->Dropped = 0;
+	}
+}
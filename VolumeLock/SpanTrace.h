@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <filesystem>
+#include <ostream>
+#include <cstdint>
+
+// 记录各处理函数的耗时区间，导出为 Chrome 的 trace_event JSON，可在 chrome://tracing 或 Perfetto 中查看
+// 只有定义了 VOLUMELOCK_ENABLE_SPANS 时 TRACE_SPAN 才会生成代码，否则完全去掉
+
+struct SpanEvent
+{
+	// 必须是字符串字面量
+	const char* Name;
+	uint64_t StartNs;
+	uint64_t DurationNs;
+};
+
+// 每个线程写入自己的缓冲区，只在导出时与导出线程竞争同一把锁
+class SpanCollector
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// 每个线程最多保留的区间数，超出后丢弃
+	static constexpr size_t MaxEventsPerThread = 1 << 16;
+
+	static SpanCollector& Instance();
+
+	SpanCollector(const SpanCollector&) = delete;
+	SpanCollector& operator=(const SpanCollector&) = delete;
+
+	uint64_t Now() const
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count());
+	}
+
+	void Add(const char* name, uint64_t startNs, uint64_t durationNs);
+
+	void WriteChromeTrace(std::ostream& out) const;
+
+	bool Save(const std::filesystem::path& path) const;
+
+	// 所有线程已记录的区间，按线程分组
+	std::vector<std::vector<SpanEvent>> GetEvents() const;
+
+	uint64_t GetDroppedCount() const;
+
+	void Clear();
+
+private:
+	struct ThreadBuffer
+	{
+		std::vector<SpanEvent> Events;
+		uint64_t Dropped = 0;
+		std::mutex Mutex;
+	};
+
+	SpanCollector();
+
+	ThreadBuffer& GetThreadBuffer();
+
+	Clock::time_point m_start;
+	std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+	mutable std::mutex m_mutex;
+};
+
+class ScopedSpan
+{
+public:
+	explicit ScopedSpan(const char* name) : m_name(name), m_start(SpanCollector::Instance().Now())
+	{
+	}
+
+	~ScopedSpan()
+	{
+		auto& collector = SpanCollector::Instance();
+		collector.Add(m_name, m_start, collector.Now() - m_start);
+	}
+
+	ScopedSpan(const ScopedSpan&) = delete;
+	ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+	const char* m_name;
+	uint64_t m_start;
+};
+
+#ifdef VOLUMELOCK_ENABLE_SPANS
+#define TRACE_SPAN_CONCAT_INNER(a, b) a##b
+#define TRACE_SPAN_CONCAT(a, b) TRACE_SPAN_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) ScopedSpan TRACE_SPAN_CONCAT(span_, __LINE__)(name)
+#else
+#define TRACE_SPAN(name) ((void)0)
+#endif
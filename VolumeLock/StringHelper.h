@@ -0,0 +1,12 @@
+﻿#pragma once
+
+#include <string>
+#include <algorithm>
+#include <cctype>
+
+inline std::string ToLower_Copy(const std::string& s)
+{
+    std::string ss(s);
+    std::transform(s.begin(), s.end(), ss.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+    return ss;
+}
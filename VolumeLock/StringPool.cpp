@@ -0,0 +1,77 @@
+﻿#include "StringPool.h"
+
+InternedString::InternedString(const InternedString& other) : m_entry(other.m_entry)
+{
+	// 从存活的句柄复制，引用计数至少为 1，不会与释放竞争
+	if (m_entry)
+	{
+		m_entry->Refs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+InternedString::~InternedString()
+{
+	if (!m_entry)
+	{
+		return;
+	}
+	// 不是最后一个引用时直接减一，否则交给池在锁内处理，避免与 Intern 找到同一项时竞争
+	auto refs = m_entry->Refs.load(std::memory_order_relaxed);
+	while (refs > 1)
+	{
+		if (m_entry->Refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release, std::memory_order_relaxed))
+		{
+			return;
+		}
+	}
+	m_entry->Pool->Release(m_entry);
+}
+
+const std::wstring& InternedString::Get() const
+{
+	static const std::wstring empty;
+	return m_entry ? m_entry->Text : empty;
+}
+
+StringPool& StringPool::Default()
+{
+	static auto instance = new StringPool();
+	return *instance;
+}
+
+InternedString StringPool::Intern(std::wstring_view s)
+{
+	if (s.empty())
+	{
+		return InternedString();
+	}
+	std::lock_guard lock(m_mutex);
+	auto it = m_entries.find(s);
+	if (it != m_entries.end())
+	{
+		it->second->Refs.fetch_add(1, std::memory_order_relaxed);
+		return InternedString(it->second);
+	}
+	auto entry = new Entry();
+	entry->Pool = this;
+	entry->Text.assign(s);
+	m_entries.emplace(entry->Text, entry);
+	return InternedString(entry);
+}
+
+size_t StringPool::Size() const
+{
+	std::lock_guard lock(m_mutex);
+	return m_entries.size();
+}
+
+void StringPool::Release(Entry* entry)
+{
+	std::lock_guard lock(m_mutex);
+	// 锁内只有 Intern 能增加引用，减到 0 后不会再有人找到这一项
+	if (entry->Refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		m_entries.erase(entry->Text);
+		delete entry;
+	}
+}
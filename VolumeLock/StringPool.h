@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+class StringPool;
+
+// 驻留字符串的句柄，只有一个指针大小。内容相同的句柄指向同一份存储，比较相等只需比较指针
+// 最后一个句柄析构时字符串从池中移除。句柄本身不是线程安全的，但不同句柄可以在不同线程中复制和析构
+class InternedString
+{
+public:
+	InternedString() = default;
+
+	InternedString(const InternedString& other);
+
+	InternedString(InternedString&& other) noexcept : m_entry(other.m_entry)
+	{
+		other.m_entry = nullptr;
+	}
+
+	InternedString& operator=(InternedString other) noexcept
+	{
+		std::swap(m_entry, other.m_entry);
+		return *this;
+	}
+
+	~InternedString();
+
+	const std::wstring& Get() const;
+
+	bool operator==(const InternedString& other) const
+	{
+		return m_entry == other.m_entry;
+	}
+
+	bool operator!=(const InternedString& other) const
+	{
+		return m_entry != other.m_entry;
+	}
+
+private:
+	friend class StringPool;
+
+	struct Entry
+	{
+		std::atomic<uint32_t> Refs{ 1 };
+		StringPool* Pool;
+		std::wstring Text;
+	};
+
+	explicit InternedString(Entry* entry) : m_entry(entry) {}
+
+	// 空字符串用空指针表示，不占用池
+	Entry* m_entry = nullptr;
+};
+
+class StringPool
+{
+public:
+	// 进程内共享的默认池，故意不析构，静态对象析构时仍可能释放句柄
+	static StringPool& Default();
+
+	StringPool() = default;
+
+	StringPool(const StringPool&) = delete;
+	StringPool& operator=(const StringPool&) = delete;
+
+	InternedString Intern(std::wstring_view s);
+
+	// 池中不同字符串的个数
+	size_t Size() const;
+
+private:
+	friend class InternedString;
+
+	using Entry = InternedString::Entry;
+
+	void Release(Entry* entry);
+
+	// 键指向 Entry 自身的 Text，查找时不需要构造字符串
+	std::unordered_map<std::wstring_view, Entry*> m_entries;
+	mutable std::mutex m_mutex;
+};
@@ -0,0 +1,142 @@
+﻿#include "TraceReplay.h"
+
+#include <thread>
+#include <sstream>
+#include <iomanip>
+
+static std::wstring FormatDeviceId(uint64_t device)
+{
+	std::wstringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill(L'0') << device;
+	return ss.str();
+}
+
+TraceReplayer::TraceReplayer(const Trace& trace, SimAudioDeviceEnumerator& enumerator) : m_trace(trace), m_enumerator(enumerator)
+{
+}
+
+void TraceReplayer::ApplyInitialState()
+{
+	for (auto&& record : m_trace.Initial)
+	{
+		Apply(record);
+	}
+}
+
+ReplayStats TraceReplayer::Run(bool realtime)
+{
+	ReplayStats stats;
+	auto start = std::chrono::steady_clock::now();
+	for (auto&& record : m_trace.Events)
+	{
+		if (realtime)
+		{
+			std::this_thread::sleep_until(start + std::chrono::nanoseconds(record.Time - m_trace.Events.front().Time));
+		}
+		if (Apply(record))
+		{
+			stats.Events++;
+		}
+		else
+		{
+			stats.Skipped++;
+		}
+	}
+	stats.Elapsed = std::chrono::steady_clock::now() - start;
+	return stats;
+}
+
+bool TraceReplayer::Apply(const TraceRecord& record)
+{
+	switch (record.Kind)
+	{
+	case TraceKind::DeviceAdded:
+	{
+		if (FindDevice(record.Device))
+		{
+			return false;
+		}
+		auto id = FormatDeviceId(record.Device);
+		m_devices[record.Device] = m_enumerator.AddDevice(id, id);
+		return true;
+	}
+	case TraceKind::DeviceRemoved:
+	{
+		auto device = FindDevice(record.Device);
+		if (!device)
+		{
+			return false;
+		}
+		m_enumerator.RemoveDevice(device);
+		m_devices.erase(record.Device);
+		return true;
+	}
+	case TraceKind::DeviceStateChanged:
+	{
+		auto device = FindDevice(record.Device);
+		if (!device)
+		{
+			return false;
+		}
+		m_enumerator.SetDeviceState(device, static_cast<DeviceState>(record.Reason));
+		return true;
+	}
+	case TraceKind::DefaultDeviceChanged:
+	{
+		auto device = FindDevice(record.Device);
+		if (!device)
+		{
+			return false;
+		}
+		m_enumerator.SetDefaultDevice(device);
+		return true;
+	}
+	case TraceKind::SessionAdded:
+	{
+		auto device = FindDevice(record.Device);
+		if (!device || FindSession(record))
+		{
+			return false;
+		}
+		auto it = m_trace.Processes.find({ record.Pid, record.StartTime });
+		auto path = it == m_trace.Processes.end() ? std::filesystem::path() : it->second;
+		m_sessions[{ record.Device, record.Pid, record.StartTime }] = device->AddSession(record.Pid, path, record.Volume, record.StartTime);
+		return true;
+	}
+	case TraceKind::SessionRemoved:
+	{
+		auto device = FindDevice(record.Device);
+		auto session = FindSession(record);
+		if (!device || !session)
+		{
+			return false;
+		}
+		device->RemoveSession(session, record.Reason);
+		m_sessions.erase({ record.Device, record.Pid, record.StartTime });
+		return true;
+	}
+	case TraceKind::VolumeChanged:
+	{
+		auto session = FindSession(record);
+		if (!session)
+		{
+			return false;
+		}
+		session->ChangeVolume(record.Volume);
+		return true;
+	}
+	}
+	return false;
+}
+
+std::shared_ptr<SimAudioDevice> TraceReplayer::FindDevice(uint64_t device)
+{
+	auto it = m_devices.find(device);
+	return it == m_devices.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<SimAudioSession> TraceReplayer::FindSession(const TraceRecord& record)
+{
+	auto it = m_sessions.find({ record.Device, record.Pid, record.StartTime });
+	return it == m_sessions.end() ? nullptr : it->second;
+}
@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include <map>
+#include <memory>
+#include <chrono>
+#include <tuple>
+#include <filesystem>
+
+#include "EventTrace.h"
+#include "AudioSimulator.h"
+
+struct ReplayStats
+{
+	size_t Events = 0;
+	// 引用了记录中不存在的设备或会话而被跳过的事件
+	size_t Skipped = 0;
+	std::chrono::nanoseconds Elapsed{ 0 };
+};
+
+// 把记录的事件按顺序通过模拟后端重新发出
+class TraceReplayer
+{
+public:
+	TraceReplayer(const Trace& trace, SimAudioDeviceEnumerator& enumerator);
+
+	// 创建开始记录时已经存在的设备和会话，应在创建 VolumeLock 之前调用
+	void ApplyInitialState();
+
+	// realtime 为 true 时按记录的时间间隔发出事件，否则尽快发出
+	ReplayStats Run(bool realtime);
+
+private:
+	// 成功时返回 true
+	bool Apply(const TraceRecord& record);
+
+	std::shared_ptr<SimAudioDevice> FindDevice(uint64_t device);
+
+	std::shared_ptr<SimAudioSession> FindSession(const TraceRecord& record);
+
+	const Trace& m_trace;
+	SimAudioDeviceEnumerator& m_enumerator;
+
+	std::map<uint64_t, std::shared_ptr<SimAudioDevice>> m_devices;
+	// (设备, pid, 启动时间) => 会话，同一进程在一个设备上只重现一个会话
+	std::map<std::tuple<uint64_t, uint32_t, uint64_t>, std::shared_ptr<SimAudioSession>> m_sessions;
+};
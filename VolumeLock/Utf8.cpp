@@ -0,0 +1,235 @@
+﻿#include "Utf8.h"
+
+#include <cstdint>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define UTF8_SSE2
+#endif
+
+Utf8Error::Utf8Error(size_t offset) : std::runtime_error("无效的 UTF-8 编码，位于字符串的第 " + std::to_string(offset + 1) + " 个字节"), m_offset(offset)
+{
+}
+
+namespace
+{
+	// 从 in 开始复制连续的 ASCII 字节，每次 16 个，遇到非 ASCII 字节所在的块或剩余不足 16 字节时停止，返回已复制的字节数
+	size_t CopyAscii(const unsigned char* in, wchar_t* out, size_t n)
+	{
+		size_t i = 0;
+#ifdef UTF8_SSE2
+		const auto zero = _mm_setzero_si128();
+		for (; i + 16 <= n; i += 16)
+		{
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+			if (_mm_movemask_epi8(v) != 0)
+			{
+				break;
+			}
+			auto lo = _mm_unpacklo_epi8(v, zero);
+			auto hi = _mm_unpackhi_epi8(v, zero);
+			if constexpr (sizeof(wchar_t) == 2)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), lo);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), hi);
+			}
+			else
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(lo, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+			}
+		}
+#endif
+		return i;
+	}
+
+	bool IsContinuation(unsigned char c)
+	{
+		return (c & 0xc0) == 0x80;
+	}
+
+	// 解码从 in[i] 开始的一个多字节序列，成功时返回码点并把 i 移到下一个序列，
+	// 失败时 errorOffset 为出错的位置：序列被截断时指向序列开头，否则指向第一个不符合的字节
+	bool DecodeSequence(const unsigned char* in, size_t n, size_t& i, uint32_t& cp, size_t& errorOffset)
+	{
+		auto c = in[i];
+		size_t length;
+		// 第二个字节的合法范围，排除过长编码、代理项和超出 U+10FFFF 的码点
+		unsigned char lo = 0x80;
+		unsigned char hi = 0xbf;
+		if (c >= 0xc2 && c <= 0xdf)
+		{
+			length = 2;
+			cp = c & 0x1f;
+		}
+		else if (c >= 0xe0 && c <= 0xef)
+		{
+			length = 3;
+			cp = c & 0x0f;
+			if (c == 0xe0)
+			{
+				lo = 0xa0;
+			}
+			else if (c == 0xed)
+			{
+				hi = 0x9f;
+			}
+		}
+		else if (c >= 0xf0 && c <= 0xf4)
+		{
+			length = 4;
+			cp = c & 0x07;
+			if (c == 0xf0)
+			{
+				lo = 0x90;
+			}
+			else if (c == 0xf4)
+			{
+				hi = 0x8f;
+			}
+		}
+		else
+		{
+			errorOffset = i;
+			return false;
+		}
+
+		if (i + 1 >= n || in[i + 1] < lo || in[i + 1] > hi)
+		{
+			errorOffset = i + 1 < n ? i + 1 : i;
+			return false;
+		}
+		for (size_t k = 1; k < length; k++)
+		{
+			if (i + k >= n || !IsContinuation(in[i + k]))
+			{
+				errorOffset = i + k >= n ? i : i + k;
+				return false;
+			}
+			cp = (cp << 6) | (in[i + k] & 0x3f);
+		}
+		i += length;
+		return true;
+	}
+
+	// 写入一个码点，返回写入的 wchar_t 个数，空间不足时不写入并返回 0
+	size_t PutCodePoint(uint32_t cp, wchar_t* out, size_t capacity)
+	{
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			if (cp >= 0x10000)
+			{
+				// 代理对不能被截断成一半
+				if (capacity < 2)
+				{
+					return 0;
+				}
+				cp -= 0x10000;
+				out[0] = static_cast<wchar_t>(0xd800 + (cp >> 10));
+				out[1] = static_cast<wchar_t>(0xdc00 + (cp & 0x3ff));
+				return 2;
+			}
+		}
+		if (capacity < 1)
+		{
+			return 0;
+		}
+		out[0] = static_cast<wchar_t>(cp);
+		return 1;
+	}
+}
+
+bool DecodeUtf8(std::string_view s, std::wstring& out, size_t& errorOffset)
+{
+	// 输出的字符数不会超过输入的字节数
+	out.resize(s.size());
+	auto in = reinterpret_cast<const unsigned char*>(s.data());
+	auto n = s.size();
+	size_t i = 0;
+	size_t o = 0;
+	while (i < n)
+	{
+		// 连续的 ASCII 字节一次处理 16 个，输入和输出位置同步前进
+		if (in[i] < 0x80)
+		{
+			auto copied = CopyAscii(in + i, out.data() + o, n - i);
+			i += copied;
+			o += copied;
+			if (i < n && in[i] < 0x80)
+			{
+				out[o++] = in[i++];
+			}
+			continue;
+		}
+
+		uint32_t cp;
+		if (!DecodeSequence(in, n, i, cp, errorOffset))
+		{
+			return false;
+		}
+		o += PutCodePoint(cp, out.data() + o, out.size() - o);
+	}
+	out.resize(o);
+	return true;
+}
+
+size_t DecodeUtf8Lossy(std::string_view s, wchar_t* out, size_t capacity)
+{
+	auto in = reinterpret_cast<const unsigned char*>(s.data());
+	auto n = s.size();
+	size_t i = 0;
+	size_t o = 0;
+	while (i < n && o < capacity)
+	{
+		if (in[i] < 0x80)
+		{
+			auto copied = CopyAscii(in + i, out + o, std::min(n - i, capacity - o));
+			i += copied;
+			o += copied;
+			if (i < n && o < capacity && in[i] < 0x80)
+			{
+				out[o++] = in[i++];
+			}
+			continue;
+		}
+
+		uint32_t cp;
+		size_t errorOffset;
+		auto start = i;
+		if (!DecodeSequence(in, n, i, cp, errorOffset))
+		{
+			// 每段无效的字节显示为一个替换字符：合法的前缀与出错的字节分开，
+			// 无效的首字节单独一段，末尾被截断的序列整段算一个
+			cp = 0xfffd;
+			if (errorOffset > start)
+			{
+				i = errorOffset;
+			}
+			else
+			{
+				i = in[start] >= 0xc2 && in[start] <= 0xf4 ? n : start + 1;
+			}
+		}
+		auto written = PutCodePoint(cp, out + o, capacity - o);
+		if (written == 0)
+		{
+			break;
+		}
+		o += written;
+	}
+	return o;
+}
+
+std::wstring Utf8ToWide(std::string_view s)
+{
+	std::wstring result;
+	size_t errorOffset;
+	if (!DecodeUtf8(s, result, errorOffset))
+	{
+		throw Utf8Error(errorOffset);
+	}
+	return result;
+}
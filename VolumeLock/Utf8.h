@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+// UTF-8 解码，输出 wchar_t 字符串：Windows 上为 UTF-16，wchar_t 为 32 位的平台上为 UTF-32
+// 严格校验：拒绝过长编码、代理项、超出 U+10FFFF 的码点和不完整的序列
+
+class Utf8Error : public std::runtime_error
+{
+public:
+	explicit Utf8Error(size_t offset);
+
+	// 出错的位置，从 0 开始：序列不完整时为序列开头，否则为第一个无效的字节
+	size_t GetOffset() const
+	{
+		return m_offset;
+	}
+
+private:
+	size_t m_offset;
+};
+
+// 失败时返回 false，errorOffset 为出错的位置，out 的内容未定义
+bool DecodeUtf8(std::string_view s, std::wstring& out, size_t& errorOffset);
+
+// 失败时抛出 Utf8Error
+std::wstring Utf8ToWide(std::string_view s);
+
+// 宽松解码到定长缓冲区，不分配内存，用于日志等不能失败的场合
+// 每段无效的字节输出一个 U+FFFD；空间不足时在完整的字符处截断，不会写出半个代理对。返回写入的字符数
+size_t DecodeUtf8Lossy(std::string_view s, wchar_t* out, size_t capacity);
@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include <unordered_map>
+#include <chrono>
+#include <optional>
+#include <vector>
+#include <utility>
+
+// 合并同一会话在短时间内的多次音量变化：窗口内只保留最后观察到的值，
+// 窗口结束时统一处理一次。时间由调用方传入，便于使用模拟时钟
+template <typename Key, typename Clock = std::chrono::steady_clock>
+class VolumeCoalescer
+{
+public:
+    using TimePoint = typename Clock::time_point;
+    using Duration = typename Clock::duration;
+
+    explicit VolumeCoalescer(Duration window) : m_window(window) {}
+
+    Duration GetWindow() const
+    {
+        return m_window;
+    }
+
+    // 返回 true 表示开启了一个新窗口，调用方需要在窗口结束时调用 Flush
+    bool Observe(const Key& key, int volume, TimePoint now)
+    {
+        auto it = m_pending.find(key);
+        if (it != m_pending.end())
+        {
+            it->second.Volume = volume;
+            return false;
+        }
+        m_pending.emplace(key, Pending{ volume, now + m_window });
+        return true;
+    }
+
+    // 对每个到期的会话调用 fn(key, volume)，并移除它们
+    template <typename F>
+    void Flush(TimePoint now, F&& fn)
+    {
+        // 先取出再回调，回调中可以再次调用 Observe
+        std::vector<std::pair<Key, int>> due;
+        for (auto it = m_pending.begin(); it != m_pending.end();)
+        {
+            if (it->second.Deadline <= now)
+            {
+                due.emplace_back(it->first, it->second.Volume);
+                it = m_pending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        for (auto&& [key, volume] : due)
+        {
+            fn(key, volume);
+        }
+    }
+
+    std::optional<TimePoint> NextDeadline() const
+    {
+        std::optional<TimePoint> result;
+        for (auto&& [key, pending] : m_pending)
+        {
+            if (!result.has_value() || pending.Deadline < result.value())
+            {
+                result = pending.Deadline;
+            }
+        }
+        return result;
+    }
+
+    void Erase(const Key& key)
+    {
+        m_pending.erase(key);
+    }
+
+    void Clear()
+    {
+        m_pending.clear();
+    }
+
+    size_t GetPendingCount() const
+    {
+        return m_pending.size();
+    }
+
+private:
+    struct Pending
+    {
+        int Volume;
+        TimePoint Deadline;
+    };
+
+    Duration m_window;
+    std::unordered_map<Key, Pending> m_pending;
+};
@@ -1,344 +1,564 @@
-﻿#include <iostream>
-#include <map>
-#include <sstream>
-#include <regex>
-#include <optional>
-#include <algorithm>
-#include <mutex>
+﻿#include "VolumeLock.h"
 
-#include <windows.h>
-#include <yaml-cpp/yaml.h>
+#include <vector>
+#include <future>
 
-#include "CoreAudioAPI.h"
+#include "Config.h"
+#include "RuleDiff.h"
 #include "Log.h"
+#include "SpanTrace.h"
 
 using namespace std;
 
-struct ConfigItem
+// 设备名称从属性存储中读取，设备消失或驱动异常时会失败，日志中改用设备 ID
+static wstring GetDeviceName(const shared_ptr<AudioDevice>& device)
 {
-    enum class PathType
-    {
-        FullPath,
-        FileName,
-        Regex
-    } Type;
-    wstring Path;
-    int Volume;
-};
+    try
+    {
+        return device->GetFriendlyName();
+    }
+    catch (const std::exception&)
+    {
+        return device->GetId();
+    }
+}
 
-filesystem::path GetExePath()
+VolumeLockMetrics::VolumeLockMetrics(MetricsRegistry& registry)
+    : DevicesAdded(registry.AddCounter("volumelock_devices_added_total", "Audio devices added.")),
+    DevicesRemoved(registry.AddCounter("volumelock_devices_removed_total", "Audio devices removed.")),
+    DeviceStateChanges(registry.AddCounter("volumelock_device_state_changes_total", "Audio device state changes.")),
+    DefaultDeviceChanges(registry.AddCounter("volumelock_default_device_changes_total", "Default output device changes.")),
+    SessionsAdded(registry.AddCounter("volumelock_sessions_added_total", "Audio sessions added.")),
+    SessionsRemoved(registry.AddCounter("volumelock_sessions_removed_total", "Audio sessions removed.")),
+    VolumeEvents(registry.AddCounter("volumelock_volume_events_total", "Volume change notifications from target sessions.")),
+    Corrections(registry.AddCounter("volumelock_corrections_total", "Volume corrections applied to target sessions.")),
+    Resets(registry.AddCounter("volumelock_resets_total", "Non-target sessions reset to full volume.")),
+    ResetsAvoided(registry.AddCounter("volumelock_resets_avoided_total", "Non-target session resets skipped because the volume was already full.")),
+    Throttled(registry.AddCounter("volumelock_throttled_total", "Corrections postponed by the fight governor.")),
+    FightsDetected(registry.AddCounter("volumelock_fights_detected_total", "Volume fights detected.")),
+    ConfigReloads(registry.AddCounter("volumelock_config_reloads_total", "Configuration reloads that changed the rules.")),
+    ConfigReloadErrors(registry.AddCounter("volumelock_config_reload_errors_total", "Configuration reloads that failed.")),
+    FightsByPid(registry.AddCounterFamily("volumelock_pid_fights_detected_total", "Volume fights detected, by process ID of locked sessions.", "pid")),
+    ThrottledByPid(registry.AddCounterFamily("volumelock_pid_throttled_total", "Corrections postponed by the fight governor, by process ID of locked sessions.", "pid")),
+    TargetSessions(registry.AddGauge("volumelock_target_sessions", "Sessions currently locked.")),
+    DispatchLatency(registry.AddHistogram("volumelock_event_dispatch_seconds", "Time from a backend notification to its handling on the event loop.")),
+    EnforceLatency(registry.AddHistogram("volumelock_enforce_latency_seconds", "Time from a volume notification to the correcting SetVolume.")),
+    SetVolumeDuration(registry.AddHistogram("volumelock_set_volume_seconds", "Duration of SetVolume calls."))
 {
-    wchar_t buf[MAX_PATH + 1];
-    GetModuleFileNameW(nullptr, buf, MAX_PATH);
-    filesystem::path path(buf);
-    return path.parent_path();
 }
 
-std::optional<std::wstring> StringToWide(const std::string& s, const std::locale& loc = std::locale(""))
+VolumeLock::VolumeLock(AudioDeviceEnumerator& enumerator, const filesystem::path& configpath, chrono::milliseconds debounce, TraceRecorder* trace) : m_metrics(m_registry), m_enumerator(enumerator), m_configpath(configpath), m_coalescer(debounce), m_trace(trace)
 {
-    typedef std::codecvt<wchar_t, char, mbstate_t> facet_type;
-    mbstate_t mbst = mbstate_t();
-
-    const char* frombegin = s.data();
-    const char* fromend = frombegin + s.size();
-    const char* fromnext = nullptr;
-
-    std::vector<wchar_t> tobuf(s.size() + 1);
-    wchar_t* tobegin = tobuf.data();
-    wchar_t* toend = tobegin + tobuf.size();
-    wchar_t* tonext = nullptr;
-
-    if (std::use_facet<facet_type>(loc).in(mbst, frombegin, fromend, fromnext, tobegin, toend, tonext) != facet_type::ok)
+    try
     {
-        return {};
+        m_configtime = GetConfigWriteTime();
+        m_rules = RuleIndex(LoadConfig(configpath));
+    }
+    catch (const std::exception& e)
+    {
+        LogError(L"加载配置失败：", e.what());
+        return;
     }
-    return tobuf.data();
-}
-
-std::optional<std::wstring> Utf8ToWide(const std::string& s)
-{
-    // TODO: 由于 C++17 标准弃用了一大批编码转换类，到 C++20 才有对应的替代品，
-    // 而当前 C++20 仍处于测试阶段，所以该函数是暂时的，以后将会迁移到 C++20
-
-    // 暂时尝试通过 locale 的方式来转换编码，虽然 UTF-8 和 UTF-16 都跟 locale 无关，
-    // 如果不考虑跨平台，可以调用 Windows API 来实现
 
-    auto locstr = {
-        ".65001",
-        "zh-CN.65001",
-        "zh_CN.UTF-8",
-        "en-US.65001",
-        "en_US.UTF-8"
-    };
-    std::locale loc;
-    for (auto i : locstr)
+    m_loop.Start();
+    auto devices = m_enumerator.GetActiveDevices();
+    auto device = m_enumerator.GetDefaultDevice();
+    if (m_trace)
     {
-        try
+        for (auto&& i : devices)
         {
-            loc = std::locale(i);
-            return StringToWide(s, loc);
+            RecordEvent(TraceKind::DeviceAdded, i, nullptr, 0, 0, true);
+            try
+            {
+                for (auto&& session : i->GetAllSession())
+                {
+                    RecordEvent(TraceKind::SessionAdded, i, session, 0, 0, true);
+                }
+            }
+            catch (const std::exception&)
+            {
+                // 监视设备时会再次枚举并记录错误
+            }
         }
-        catch (...)
+        RecordEvent(TraceKind::DefaultDeviceChanged, device, nullptr, 0, 0, true);
+    }
+    m_loop.Post([this, devices, device]() {
+        for (auto&& i : devices)
         {
-            continue;
+            AttachDevice(i);
         }
-    }
-    return {};
+        HandleDefaultDeviceChanged(device);
+    });
+    m_loop.PostDelayed(ConfigPollInterval, [this]() { CheckConfig(); });
+    m_enumerator.RegisterNotification(this);
 }
 
-string ToLower_Copy(const string& s)
+VolumeLock::~VolumeLock()
 {
-    string ss(s);
-    std::transform(s.begin(), s.end(), ss.begin(), tolower);
-    return ss;
+    m_enumerator.UnregisterNotification(this);
+    // 事件循环停止后，所有状态只由当前线程访问
+    m_loop.Stop();
+    while (!m_devices.empty())
+    {
+        DetachDevice(*m_devices.begin());
+    }
 }
 
-wstring ToLower_Copy(const wstring& s)
+void VolumeLock::Drain()
 {
-    wstring ss(s);
-    std::transform(s.begin(), s.end(), ss.begin(), tolower);
-    return ss;
+    if (!m_loop.IsRunning())
+    {
+        return;
+    }
+    promise<void> done;
+    m_loop.Post([&done]() { done.set_value(); });
+    done.get_future().wait();
 }
 
-namespace YAML {
-    template<>
-    struct convert<wstring> {
-        static bool decode(const Node& node, wstring& rhs) {
-            auto ws = Utf8ToWide(node.as<string>());
-            if (!ws.has_value())
-            {
-                return false;
-            }
-            rhs = ws.value();
-            return true;
+void VolumeLock::RecordEvent(TraceKind kind, const shared_ptr<AudioDevice>& device, const shared_ptr<AudioSession>& session, int32_t volume, int32_t reason, bool initial)
+{
+    if (!m_trace)
+    {
+        return;
+    }
+    uint64_t deviceHash = 0;
+    if (device)
+    {
+        deviceHash = HashDeviceId(device->GetId());
+    }
+    else if (session)
+    {
+        lock_guard lock(m_traceMutex);
+        auto it = m_traceDevices.find(session.get());
+        deviceHash = it == m_traceDevices.end() ? 0 : it->second;
+    }
+    auto pid = session ? session->GetProcessId() : 0;
+    auto startTime = session ? session->GetProcessInfo()->StartTime : 0;
+    if (kind == TraceKind::SessionAdded)
+    {
+        m_trace->AddProcess(pid, startTime, session->GetProcessPath());
+        try
+        {
+            volume = session->GetVolume();
         }
-    };
-
-    template<>
-    struct convert<ConfigItem> {
-        static bool decode(const Node& node, ConfigItem& rhs) {
-            auto type = ToLower_Copy(node["type"].as<string>());
-            if (type == "fullpath")
-            {
-                rhs.Type = ConfigItem::PathType::FullPath;
-            }
-            else if (type == "filename")
-            {
-                rhs.Type = ConfigItem::PathType::FileName;
-            }
-            else if (type == "regex")
-            {
-                rhs.Type = ConfigItem::PathType::Regex;
-            }
-            else
-            {
-                return false;
-            }
-            rhs.Path = node["path"].as<wstring>();
-            rhs.Volume = node["volume"].as<int>();
-            return true;
+        catch (const std::exception&)
+        {
+            volume = -1;
         }
-    };
+    }
+    if (initial)
+    {
+        m_trace->RecordInitial(kind, pid, startTime, deviceHash, volume, reason);
+    }
+    else
+    {
+        m_trace->Record(kind, pid, startTime, deviceHash, volume, reason);
+    }
 }
 
-class VolumeLock : private AudioDeviceEvents, private AudioSessionEvents, private AudioDeviceEnumeratorEvents
+// 开始监视设备上的所有会话
+void VolumeLock::AttachDevice(shared_ptr<AudioDevice> device)
 {
-public:
-    VolumeLock(const filesystem::path& configpath)
+    TRACE_SPAN("AttachDevice");
+    if (m_devices.find(device) != m_devices.end())
+    {
+        return;
+    }
+    vector<shared_ptr<AudioSession>> sessions;
+    try
+    {
+        device->RegisterNotification(this);
+        m_devices.insert(device);
+        Log(L"开始监视设备：", GetDeviceName(device));
+        sessions = device->GetAllSession();
+    }
+    catch (const std::exception& e)
+    {
+        LogError(L"无法监视设备：", device->GetId(), L"：", e.what());
+        DetachDevice(device);
+        return;
+    }
+    // 单个会话出错（例如已经失效）只跳过该会话，设备上的其他会话继续监视
+    for (auto&& session : sessions)
     {
         try
         {
-            auto config = YAML::LoadFile(configpath.string());
-            for (size_t i = 0; i < config.size(); i++)
-            {
-                m_configs.emplace_back(config[i].as<ConfigItem>());
-            }
+            HandleSessionAdded(device, session);
         }
         catch (const std::exception& e)
         {
-            PrintTime();
-            wcerr << L"加载配置失败：" << e.what() << endl;
-            return;
+            LogError(L"[", session->GetProcessId(), L"] 无法处理会话：", e.what());
         }
-        
-        auto device = m_enumerator.GetDefaultDevice();
-        OnDefaultDeviceChanged(device);
-        m_enumerator.RegisterNotification(this);
     }
+}
 
-    ~VolumeLock()
+void VolumeLock::DetachDevice(shared_ptr<AudioDevice> device)
+{
+    TRACE_SPAN("DetachDevice");
+    auto it = m_devices.find(device);
+    if (it == m_devices.end())
     {
-        ClearTargetSession();
-        m_device.reset();
+        return;
     }
+    device->UnregisterNotification(this);
+    vector<shared_ptr<AudioSession>> targets;
+    m_sessions.ForEach([&](SessionHandle, const SessionEntry& entry) {
+        if (entry.Device == device)
+        {
+            targets.push_back(entry.Session);
+        }
+    });
+    for (auto&& session : targets)
+    {
+        RemoveTarget(session);
+    }
+    m_devices.erase(it);
+}
 
-private:
-
-    void ReloadSession()
+void VolumeLock::RemoveTarget(const shared_ptr<AudioSession>& session)
+{
+    session->UnregisterNotification(this);
+    if (m_trace)
+    {
+        lock_guard lock(m_traceMutex);
+        m_traceDevices.erase(session.get());
+    }
+    m_sessions.Erase(m_sessions.Find(session.get()));
+    m_coalescer.Erase(session);
+    auto pid = session->GetProcessId();
+    if (auto fights = m_governor.GetFightCount(session))
     {
-        lock_guard lock(m_mutex);
-        auto sessions = m_device->GetAllSession();
-        for (auto& item : sessions)
+        Log(L"[", pid, L"] 共检测到 ", fights, L" 次音量争夺");
+    }
+    // 同一进程的会话都已移除时删除按进程统计的序列。只有发生过争夺的进程才需要遍历
+    auto key = std::to_string(pid);
+    if (m_metrics.FightsByPid.Get(key))
+    {
+        auto shared = false;
+        m_sessions.ForEach([&](SessionHandle, const SessionEntry& entry) {
+            shared = shared || entry.Pid == pid;
+        });
+        if (!shared)
         {
-            OnSessionAdded(m_device, item);
+            m_metrics.FightsByPid.Remove(key);
+            m_metrics.ThrottledByPid.Remove(key);
         }
     }
+    m_governor.Erase(session);
+    m_metrics.TargetSessions.Set(m_sessions.Size());
+}
+
+const ConfigItem* VolumeLock::GetConfig(const shared_ptr<AudioSession>& session)
+{
+    auto info = session->GetProcessInfo();
+    auto it = m_verdicts.find(info);
+    if (it != m_verdicts.end() && it->second.Generation == m_configGeneration)
+    {
+        return it->second.Rule;
+    }
+    auto rule = m_rules.Find(*info);
+    if (it != m_verdicts.end())
+    {
+        it->second = Verdict{ rule, m_configGeneration };
+        return rule;
+    }
+    if (m_verdicts.size() >= MaxCachedVerdicts)
+    {
+        m_verdicts.clear();
+    }
+    m_verdicts.emplace(info, Verdict{ rule, m_configGeneration });
+    return rule;
+}
+
+void VolumeLock::ResetVolume(const shared_ptr<AudioSession>& session)
+{
+    if (session->GetVolume() == 100)
+    {
+        m_metrics.ResetsAvoided.Add();
+        return;
+    }
+    session->SetVolume(100);
+    m_metrics.Resets.Add();
+}
+
+optional<filesystem::file_time_type> VolumeLock::GetConfigWriteTime()
+{
+    error_code ec;
+    auto time = filesystem::last_write_time(m_configpath, ec);
+    if (ec)
+    {
+        return {};
+    }
+    return time;
+}
+
+void VolumeLock::CheckConfig()
+{
+    auto time = GetConfigWriteTime();
+    if (time.has_value() && time != m_configtime)
+    {
+        m_configtime = time;
+        ReloadConfig();
+    }
+    m_loop.PostDelayed(ConfigPollInterval, [this]() { CheckConfig(); });
+}
 
-    void ClearTargetSession()
+// 重新加载配置，只处理匹配结果或目标音量发生变化的会话；加载失败时保留原有规则
+void VolumeLock::ReloadConfig()
+{
+    TRACE_SPAN("ReloadConfig");
+    vector<ConfigItem> configs;
+    RuleIndex rules;
+    try
     {
-        lock_guard lock(m_mutex);
-        for (auto&& i : m_targetsessions)
+        configs = LoadConfig(m_configpath);
+        rules = RuleIndex(configs);
+    }
+    catch (const std::exception& e)
+    {
+        m_metrics.ConfigReloadErrors.Add();
+        LogError(L"重新加载配置失败，继续使用原有配置：", e.what());
+        return;
+    }
+
+    auto diff = DiffRules(m_rules.GetConfigs(), configs);
+    if (!diff.Changed)
+    {
+        return;
+    }
+
+    vector<pair<shared_ptr<AudioDevice>, shared_ptr<AudioSession>>> sessions;
+    for (auto&& device : m_devices)
+    {
+        for (auto&& session : device->GetAllSession())
         {
-            i->UnregisterNotification(this);
+            sessions.emplace_back(device, session);
         }
-        m_targetsessions.clear();
-        m_pidToVolume.clear();
     }
-
-    const ConfigItem* GetConfig(const filesystem::path& path)
+    auto changes = ReevaluateSessions(sessions, m_rules, rules, [](const pair<shared_ptr<AudioDevice>, shared_ptr<AudioSession>>& item) -> const ProcessInfo& {
+        return *item.second->GetProcessInfo();
+    });
+    m_rules = std::move(rules);
+    m_configGeneration++;
+    m_metrics.ConfigReloads.Add();
+    Log(L"配置已重新加载：新增 ", diff.Added, L" 条，删除 ", diff.Removed, L" 条，影响 ", changes.size(), L" 个会话");
+
+    for (auto&& change : changes)
     {
-        for (auto&& item : m_configs)
+        auto&& [device, session] = change.Session;
+        try
         {
-            if (item.Type == ConfigItem::PathType::FullPath)
+            auto target = m_sessions.Get(session);
+            if (!change.NewVolume.has_value())
             {
-                auto path1 = ToLower_Copy(path.wstring());
-                auto path2 = ToLower_Copy(item.Path);
-                if (path1 == path2)
+                if (target)
                 {
-                    return &item;
+                    Log(L"[", session->GetProcessId(), L"] 不再是目标进程");
+                    RemoveTarget(session);
                 }
+                ResetVolume(session);
             }
-            else if (item.Type == ConfigItem::PathType::FileName)
+            else if (!target)
             {
-                auto path1 = ToLower_Copy(path.filename().wstring());
-                auto path2 = ToLower_Copy(filesystem::path(item.Path).wstring());
-                if (path1 == path2)
-                {
-                    return &item;
-                }
+                HandleSessionAdded(device, session);
             }
-            else if (item.Type == ConfigItem::PathType::Regex)
+            else
             {
-                std::wregex re(item.Path, std::regex::ECMAScript | std::regex::icase);
-                if (std::regex_match(path.wstring(), re))
-                {
-                    return &item;
-                }
+                target->TargetVolume = change.NewVolume.value();
+                EnforceVolume(session, session->GetVolume());
             }
         }
-        return nullptr;
+        catch (const std::exception& e)
+        {
+            LogError(L"[", session->GetProcessId(), L"] 无法处理会话：", e.what());
+        }
     }
+}
 
-    virtual void OnVolumeChanged(std::shared_ptr<AudioSession> session, int volume) override
+void VolumeLock::HandleVolumeChanged(std::shared_ptr<AudioSession> session, int volume, EventLoop::Clock::time_point received)
+{
+    TRACE_SPAN("HandleVolumeChanged");
+    // 事件排队期间会话可能已被移除
+    auto entry = m_sessions.Get(session);
+    if (!entry)
     {
-        auto targetVolume = m_pidToVolume[session->GetProcessId()];
-        if (volume != targetVolume)
-        {
-            Log(wstringstream() << L"[" << session->GetProcessId() << L"] 设置目标进程音量：" << volume << L" => " << targetVolume);
-            session->SetVolume(targetVolume);
-        }
+        return;
     }
+    if (!entry->HasPending)
+    {
+        entry->HasPending = true;
+        entry->PendingSince = received;
+    }
+    if (m_coalescer.GetWindow() == EventLoop::Clock::duration::zero())
+    {
+        EnforceVolume(session, volume);
+        return;
+    }
+    // 拖动音量滑块时事件很密集，窗口内只记录最后的值，结束时纠正一次
+    if (m_coalescer.Observe(session, volume, EventLoop::Clock::now()))
+    {
+        m_loop.PostDelayed(m_coalescer.GetWindow(), [this]() { FlushVolume(); });
+    }
+}
 
-    virtual void OnSessionRemoved(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session, int reason) override
+void VolumeLock::FlushVolume()
+{
+    TRACE_SPAN("FlushVolume");
+    m_coalescer.Flush(EventLoop::Clock::now(), [this](const shared_ptr<AudioSession>& session, int volume) {
+        EnforceVolume(session, volume);
+    });
+}
+
+void VolumeLock::EnforceVolume(std::shared_ptr<AudioSession> session, int volume)
+{
+    TRACE_SPAN("EnforceVolume");
+    auto handle = m_sessions.Find(session.get());
+    auto entry = m_sessions.Get(handle);
+    if (!entry)
     {
-        lock_guard lock(m_mutex);
-        if (m_targetsessions.find(session) == m_targetsessions.end())
-        {
-            return;
-        }
-        session->UnregisterNotification(this);
-        m_targetsessions.erase(session);
-        m_pidToVolume.erase(session->GetProcessId());
-        if (reason == 1000)
-        {
-            Log(wstringstream() << L"[" << session->GetProcessId() << L"] 进程已停止");
-        }
-        else
-        {
-            Log(wstringstream() << L"[" << session->GetProcessId() << L"] 进程已断开");
-        }
+        return;
+    }
+    auto targetVolume = entry->TargetVolume;
+    if (volume == targetVolume)
+    {
+        entry->HasPending = false;
+        return;
     }
 
-    virtual void OnSessionAdded(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session) override
+    EventLoop::Clock::duration retryAfter;
+    switch (m_governor.Request(session, EventLoop::Clock::now(), retryAfter))
     {
-        lock_guard lock(m_mutex);
-        auto config = GetConfig(session->GetProcessPath());
-        if (config)
-        {
-            Log(wstringstream() << L"[" << session->GetProcessId() << L"] 发现目标进程");
-            m_targetsessions.insert(session);
-            m_pidToVolume[session->GetProcessId()] = config->Volume;
-            session->RegisterNotification(this);
-            OnVolumeChanged(session, session->GetVolume());
-        }
-        else
+    case FightGovernor<shared_ptr<AudioSession>, EventLoop::Clock>::Verdict::AllowFightDetected:
+        m_metrics.FightsDetected.Add();
+        m_metrics.FightsByPid.Add(std::to_string(entry->Pid));
+        Log(L"[", session->GetProcessId(), L"] 音量被其他程序反复修改，降低纠正频率");
+        break;
+    case FightGovernor<shared_ptr<AudioSession>, EventLoop::Clock>::Verdict::Throttle:
+        m_metrics.Throttled.Add();
+        m_metrics.ThrottledByPid.Add(std::to_string(entry->Pid));
+        // 同一会话只保留一个重试，到期后按当时的实际音量再纠正
+        // 会话在此期间被移除时句柄失效，重试随之取消
+        if (!entry->RetryPending)
         {
-            session->SetVolume(100);
+            entry->RetryPending = true;
+            m_loop.PostDelayed(retryAfter, [this, handle]() {
+                if (auto entry = m_sessions.Get(handle))
+                {
+                    entry->RetryPending = false;
+                    auto session = entry->Session;
+                    EnforceVolume(session, session->GetVolume());
+                }
+            });
         }
+        return;
+    default:
+        break;
     }
 
-    virtual void OnDefaultDeviceChanged(shared_ptr<AudioDevice> device) override
+    Log(L"[", session->GetProcessId(), L"] 设置目标进程音量：", volume, L" => ", targetVolume);
+    auto start = EventLoop::Clock::now();
     {
-        lock_guard lock(m_mutex);
-        Log(wstringstream() << L"默认输出设备：" << device->GetFriendlyName());
-        if (m_device)
-        {
-            m_device->UnregisterNotification(this);
-        }
-        m_device = device;
-        m_device->RegisterNotification(this);
-        ClearTargetSession();
-        ReloadSession();
+        TRACE_SPAN("SetVolume");
+        session->SetVolume(targetVolume);
+    }
+    auto end = EventLoop::Clock::now();
+    m_metrics.Corrections.Add();
+    m_metrics.SetVolumeDuration.Observe(end - start);
+    if (entry->HasPending)
+    {
+        m_metrics.EnforceLatency.Observe(end - entry->PendingSince);
+        entry->HasPending = false;
     }
+}
 
-    virtual void OnDeviceStateChanged(shared_ptr<AudioDevice> device, DWORD state) override
+void VolumeLock::HandleSessionRemoved(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session, int reason)
+{
+    TRACE_SPAN("HandleSessionRemoved");
+    if (!m_sessions.Get(session))
     {
-        lock_guard lock(m_mutex);
-        switch (state)
-        {
-        case DEVICE_STATE_ACTIVE:
-            Log(wstringstream() << L"设备已启用：" << device->GetFriendlyName());
-            break;
-        case DEVICE_STATE_DISABLED:
-            Log(wstringstream() << L"设备已禁用：" << device->GetFriendlyName());
-            break;
-        case DEVICE_STATE_NOTPRESENT:
-            Log(wstringstream() << L"设备已删除：" << device->GetFriendlyName());
-            break;
-        case DEVICE_STATE_UNPLUGGED:
-            Log(wstringstream() << L"设备已拔出：" << device->GetFriendlyName());
-            break;
-        }
-        ClearTargetSession();
+        return;
+    }
+    RemoveTarget(session);
+    if (reason == SessionExpiredReason)
+    {
+        Log(L"[", session->GetProcessId(), L"] 进程已停止");
+    }
+    else
+    {
+        Log(L"[", session->GetProcessId(), L"] 进程已断开");
+    }
+}
 
-        // 设备重新激活，且为默认设备，重载会话
-        if (state == DEVICE_STATE_ACTIVE && device == m_device)
+void VolumeLock::HandleSessionAdded(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session)
+{
+    TRACE_SPAN("HandleSessionAdded");
+    // 设备停止监视后，排队的事件不再处理
+    if (m_devices.find(device) == m_devices.end() || m_sessions.Get(session))
+    {
+        return;
+    }
+    auto config = GetConfig(session);
+    if (config)
+    {
+        Log(L"[", session->GetProcessId(), L"] 发现目标进程");
+        m_sessions.Insert(session, device, config->Volume);
+        m_metrics.TargetSessions.Set(m_sessions.Size());
+        if (m_trace)
         {
-            ReloadSession();
+            lock_guard lock(m_traceMutex);
+            m_traceDevices[session.get()] = HashDeviceId(device->GetId());
         }
+        session->RegisterNotification(this);
+        EnforceVolume(session, session->GetVolume());
     }
+    else
+    {
+        ResetVolume(session);
+    }
+}
 
-private:
-    AudioDeviceEnumerator m_enumerator;
-    shared_ptr<AudioDevice> m_device;
-    set<shared_ptr<AudioSession>> m_targetsessions;
-
-    vector<ConfigItem> m_configs;
-    map<DWORD, int> m_pidToVolume;
-    recursive_mutex m_mutex;
-};
-
-int wmain(int argc, wchar_t** argv)
+// 所有启用的设备都已在监视中，切换默认设备不需要重新枚举会话
+void VolumeLock::HandleDefaultDeviceChanged(shared_ptr<AudioDevice> device)
 {
-    CoInitializeEx(0, 0);
-    
-    // 使用 UTF-8 语言环境，除了数值，不要对数值使用逗号分割
-    locale::global(locale(locale::classic(), locale(".65001"), locale::all & (locale::all ^ locale::numeric)));
+    TRACE_SPAN("HandleDefaultDeviceChanged");
+    Log(L"默认输出设备：", GetDeviceName(device));
+    AttachDevice(device);
+}
 
-    auto configpath = GetExePath() / L"config.yaml";
-    VolumeLock lock(configpath);
+void VolumeLock::HandleDeviceAdded(shared_ptr<AudioDevice> device)
+{
+    TRACE_SPAN("HandleDeviceAdded");
+    Log(L"设备已添加：", GetDeviceName(device));
+    if (device->IsActive())
+    {
+        AttachDevice(device);
+    }
+}
 
-    Log(L"开始运行，按回车键退出 ...");
-    cin.get();
-    Log(L"结束");
+void VolumeLock::HandleDeviceStateChanged(shared_ptr<AudioDevice> device, DeviceState state)
+{
+    TRACE_SPAN("HandleDeviceStateChanged");
+    switch (state)
+    {
+    case DeviceState::Active:
+        Log(L"设备已启用：", GetDeviceName(device));
+        break;
+    case DeviceState::Disabled:
+        Log(L"设备已禁用：", GetDeviceName(device));
+        break;
+    case DeviceState::NotPresent:
+        Log(L"设备已删除：", GetDeviceName(device));
+        break;
+    case DeviceState::Unplugged:
+        Log(L"设备已拔出：", GetDeviceName(device));
+        break;
+    }
+    if (state == DeviceState::Active)
+    {
+        AttachDevice(device);
+    }
+    else
+    {
+        DetachDevice(device);
+    }
 }
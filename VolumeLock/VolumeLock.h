@@ -0,0 +1,224 @@
+﻿#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+#include "AudioBackend.h"
+#include "EventTrace.h"
+#include "RuleIndex.h"
+#include "EventLoop.h"
+#include "VolumeCoalescer.h"
+#include "FightGovernor.h"
+#include "SessionTable.h"
+#include "Metrics.h"
+#include "SpanTrace.h"
+
+// VolumeLock 的运行时指标，事件计数在通知线程上更新，其余在事件循环线程上更新
+struct VolumeLockMetrics
+{
+    explicit VolumeLockMetrics(MetricsRegistry& registry);
+
+    Counter& DevicesAdded;
+    Counter& DevicesRemoved;
+    Counter& DeviceStateChanges;
+    Counter& DefaultDeviceChanges;
+    Counter& SessionsAdded;
+    Counter& SessionsRemoved;
+    Counter& VolumeEvents;
+    Counter& Corrections;
+    Counter& Resets;
+    // 会话音量已经是 100，省去的重置
+    Counter& ResetsAvoided;
+    Counter& Throttled;
+    Counter& FightsDetected;
+    Counter& ConfigReloads;
+    Counter& ConfigReloadErrors;
+    // 按进程 ID 统计，只包含仍有会话被锁定的进程
+    CounterFamily& FightsByPid;
+    CounterFamily& ThrottledByPid;
+    Gauge& TargetSessions;
+    // 通知到事件循环开始处理的耗时
+    Histogram& DispatchLatency;
+    // 收到音量变化通知到纠正完成的耗时，包括合并窗口和限流等待
+    Histogram& EnforceLatency;
+    Histogram& SetVolumeDuration;
+};
+
+// 锁定目标进程音量的核心逻辑，只依赖 AudioBackend.h 中的接口，
+// 可以运行在 Core Audio 或模拟后端之上
+class VolumeLock : private AudioDeviceEvents, private AudioSessionEvents, private AudioDeviceEnumeratorEvents
+{
+public:
+    static constexpr std::chrono::milliseconds DefaultDebounce{ 50 };
+
+    // 检查配置文件是否修改的间隔
+    static constexpr std::chrono::seconds ConfigPollInterval{ 1 };
+
+    // 匹配结果缓存的最大进程数，超出后整体清空
+    static constexpr size_t MaxCachedVerdicts = 1024;
+
+    // debounce 为合并音量变化事件的窗口，为 0 时立即纠正
+    // enumerator 和 trace 必须比当前对象存活更久，trace 为空时不记录事件
+    VolumeLock(AudioDeviceEnumerator& enumerator, const std::filesystem::path& configpath, std::chrono::milliseconds debounce = DefaultDebounce, TraceRecorder* trace = nullptr);
+
+    ~VolumeLock();
+
+    // 等待已投递的事件全部处理完，不包括尚未到期的延迟任务
+    void Drain();
+
+    const MetricsRegistry& GetMetrics() const
+    {
+        return m_registry;
+    }
+
+    // 后端等其他模块可以把自己的指标注册到同一个注册表中，一起导出
+    MetricsRegistry& GetMetrics()
+    {
+        return m_registry;
+    }
+
+private:
+
+    // 以下 On* 回调由后端的通知线程调用，只负责把事件投递到事件循环，
+    // Handle* 及其余成员函数只在事件循环线程上执行，不需要加锁
+
+    virtual void OnVolumeChanged(std::shared_ptr<AudioSession> session, int volume) override
+    {
+        TRACE_SPAN("OnVolumeChanged");
+        RecordEvent(TraceKind::VolumeChanged, nullptr, session, volume, 0);
+        m_metrics.VolumeEvents.Add();
+        auto received = EventLoop::Clock::now();
+        m_loop.Post([this, session, volume, received]() {
+            m_metrics.DispatchLatency.Observe(EventLoop::Clock::now() - received);
+            HandleVolumeChanged(session, volume, received);
+        });
+    }
+
+    virtual void OnSessionRemoved(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session, int reason) override
+    {
+        TRACE_SPAN("OnSessionRemoved");
+        RecordEvent(TraceKind::SessionRemoved, device, session, 0, reason);
+        Dispatch(m_metrics.SessionsRemoved, [this, device, session, reason]() { HandleSessionRemoved(device, session, reason); });
+    }
+
+    virtual void OnSessionAdded(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session) override
+    {
+        TRACE_SPAN("OnSessionAdded");
+        RecordEvent(TraceKind::SessionAdded, device, session, 0, 0);
+        Dispatch(m_metrics.SessionsAdded, [this, device, session]() { HandleSessionAdded(device, session); });
+    }
+
+    virtual void OnDefaultDeviceChanged(std::shared_ptr<AudioDevice> device) override
+    {
+        TRACE_SPAN("OnDefaultDeviceChanged");
+        RecordEvent(TraceKind::DefaultDeviceChanged, device, nullptr, 0, 0);
+        Dispatch(m_metrics.DefaultDeviceChanges, [this, device]() { HandleDefaultDeviceChanged(device); });
+    }
+
+    virtual void OnDeviceStateChanged(std::shared_ptr<AudioDevice> device, DeviceState state) override
+    {
+        TRACE_SPAN("OnDeviceStateChanged");
+        RecordEvent(TraceKind::DeviceStateChanged, device, nullptr, 0, static_cast<int32_t>(state));
+        Dispatch(m_metrics.DeviceStateChanges, [this, device, state]() { HandleDeviceStateChanged(device, state); });
+    }
+
+    virtual void OnDeviceAdded(std::shared_ptr<AudioDevice> device) override
+    {
+        TRACE_SPAN("OnDeviceAdded");
+        RecordEvent(TraceKind::DeviceAdded, device, nullptr, 0, 0);
+        Dispatch(m_metrics.DevicesAdded, [this, device]() { HandleDeviceAdded(device); });
+    }
+
+    virtual void OnDeviceRemoved(std::shared_ptr<AudioDevice> device) override
+    {
+        TRACE_SPAN("OnDeviceRemoved");
+        RecordEvent(TraceKind::DeviceRemoved, device, nullptr, 0, 0);
+        Dispatch(m_metrics.DevicesRemoved, [this, device]() { DetachDevice(device); });
+    }
+
+    // 计数并投递到事件循环，同时统计排队耗时
+    template <typename F>
+    void Dispatch(Counter& counter, F&& handler)
+    {
+        counter.Add();
+        auto received = EventLoop::Clock::now();
+        m_loop.Post([this, received, handler = std::forward<F>(handler)]() {
+            m_metrics.DispatchLatency.Observe(EventLoop::Clock::now() - received);
+            handler();
+        });
+    }
+
+    // 在通知线程上调用，未开启记录时不做任何事
+    void RecordEvent(TraceKind kind, const std::shared_ptr<AudioDevice>& device, const std::shared_ptr<AudioSession>& session, int32_t volume, int32_t reason, bool initial = false);
+
+    void AttachDevice(std::shared_ptr<AudioDevice> device);
+
+    void DetachDevice(std::shared_ptr<AudioDevice> device);
+
+    void RemoveTarget(const std::shared_ptr<AudioSession>& session);
+
+    // 同一进程的匹配结果会被缓存，直到规则发生变化
+    const ConfigItem* GetConfig(const std::shared_ptr<AudioSession>& session);
+
+    // 非目标会话恢复到 100，已经是 100 时不写入
+    void ResetVolume(const std::shared_ptr<AudioSession>& session);
+
+    std::optional<std::filesystem::file_time_type> GetConfigWriteTime();
+
+    void CheckConfig();
+
+    void ReloadConfig();
+
+    void HandleVolumeChanged(std::shared_ptr<AudioSession> session, int volume, EventLoop::Clock::time_point received);
+
+    void FlushVolume();
+
+    void EnforceVolume(std::shared_ptr<AudioSession> session, int volume);
+
+    void HandleSessionRemoved(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session, int reason);
+
+    void HandleSessionAdded(std::shared_ptr<AudioDevice> device, std::shared_ptr<AudioSession> session);
+
+    void HandleDefaultDeviceChanged(std::shared_ptr<AudioDevice> device);
+
+    void HandleDeviceAdded(std::shared_ptr<AudioDevice> device);
+
+    void HandleDeviceStateChanged(std::shared_ptr<AudioDevice> device, DeviceState state);
+
+private:
+    MetricsRegistry m_registry;
+    VolumeLockMetrics m_metrics;
+
+    AudioDeviceEnumerator& m_enumerator;
+    // 正在监视的设备
+    std::set<std::shared_ptr<AudioDevice>> m_devices;
+    // 目标会话及其目标音量和纠正状态
+    SessionTable m_sessions;
+
+    std::filesystem::path m_configpath;
+    std::optional<std::filesystem::file_time_type> m_configtime;
+    RuleIndex m_rules;
+    // 每次替换 m_rules 时递增，缓存的匹配结果只在同一代中有效
+    uint64_t m_configGeneration = 0;
+    struct Verdict
+    {
+        // 为空表示没有匹配的规则
+        const ConfigItem* Rule;
+        uint64_t Generation;
+    };
+    // 以进程信息对象为键：同一进程的会话共享同一个对象，持有它也保证地址不会被复用
+    std::unordered_map<std::shared_ptr<const ProcessInfo>, Verdict> m_verdicts;
+    VolumeCoalescer<std::shared_ptr<AudioSession>, EventLoop::Clock> m_coalescer;
+    FightGovernor<std::shared_ptr<AudioSession>, EventLoop::Clock> m_governor;
+    TraceRecorder* m_trace;
+    // 开启记录时，已注册音量通知的会话 => 所在设备 ID 的哈希。音量通知不带设备，由通知线程查询
+    std::unordered_map<AudioSession*, uint64_t> m_traceDevices;
+    std::mutex m_traceMutex;
+    EventLoop m_loop;
+};
@@ -0,0 +1,139 @@
+﻿#include "WorkerPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// 当前线程所属的线程池，不是工作线程时为空
+	thread_local const WorkerPool* t_pool = nullptr;
+}
+
+size_t WorkerPool::DefaultSize()
+{
+	return std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 4);
+}
+
+WorkerPool::WorkerPool(size_t threads, ThreadInit init)
+	: m_init(std::move(init))
+{
+	threads = std::max<size_t>(threads, 1);
+	m_threads.reserve(threads);
+	for (size_t i = 0; i < threads; i++)
+	{
+		m_threads.emplace_back(&WorkerPool::WorkerMain, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard run(m_runMutex);
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_workCv.notify_all();
+	for (auto&& t : m_threads)
+	{
+		t.join();
+	}
+}
+
+void WorkerPool::Run(size_t count, const std::function<void(size_t)>& fn)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (count == 1 || IsWorkerThread())
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			fn(i);
+		}
+		return;
+	}
+
+	std::lock_guard run(m_runMutex);
+	Batch batch;
+	batch.Fn = &fn;
+	batch.Count = count;
+	{
+		std::lock_guard lock(m_mutex);
+		m_batch = &batch;
+		m_batchSeq++;
+	}
+	m_workCv.notify_all();
+
+	std::exception_ptr error;
+	{
+		std::unique_lock lock(m_mutex);
+		m_doneCv.wait(lock, [&] { return batch.Completed == batch.Count && m_busy == 0; });
+		// 之后醒来的工作线程看不到这一批，批次可以随调用者的栈一起释放
+		m_batch = nullptr;
+		error = batch.Error;
+	}
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+bool WorkerPool::IsWorkerThread() const
+{
+	return t_pool == this;
+}
+
+void WorkerPool::WorkerMain()
+{
+	t_pool = this;
+	[[maybe_unused]] auto guard = m_init ? m_init() : nullptr;
+	uint64_t seen = 0;
+	std::unique_lock lock(m_mutex);
+	for (;;)
+	{
+		m_workCv.wait(lock, [&] { return m_stop || (m_batch && m_batchSeq != seen); });
+		if (m_stop)
+		{
+			return;
+		}
+		seen = m_batchSeq;
+		auto batch = m_batch;
+		m_busy++;
+		lock.unlock();
+		Work(*batch);
+		lock.lock();
+		m_busy--;
+		if (m_busy == 0)
+		{
+			m_doneCv.notify_all();
+		}
+	}
+}
+
+void WorkerPool::Work(Batch& batch)
+{
+	size_t completed = 0;
+	std::exception_ptr error;
+	for (size_t i = batch.Next++; i < batch.Count; i = batch.Next++)
+	{
+		try
+		{
+			(*batch.Fn)(i);
+		}
+		catch (...)
+		{
+			if (!error)
+			{
+				error = std::current_exception();
+			}
+		}
+		completed++;
+	}
+
+	std::lock_guard lock(m_mutex);
+	batch.Completed += completed;
+	if (error && !batch.Error)
+	{
+		batch.Error = error;
+	}
+}
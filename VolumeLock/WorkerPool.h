@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+
+// 固定数量的常驻工作线程，把一批相互独立的任务分给它们执行，全部完成后返回
+// 线程只在构造时创建一次，多次调用之间复用，线程局部的状态（COM 初始化、跟踪缓冲区）不会反复创建
+class WorkerPool
+{
+public:
+	// 每个工作线程开始时调用一次，返回值在线程退出时释放，可用于初始化线程环境
+	using ThreadInit = std::function<std::shared_ptr<void>()>;
+
+	// 默认的线程数，这里的任务大多在等待系统调用，不需要太多线程
+	static size_t DefaultSize();
+
+	explicit WorkerPool(size_t threads = DefaultSize(), ThreadInit init = nullptr);
+
+	// 等待当前的一批任务完成后结束所有线程
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	size_t Size() const
+	{
+		return m_threads.size();
+	}
+
+	// 把 [0, count) 分给工作线程执行 fn(i)，全部完成后返回；fn 抛出的第一个异常在全部完成后重新抛出
+	// 多个线程同时调用时依次执行。在本池的工作线程中调用时直接在当前线程依次执行，避免互相等待
+	void Run(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+	struct Batch
+	{
+		const std::function<void(size_t)>* Fn;
+		size_t Count;
+		std::atomic<size_t> Next{ 0 };
+		// 以下由 m_mutex 保护
+		size_t Completed = 0;
+		std::exception_ptr Error;
+	};
+
+	void WorkerMain();
+
+	// 领取并执行任务，直到这一批没有剩余的任务
+	void Work(Batch& batch);
+
+	bool IsWorkerThread() const;
+
+	// 串行化 Run 的调用者，同一时间只有一批任务
+	std::mutex m_runMutex;
+
+	std::mutex m_mutex;
+	std::condition_variable m_workCv;
+	std::condition_variable m_doneCv;
+	// 以下由 m_mutex 保护
+	Batch* m_batch = nullptr;
+	uint64_t m_batchSeq = 0;
+	// 正在处理当前批次的工作线程数，为 0 后调用者才能释放批次
+	size_t m_busy = 0;
+	bool m_stop = false;
+
+	ThreadInit m_init;
+	std::vector<std::thread> m_threads;
+};
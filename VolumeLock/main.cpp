@@ -0,0 +1,213 @@
+﻿#include <iostream>
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include <atomic>
+#include <optional>
+
+#include <windows.h>
+
+#include "CoreAudioAPI.h"
+#include "VolumeLock.h"
+#include "EventTrace.h"
+#include "TraceReplay.h"
+#include "AudioSimulator.h"
+#include "Metrics.h"
+#include "DeferredReleaser.h"
+#include "SpanTrace.h"
+#include "Log.h"
+
+using namespace std;
+
+filesystem::path GetExePath()
+{
+    wchar_t buf[MAX_PATH + 1];
+    GetModuleFileNameW(nullptr, buf, MAX_PATH);
+    filesystem::path path(buf);
+    return path.parent_path();
+}
+
+// 导出指标的间隔
+constexpr chrono::seconds MetricsInterval{ 10 };
+
+// 运行期间保存事件记录的间隔，异常退出时最多丢失这段时间内的事件
+constexpr chrono::seconds TraceSaveInterval{ 10 };
+
+// 保存各处理函数的耗时区间，编译时未启用 VOLUMELOCK_ENABLE_SPANS 时文件中没有任何区间
+void SaveSpans(const filesystem::path& path)
+{
+    auto& collector = SpanCollector::Instance();
+    if (collector.Save(path))
+    {
+        Log(L"耗时区间已保存，丢弃 ", collector.GetDroppedCount(), L" 个");
+    }
+    else
+    {
+        Log(L"无法保存耗时区间");
+    }
+}
+
+// 在模拟后端上重现记录的事件，输出处理速度
+int Replay(const filesystem::path& tracepath, const filesystem::path& configpath, chrono::milliseconds debounce, bool realtime, const optional<filesystem::path>& metricspath)
+{
+    auto trace = LoadTrace(tracepath);
+    if (!trace.has_value())
+    {
+        Log(L"无法读取事件记录");
+        return 1;
+    }
+
+    atomic<uint64_t> writes{ 0 };
+    SimContext context;
+    context.OnWrite = [&writes](const shared_ptr<SimAudioSession>&, int) { writes++; };
+    SimAudioDeviceEnumerator enumerator(context);
+    TraceReplayer replayer(trace.value(), enumerator);
+    replayer.ApplyInitialState();
+
+    ReplayStats stats;
+    {
+        VolumeLock lock(enumerator, configpath, debounce);
+        unique_ptr<MetricsExporter> exporter;
+        if (metricspath.has_value())
+        {
+            exporter = make_unique<MetricsExporter>(lock.GetMetrics(), metricspath.value(), MetricsInterval);
+        }
+        lock.Drain();
+        // 计时包括等待 VolumeLock 处理完所有事件
+        auto start = chrono::steady_clock::now();
+        stats = replayer.Run(realtime);
+        lock.Drain();
+        stats.Elapsed = chrono::steady_clock::now() - start;
+    }
+
+    auto seconds = chrono::duration<double>(stats.Elapsed).count();
+    Log(L"重现 ", stats.Events, L" 个事件，跳过 ", stats.Skipped, L" 个，用时 ", seconds * 1000, L" ms，", (seconds > 0 ? stats.Events / seconds : 0), L" 个/秒，设置音量 ", writes.load(), L" 次");
+    return 0;
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    CoInitializeEx(0, 0);
+    
+    // 使用 UTF-8 语言环境，除了数值，不要对数值使用逗号分割
+    locale::global(locale(locale::classic(), locale(".65001"), locale::all & (locale::all ^ locale::numeric)));
+
+    auto debounce = VolumeLock::DefaultDebounce;
+    optional<filesystem::path> tracepath;
+    optional<filesystem::path> replaypath;
+    optional<filesystem::path> logpath;
+    optional<filesystem::path> metricspath;
+    optional<filesystem::path> spanspath;
+    bool fast = false;
+    for (int i = 1; i < argc; i++)
+    {
+        wstring arg = argv[i];
+        if (arg == L"--debounce" && i + 1 < argc)
+        {
+            debounce = chrono::milliseconds(stoi(argv[++i]));
+        }
+        else if (arg == L"--trace" && i + 1 < argc)
+        {
+            tracepath = argv[++i];
+        }
+        else if (arg == L"--replay" && i + 1 < argc)
+        {
+            replaypath = argv[++i];
+        }
+        else if (arg == L"--log" && i + 1 < argc)
+        {
+            logpath = argv[++i];
+        }
+        else if (arg == L"--metrics" && i + 1 < argc)
+        {
+            metricspath = argv[++i];
+        }
+        else if (arg == L"--spans" && i + 1 < argc)
+        {
+            spanspath = argv[++i];
+        }
+        else if (arg == L"--fast")
+        {
+            fast = true;
+        }
+    }
+
+    if (logpath.has_value())
+    {
+        Logger::Instance().SetFile(logpath.value());
+    }
+#ifndef VOLUMELOCK_ENABLE_SPANS
+    if (spanspath.has_value())
+    {
+        LogWarning(L"编译时未启用 VOLUMELOCK_ENABLE_SPANS，不会记录耗时区间");
+    }
+#endif
+
+    auto configpath = GetExePath() / L"config.yaml";
+    if (replaypath.has_value())
+    {
+        auto code = Replay(replaypath.value(), configpath, debounce, !fast, metricspath);
+        if (spanspath.has_value())
+        {
+            SaveSpans(spanspath.value());
+        }
+        Logger::Instance().Flush();
+        return code;
+    }
+
+    unique_ptr<TraceRecorder> recorder;
+    if (tracepath.has_value())
+    {
+        recorder = make_unique<TraceRecorder>();
+    }
+    {
+        // 在 VolumeLock 之后析构，最后一次保存在下面进行
+        unique_ptr<TraceSaver> saver;
+        if (recorder)
+        {
+            saver = make_unique<TraceSaver>(*recorder, tracepath.value(), TraceSaveInterval);
+        }
+        CoreAudioDeviceEnumerator enumerator;
+        VolumeLock lock(enumerator, configpath, debounce, recorder.get());
+        unique_ptr<MetricsExporter> exporter;
+        if (metricspath.has_value())
+        {
+            // Core Audio 后端通过 DeferredReleaser 延迟释放会话和设备
+            DeferredReleaser::Instance().RegisterMetrics(lock.GetMetrics());
+            exporter = make_unique<MetricsExporter>(lock.GetMetrics(), metricspath.value(), MetricsInterval);
+        }
+
+        if (spanspath.has_value())
+        {
+            Log(L"开始运行，输入 s 并回车保存耗时区间，直接回车退出 ...");
+            string line;
+            while (getline(cin, line) && line == "s")
+            {
+                SaveSpans(spanspath.value());
+            }
+        }
+        else
+        {
+            Log(L"开始运行，按回车键退出 ...");
+            cin.get();
+        }
+    }
+    if (spanspath.has_value())
+    {
+        SaveSpans(spanspath.value());
+    }
+    if (recorder)
+    {
+        if (recorder->Save(tracepath.value()))
+        {
+            Log(L"事件记录已保存，丢失 ", recorder->GetDroppedCount(), L" 条较早的记录");
+        }
+        else
+        {
+            Log(L"无法保存事件记录");
+        }
+    }
+    Log(L"结束");
+    Logger::Instance().Flush();
+    return 0;
+}
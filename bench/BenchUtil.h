@@ -0,0 +1,114 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#include "Logger.h"
+
+// 基准程序的公共工具。结果只用 printf 输出，日志关闭控制台输出，避免与宽字符输出混用
+
+using BenchClock = std::chrono::steady_clock;
+
+// 阻止编译器把只为计时而计算的结果优化掉
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+inline double ElapsedNs(BenchClock::time_point start, BenchClock::time_point end)
+{
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// 重复调用 fn 共 iterations 次，返回每次的平均耗时（纳秒）
+template <typename F>
+double MeasureNs(size_t iterations, F&& fn)
+{
+	auto start = BenchClock::now();
+	for (size_t i = 0; i < iterations; i++)
+	{
+		fn(i);
+	}
+	return ElapsedNs(start, BenchClock::now()) / static_cast<double>(iterations);
+}
+
+// 对已有的样本取分位数，q 在 [0, 1] 之间
+inline double Percentile(std::vector<double> samples, double q)
+{
+	if (samples.empty())
+	{
+		return 0;
+	}
+	auto k = static_cast<size_t>(q * (samples.size() - 1) + 0.5);
+	std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+	return samples[k];
+}
+
+// 形如 --name value 的参数，不存在时返回默认值
+inline long GetArg(int argc, char** argv, const char* name, long defaultValue)
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::strcmp(argv[i], name) == 0)
+		{
+			return std::strtol(argv[i + 1], nullptr, 10);
+		}
+	}
+	return defaultValue;
+}
+
+inline void QuietLogs()
+{
+	Logger::Instance().SetConsole(false);
+}
+
+// 结束时删除的临时目录
+class BenchDir
+{
+public:
+	BenchDir()
+	{
+		auto stamp = BenchClock::now().time_since_epoch().count();
+		m_path = std::filesystem::temp_directory_path() / ("volumelock_bench_" + std::to_string(stamp));
+		std::filesystem::create_directories(m_path);
+	}
+
+	~BenchDir()
+	{
+		std::error_code ec;
+		std::filesystem::remove_all(m_path, ec);
+	}
+
+	BenchDir(const BenchDir&) = delete;
+	BenchDir& operator=(const BenchDir&) = delete;
+
+	std::filesystem::path operator/(std::string_view name) const
+	{
+		return m_path / name;
+	}
+
+private:
+	std::filesystem::path m_path;
+};
+
+inline void WriteFile(const std::filesystem::path& path, std::string_view content)
+{
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write(content.data(), content.size());
+}
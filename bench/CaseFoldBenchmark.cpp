@@ -0,0 +1,67 @@
+﻿// 路径的大小写折叠和比较
+//   折叠：修改前复制字符串后逐个 towlower，与 FoldCase 写入复用的缓冲区对比，ASCII 和中文路径各一种
+//   比较：修改前每次比较两边都转换小写（文件名还要先取 path.filename()），与预先计算好的 FoldedKey 相等比较对比
+// 参数：--iterations 2000000
+
+#include <clocale>
+#include <cwctype>
+#include <filesystem>
+
+#include "CaseFold.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	std::wstring LowerCopy(const std::wstring& s)
+	{
+		std::wstring out(s);
+		for (auto&& c : out)
+		{
+			c = static_cast<wchar_t>(std::towlower(c));
+		}
+		return out;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	// towlower 需要 UTF-8 区域设置才能处理非 ASCII 字符
+	std::setlocale(LC_CTYPE, "C.UTF-8");
+	auto iterations = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--iterations", 2000000)));
+
+	const std::wstring ascii = L"C:\\Program Files (x86)\\Steam\\steamapps\\common\\Some Game Title\\Binaries\\Win64\\Game-Win64-Shipping.exe";
+	const std::wstring chinese = L"D:\\游戏\\原神\\Genshin Impact Game\\YuanShen.exe";
+	for (auto&& [name, path] : { std::pair<const char*, const std::wstring&>{ "ascii", ascii }, { "chinese", chinese } })
+	{
+		std::wstring out;
+		auto copy = MeasureNs(iterations, [&](size_t) { DoNotOptimize(LowerCopy(path)); });
+		auto fold = MeasureNs(iterations, [&](size_t) {
+			FoldCase(path, out);
+			DoNotOptimize(out);
+		});
+		std::printf("fold %-7s (%3zu chars): copy+towlower %6.1f ns  FoldCase %6.1f ns\n", name, path.size(), copy, fold);
+	}
+
+	// 会话路径与规则不同，但长度相同，比较时不能只看长度
+	std::filesystem::path session(L"C:\\Program Files\\Browser\\Application\\browser.exe");
+	std::wstring rulePath = L"C:\\PROGRAM FILES\\BROWSER\\APPLICATION\\BROWSEX.EXE";
+	std::wstring ruleName = L"BROWSEX.EXE";
+	auto oldFull = MeasureNs(iterations, [&](size_t) { DoNotOptimize(LowerCopy(session.wstring()) == LowerCopy(rulePath)); });
+	auto oldName = MeasureNs(iterations, [&](size_t) { DoNotOptimize(LowerCopy(session.filename().wstring()) == LowerCopy(ruleName)); });
+	FoldedKey sessionKey(session.wstring());
+	FoldedKey sessionName(session.filename().wstring());
+	FoldedKey ruleKey(rulePath);
+	FoldedKey ruleNameKey(ruleName);
+	auto newFull = MeasureNs(iterations, [&](size_t) {
+		DoNotOptimize(sessionKey);
+		DoNotOptimize(sessionKey == ruleKey);
+	});
+	auto newName = MeasureNs(iterations, [&](size_t) {
+		DoNotOptimize(sessionName);
+		DoNotOptimize(sessionName == ruleNameKey);
+	});
+	std::printf("compare full path: lower both sides %6.1f ns  FoldedKey %5.2f ns\n", oldFull, newFull);
+	std::printf("compare file name: lower both sides %6.1f ns  FoldedKey %5.2f ns\n", oldName, newName);
+	return 0;
+}
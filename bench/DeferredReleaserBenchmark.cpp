@@ -0,0 +1,90 @@
+﻿// 启动器短时间内断开大量会话时延迟释放的开销
+//   修改前：每个会话一个分离线程，睡眠 --delay-ms 后释放
+//   修改后：投递到 DeferredReleaser，由固定的两个工作线程到期后释放
+// 输出投递一次的耗时、同时存在的线程数和全部释放完的时间
+// 参数：--sessions 500 --delay-ms 1000
+
+#include <thread>
+#include <memory>
+
+#include "DeferredReleaser.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	std::atomic<long> g_alive{ 0 };
+
+	// 代替 Core Audio 会话，只记录存活的数量
+	struct FakeSession
+	{
+		FakeSession()
+		{
+			g_alive++;
+		}
+
+		~FakeSession()
+		{
+			g_alive--;
+		}
+	};
+
+	void WaitReleased()
+	{
+		while (g_alive.load() != 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto sessions = std::max(1L, GetArg(argc, argv, "--sessions", 500));
+	auto delay = std::chrono::milliseconds(GetArg(argc, argv, "--delay-ms", 1000));
+
+	{
+		std::atomic<long> threads{ 0 };
+		long peak = 0;
+		auto start = BenchClock::now();
+		for (long i = 0; i < sessions; i++)
+		{
+			auto session = std::make_shared<FakeSession>();
+			threads++;
+			std::thread([&threads, delay](std::shared_ptr<FakeSession> s) {
+				std::this_thread::sleep_for(delay);
+				s.reset();
+				threads--;
+			}, std::move(session)).detach();
+			peak = std::max(peak, threads.load());
+		}
+		auto posted = BenchClock::now();
+		WaitReleased();
+		auto done = BenchClock::now();
+		// 分离线程在释放后仍要退出，等它们都结束再测量下一种
+		while (threads.load() != 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		// 包括主线程
+		std::printf("detached threads:  post %7.1f us/session  peak threads %4ld  all released after %6.1f ms\n", ElapsedNs(start, posted) / 1e3 / sessions, peak + 1,
+			ElapsedNs(start, done) / 1e6);
+	}
+
+	{
+		DeferredReleaser releaser;
+		auto start = BenchClock::now();
+		for (long i = 0; i < sessions; i++)
+		{
+			releaser.Release(std::make_shared<FakeSession>(), delay);
+		}
+		auto posted = BenchClock::now();
+		WaitReleased();
+		auto done = BenchClock::now();
+		auto stats = releaser.GetStats();
+		// 主线程和默认的两个工作线程
+		std::printf("DeferredReleaser:  post %7.1f us/session  peak threads %4d  all released after %6.1f ms  max latency %.2f ms\n", ElapsedNs(start, posted) / 1e3 / sessions, 3,
+			ElapsedNs(start, done) / 1e6, std::chrono::duration<double, std::milli>(stats.MaxLatency).count());
+	}
+	return 0;
+}
@@ -0,0 +1,129 @@
+﻿// EventLoop 的投递吞吐：1/2/4 个生产者线程各投递 --events 个空任务，到全部在循环线程上执行完毕的耗时
+// 对照组是原来的做法：std::mutex 保护的 std::deque 加条件变量
+// 参数：--events 200000 --repeat 3
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <vector>
+
+#include "EventLoop.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	// 加锁队列的单线程循环，接口与 EventLoop 的 Post 相同
+	class MutexLoop
+	{
+	public:
+		MutexLoop()
+			: m_thread([this]() { Run(); })
+		{
+		}
+
+		~MutexLoop()
+		{
+			{
+				std::lock_guard lock(m_mutex);
+				m_stop = true;
+			}
+			m_cv.notify_one();
+			m_thread.join();
+		}
+
+		void Post(std::function<void()> task)
+		{
+			{
+				std::lock_guard lock(m_mutex);
+				m_tasks.push_back(std::move(task));
+			}
+			m_cv.notify_one();
+		}
+
+	private:
+		void Run()
+		{
+			std::unique_lock lock(m_mutex);
+			while (true)
+			{
+				m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+				if (m_stop)
+				{
+					return;
+				}
+				auto task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+				lock.unlock();
+				task();
+				lock.lock();
+			}
+		}
+
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::deque<std::function<void()>> m_tasks;
+		bool m_stop = false;
+		std::thread m_thread;
+	};
+
+	// 返回每秒执行的任务数
+	template <typename Loop>
+	double Run(Loop& loop, long producers, long events)
+	{
+		uint64_t count = 0;
+		auto start = BenchClock::now();
+		std::vector<std::thread> threads;
+		for (long p = 0; p < producers; p++)
+		{
+			threads.emplace_back([&]() {
+				for (long i = 0; i < events; i++)
+				{
+					loop.Post([&count]() { count++; });
+				}
+			});
+		}
+		for (auto&& t : threads)
+		{
+			t.join();
+		}
+		std::promise<void> done;
+		loop.Post([&done]() { done.set_value(); });
+		done.get_future().wait();
+		auto ns = ElapsedNs(start, BenchClock::now());
+		DoNotOptimize(count);
+		return static_cast<double>(producers * events) / (ns / 1e9);
+	}
+
+	template <typename Loop>
+	double Best(long producers, long events, long repeat, Loop& loop)
+	{
+		double best = 0;
+		for (long r = 0; r < repeat; r++)
+		{
+			best = std::max(best, Run(loop, producers, events));
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto events = GetArg(argc, argv, "--events", 200000);
+	auto repeat = std::max(1L, GetArg(argc, argv, "--repeat", 3));
+	std::printf("events per producer=%ld repeat=%ld hardware threads=%u\n", events, repeat, std::thread::hardware_concurrency());
+
+	EventLoop loop;
+	loop.Start();
+	MutexLoop baseline;
+	for (long producers : { 1L, 2L, 4L })
+	{
+		auto lockFree = Best(producers, events, repeat, loop);
+		auto locked = Best(producers, events, repeat, baseline);
+		std::printf("producers=%ld  EventLoop %.2f M tasks/s  mutex+deque %.2f M tasks/s  (%.2fx)\n", producers, lockFree / 1e6, locked / 1e6, lockFree / locked);
+	}
+	return 0;
+}
@@ -0,0 +1,61 @@
+﻿// 通配符与等价的 std::wregex（ECMAScript | icase）对比
+//   匹配：每个模式各测一个命中和一个不命中的路径，通配符的输入是预先折叠好的路径，与 RuleIndex 中相同
+//   编译：加载配置时每条规则编译一次
+// 参数：--iterations 20000
+
+#include <regex>
+
+#include "Glob.h"
+#include "CaseFold.h"
+#include "BenchUtil.h"
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto iterations = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--iterations", 20000)));
+
+	struct Case
+	{
+		std::wstring Glob;
+		std::wstring Regex;
+		std::wstring Hit;
+		std::wstring Miss;
+	};
+	const Case cases[] = {
+		{
+			L"**\\steamapps\\common\\*\\*.exe",
+			L"(.*[\\\\/])?steamapps[\\\\/]common[\\\\/][^\\\\/]*[\\\\/][^\\\\/]*\\.exe",
+			L"D:\\SteamLibrary\\steamapps\\common\\Some Game Title\\Game-Win64-Shipping.exe",
+			L"D:\\SteamLibrary\\steamapps\\common\\Some Game Title\\Binaries\\Win64\\Game.exe",
+		},
+		{
+			L"C:\\Program Files*\\**\\*[Pp]layer*.exe",
+			L"C:[\\\\/]Program Files[^\\\\/]*[\\\\/](.*[\\\\/])?[^\\\\/]*[Pp]layer[^\\\\/]*\\.exe",
+			L"C:\\Program Files (x86)\\VideoLAN\\VLC\\MediaPlayer.exe",
+			L"C:\\Program Files (x86)\\Microsoft\\Edge\\Application\\msedge.exe",
+		},
+	};
+
+	for (auto&& c : cases)
+	{
+		Glob glob(c.Glob);
+		std::wregex re(c.Regex, std::regex::ECMAScript | std::regex::icase);
+		for (auto&& [name, path] : { std::pair<const char*, const std::wstring&>{ "hit", c.Hit }, { "miss", c.Miss } })
+		{
+			auto folded = FoldCase(path);
+			auto expected = std::regex_match(path, re);
+			if (glob.Match(folded) != expected || expected != (std::string_view(name) == "hit"))
+			{
+				std::printf("mismatch for %ls on %s\n", c.Glob.c_str(), name);
+				return 1;
+			}
+			auto globNs = MeasureNs(iterations * 10, [&](size_t) { DoNotOptimize(glob.Match(folded)); });
+			auto regexNs = MeasureNs(iterations, [&](size_t) { DoNotOptimize(std::regex_match(path, re)); });
+			std::printf("%-40ls %-4s: glob %6.2f us  wregex %6.2f us  (%.0fx)\n", c.Glob.c_str(), name, globNs / 1e3, regexNs / 1e3, regexNs / globNs);
+		}
+		auto compileGlob = MeasureNs(iterations, [&](size_t) { DoNotOptimize(Glob(c.Glob)); });
+		auto compileRegex = MeasureNs(iterations, [&](size_t) { DoNotOptimize(std::wregex(c.Regex, std::regex::ECMAScript | std::regex::icase)); });
+		std::printf("%-40ls compile: glob %6.2f us  wregex %6.2f us\n", c.Glob.c_str(), compileGlob / 1e3, compileRegex / 1e3);
+	}
+	return 0;
+}
@@ -0,0 +1,167 @@
+﻿// VolumeLock 在模拟后端上的负载基准
+//   启动：设备上已有 --sessions 个会话时创建 VolumeLock，到全部处理完毕的吞吐
+//   新增：运行期间连续添加 --sessions 个会话的吞吐
+//   延迟：其他程序修改目标会话音量，到纠正写入（SimContext::OnWrite）的耗时，逐个测量 --events 次
+//   突发：--threads 个线程同时修改所有目标会话的音量，到全部纠正完毕的吞吐
+// 参数：--sessions 10000 --devices 4 --rules 200 --events 2000 --threads 4 --set-latency-us 0 --debounce-ms 0
+
+#include <thread>
+#include <memory>
+#include <vector>
+#include <string>
+
+#include "VolumeLock.h"
+#include "AudioSimulator.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	std::atomic<uint64_t> g_writes{ 0 };
+	std::atomic<int64_t> g_lastWriteNs{ 0 };
+
+	int64_t NowNs()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now().time_since_epoch()).count();
+	}
+
+	void WaitWrites(uint64_t target)
+	{
+		auto deadline = BenchClock::now() + std::chrono::seconds(30);
+		while (g_writes.load() < target && BenchClock::now() < deadline)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	std::string MakeConfig(long rules)
+	{
+		std::string yaml;
+		for (long i = 0; i < rules; i++)
+		{
+			yaml += "- {type: filename, path: target" + std::to_string(i) + ".exe, volume: 30}\n";
+		}
+		yaml += "- {type: regex, path: '.*/tools/.+\\.exe', volume: 40}\n";
+		return yaml;
+	}
+
+	// 偶数号为目标会话，需要从 80 纠正到 30；奇数号不是目标，每 10 个中有一个需要恢复到 100
+	std::shared_ptr<SimAudioSession> AddSession(SimAudioDevice& device, long i, long rules)
+	{
+		auto pid = static_cast<uint32_t>(1000 + i);
+		auto dir = "/apps/app" + std::to_string(i) + "/";
+		if (i % 2 == 0)
+		{
+			return device.AddSession(pid, dir + "target" + std::to_string(i / 2 % rules) + ".exe", 80);
+		}
+		return device.AddSession(pid, dir + "player" + std::to_string(i) + ".exe", i % 20 == 1 ? 60 : 100);
+	}
+
+	void Report(const char* name, long sessions, BenchClock::time_point start, BenchClock::time_point end, uint64_t writes)
+	{
+		auto ms = ElapsedNs(start, end) / 1e6;
+		std::printf("%-9s: %ld sessions in %.1f ms (%.0f sessions/s), %llu writes\n", name, sessions, ms, sessions / (ms / 1e3), static_cast<unsigned long long>(writes));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto sessions = GetArg(argc, argv, "--sessions", 10000);
+	auto devices = std::max(1L, GetArg(argc, argv, "--devices", 4));
+	auto rules = std::max(1L, GetArg(argc, argv, "--rules", 200));
+	auto events = GetArg(argc, argv, "--events", 2000);
+	auto threads = std::max(1L, GetArg(argc, argv, "--threads", 4));
+	auto setLatency = GetArg(argc, argv, "--set-latency-us", 0);
+	auto debounce = GetArg(argc, argv, "--debounce-ms", 0);
+	std::printf("sessions=%ld devices=%ld rules=%ld set-latency=%ldus debounce=%ldms\n", sessions, devices, rules, setLatency, debounce);
+
+	BenchDir dir;
+	WriteFile(dir / "config.yaml", MakeConfig(rules));
+
+	SimContext context;
+	context.Latency.SetVolume = std::chrono::microseconds(setLatency);
+	context.OnWrite = [](const std::shared_ptr<SimAudioSession>&, int) {
+		g_lastWriteNs.store(NowNs());
+		g_writes++;
+	};
+	SimAudioDeviceEnumerator enumerator(context);
+	std::vector<std::shared_ptr<SimAudioDevice>> simDevices;
+	for (long i = 0; i < devices; i++)
+	{
+		simDevices.push_back(enumerator.AddDevice(L"dev" + std::to_wstring(i), L"Device " + std::to_wstring(i)));
+	}
+
+	std::vector<std::shared_ptr<SimAudioSession>> targets;
+	for (long i = 0; i < sessions; i++)
+	{
+		auto session = AddSession(*simDevices[i % devices], i, rules);
+		if (i % 2 == 0)
+		{
+			targets.push_back(session);
+		}
+	}
+
+	auto start = BenchClock::now();
+	VolumeLock lock(enumerator, dir / "config.yaml", std::chrono::milliseconds(debounce));
+	lock.Drain();
+	auto end = BenchClock::now();
+	Report("startup", sessions, start, end, g_writes.load());
+
+	auto before = g_writes.load();
+	start = BenchClock::now();
+	for (long i = sessions; i < 2 * sessions; i++)
+	{
+		auto session = AddSession(*simDevices[i % devices], i, rules);
+		if (i % 2 == 0)
+		{
+			targets.push_back(session);
+		}
+	}
+	lock.Drain();
+	end = BenchClock::now();
+	Report("live add", sessions, start, end, g_writes.load() - before);
+
+	// 逐个测量，同一时间只有一个事件在处理
+	std::vector<double> latencies;
+	latencies.reserve(events);
+	for (long i = 0; i < events && !targets.empty(); i++)
+	{
+		auto&& session = targets[i % targets.size()];
+		auto expected = g_writes.load() + 1;
+		auto t0 = NowNs();
+		session->ChangeVolume(90);
+		WaitWrites(expected);
+		latencies.push_back(static_cast<double>(g_lastWriteNs.load() - t0));
+	}
+	if (!latencies.empty())
+	{
+		std::printf("latency  : n=%zu p50=%.1fus p90=%.1fus p99=%.1fus max=%.1fus\n", latencies.size(),
+			Percentile(latencies, 0.5) / 1e3, Percentile(latencies, 0.9) / 1e3, Percentile(latencies, 0.99) / 1e3, Percentile(latencies, 1.0) / 1e3);
+	}
+
+	// 每个目标会话一个事件，分给多个线程同时发出
+	auto expected = g_writes.load() + targets.size();
+	start = BenchClock::now();
+	{
+		std::vector<std::thread> producers;
+		for (long t = 0; t < threads; t++)
+		{
+			producers.emplace_back([&, t]() {
+				for (size_t i = t; i < targets.size(); i += threads)
+				{
+					targets[i]->ChangeVolume(85);
+				}
+			});
+		}
+		for (auto&& p : producers)
+		{
+			p.join();
+		}
+	}
+	WaitWrites(expected);
+	end = BenchClock::now();
+	auto ms = ElapsedNs(start, end) / 1e6;
+	std::printf("burst    : %zu events from %ld threads in %.1f ms (%.0f events/s), %llu of %zu corrected\n", targets.size(), threads, ms, targets.size() / (ms / 1e3),
+		static_cast<unsigned long long>(g_writes.load() - (expected - targets.size())), targets.size());
+	return 0;
+}
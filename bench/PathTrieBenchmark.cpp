@@ -0,0 +1,78 @@
+﻿// 目录前缀规则的匹配，--infos 个进程（一半位于某条规则的目录下，一半不匹配）
+//   前缀：N 条 Prefix 规则 D:\Games\GameN
+//   正则：等价的 N 条 Regex 规则 D:\\Games\\GameN(\\.*)?
+// 两者都通过 RuleIndex 查找，同时给出构建索引的耗时
+// 参数：--infos 1000 --rounds 20
+
+#include <random>
+
+#include "RuleIndex.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	using Type = ConfigItem::PathType;
+
+	std::vector<ConfigItem> MakeRules(size_t count, bool prefix)
+	{
+		std::vector<ConfigItem> configs;
+		for (size_t i = 0; i < count; i++)
+		{
+			auto n = std::to_wstring(i);
+			if (prefix)
+			{
+				configs.push_back({ Type::Prefix, L"D:\\Games\\Game" + n, 30 });
+			}
+			else
+			{
+				configs.push_back({ Type::Regex, L"D:\\\\Games\\\\Game" + n + L"(\\\\.*)?", 30 });
+			}
+		}
+		return configs;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto infoCount = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--infos", 1000)));
+	auto rounds = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--rounds", 20)));
+
+	for (size_t count : { 100, 1000, 5000 })
+	{
+		std::mt19937 rng(static_cast<uint32_t>(count));
+		std::vector<std::shared_ptr<const ProcessInfo>> infos;
+		for (size_t i = 0; i < infoCount; i++)
+		{
+			auto n = std::to_wstring(rng() % count);
+			std::wstring path = i % 2 ? L"D:\\Games\\Game" + n + L"\\Binaries\\Win64\\Game.exe" : L"D:\\GamesOld\\Game" + n + L"\\Game.exe";
+			infos.push_back(ProcessInfoCache::MakeInfo(static_cast<uint32_t>(i), 0, path));
+		}
+
+		auto start = BenchClock::now();
+		RuleIndex prefix(MakeRules(count, true));
+		auto prefixBuild = ElapsedNs(start, BenchClock::now());
+		start = BenchClock::now();
+		RuleIndex regex(MakeRules(count, false));
+		auto regexBuild = ElapsedNs(start, BenchClock::now());
+
+		size_t prefixHits = 0;
+		size_t regexHits = 0;
+		for (auto&& info : infos)
+		{
+			prefixHits += prefix.Find(*info) != nullptr;
+			regexHits += regex.Find(*info) != nullptr;
+		}
+		if (prefixHits != regexHits)
+		{
+			std::printf("mismatch for %zu rules: prefix %zu hits, regex %zu hits\n", count, prefixHits, regexHits);
+			return 1;
+		}
+
+		auto prefixNs = MeasureNs(rounds * infos.size(), [&](size_t i) { DoNotOptimize(prefix.Find(*infos[i % infos.size()])); });
+		auto regexNs = MeasureNs(std::max<size_t>(1, rounds / 4) * infos.size(), [&](size_t i) { DoNotOptimize(regex.Find(*infos[i % infos.size()])); });
+		std::printf("%4zu rules: prefix %7.1f ns  regex %8.1f ns per lookup  (build %6.2f ms vs %7.2f ms, %zu hits)\n",
+			count, prefixNs, regexNs, prefixBuild / 1e6, regexBuild / 1e6, prefixHits);
+	}
+	return 0;
+}
@@ -0,0 +1,74 @@
+﻿// 会话创建时查询进程信息，模拟的查询接口用忙等待表示系统调用的耗时
+//   不缓存：每次都查询启动时间和路径，再构造 ProcessInfo（包括大小写折叠）
+//   缓存命中：ProcessInfoCache::Get，仍要查询一次启动时间以识别 pid 复用
+// 默认耗时参考 OpenProcess + GetProcessTimes 和 QueryFullProcessImageName 的量级，设为 0 时只测缓存本身的开销
+// 参数：--iterations 200000 --pids 200 --start-ns 2000 --path-ns 20000
+
+#include "ProcessInfoCache.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	void Spin(std::chrono::nanoseconds duration)
+	{
+		auto end = BenchClock::now() + duration;
+		while (BenchClock::now() < end)
+		{
+		}
+	}
+
+	class SlowResolver : public ProcessResolver
+	{
+	public:
+		SlowResolver(std::chrono::nanoseconds startCost, std::chrono::nanoseconds pathCost) : m_startCost(startCost), m_pathCost(pathCost)
+		{
+		}
+
+		virtual std::optional<uint64_t> GetStartTime(uint32_t pid) override
+		{
+			Spin(m_startCost);
+			return 1000 + pid;
+		}
+
+		virtual std::optional<std::wstring> GetImagePath(uint32_t pid) override
+		{
+			Spin(m_pathCost);
+			return L"C:\\Program Files (x86)\\Steam\\steamapps\\common\\Game" + std::to_wstring(pid) + L"\\Binaries\\Win64\\Game.exe";
+		}
+
+	private:
+		std::chrono::nanoseconds m_startCost;
+		std::chrono::nanoseconds m_pathCost;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto iterations = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--iterations", 200000)));
+	auto pids = static_cast<uint32_t>(std::max(1L, GetArg(argc, argv, "--pids", 200)));
+	auto startCost = std::chrono::nanoseconds(std::max(0L, GetArg(argc, argv, "--start-ns", 2000)));
+	auto pathCost = std::chrono::nanoseconds(std::max(0L, GetArg(argc, argv, "--path-ns", 20000)));
+
+	for (auto&& [name, start, path] : { std::tuple{ "no resolver cost", std::chrono::nanoseconds(0), std::chrono::nanoseconds(0) }, std::tuple{ "simulated syscalls", startCost, pathCost } })
+	{
+		auto resolver = std::make_shared<SlowResolver>(start, path);
+		ProcessInfoCache cache(resolver);
+		for (uint32_t pid = 1; pid <= pids; pid++)
+		{
+			cache.Get(pid);
+		}
+		// 有耗时时迭代次数相应减少
+		auto n = start.count() + path.count() > 0 ? std::max<size_t>(1, iterations / 20) : iterations;
+		auto uncached = MeasureNs(n, [&](size_t i) {
+			auto pid = static_cast<uint32_t>(1 + i % pids);
+			auto startTime = resolver->GetStartTime(pid);
+			DoNotOptimize(ProcessInfoCache::MakeInfo(pid, startTime.value_or(0), resolver->GetImagePath(pid).value_or(std::wstring())));
+		});
+		auto cached = MeasureNs(n, [&](size_t i) { DoNotOptimize(cache.Get(static_cast<uint32_t>(1 + i % pids))); });
+		auto stats = cache.GetStats();
+		std::printf("%-18s: uncached %8.1f ns  cache hit %8.1f ns  (%.1fx, %llu hits, %llu misses)\n", name, uncached, cached, uncached / cached,
+			static_cast<unsigned long long>(stats.Hits), static_cast<unsigned long long>(stats.Misses));
+	}
+	return 0;
+}
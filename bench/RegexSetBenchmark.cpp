@@ -0,0 +1,89 @@
+﻿// 正则规则的匹配，10、100、1000 条表达式
+//   逐条：每条预先编译为 std::wregex，依次 regex_match，即修改前 RuleIndex 的做法
+//   合并：RegexSet::Match，第一次计时前先匹配一遍，使 DFA 状态已经构建好
+// 输入为命中最后一条和都不命中的路径，两种情况逐条匹配都要检查所有表达式
+// 参数：--iterations 20000
+
+#include <regex>
+
+#include "RegexSet.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	std::vector<std::wstring> MakePatterns(size_t count)
+	{
+		std::vector<std::wstring> patterns;
+		for (size_t i = 0; i < count; i++)
+		{
+			auto n = std::to_wstring(i);
+			switch (i % 4)
+			{
+			case 0:
+				patterns.push_back(L".*/Vendor" + n + L"/.+\\.exe");
+				break;
+			case 1:
+				patterns.push_back(L".*/(game|launcher)" + n + L"\\.exe");
+				break;
+			case 2:
+				patterns.push_back(L"/opt/[a-z]+/tool" + n + L"-\\d+\\.exe");
+				break;
+			default:
+				patterns.push_back(L".*\\\\app" + n + L"_(x86|x64)?\\.exe");
+				break;
+			}
+		}
+		return patterns;
+	}
+
+	size_t MatchLoop(const std::vector<std::wregex>& regexes, const std::wstring& s)
+	{
+		for (size_t i = 0; i < regexes.size(); i++)
+		{
+			if (std::regex_match(s, regexes[i]))
+			{
+				return i;
+			}
+		}
+		return RegexSet::npos;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto iterations = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--iterations", 20000)));
+
+	for (size_t count : { 10, 100, 1000 })
+	{
+		auto patterns = MakePatterns(count);
+		std::vector<std::wregex> regexes;
+		RegexSet set;
+		for (size_t i = 0; i < patterns.size(); i++)
+		{
+			regexes.emplace_back(patterns[i], std::regex::ECMAScript | std::regex::icase);
+			if (!set.Add(patterns[i], i))
+			{
+				std::printf("pattern %zu is not supported\n", i);
+				return 1;
+			}
+		}
+
+		// 规则数为 4 的倍数，最后一条总是 \app<n>_... 的形式
+		std::wstring last = L"C:\\Program Files\\App\\APP" + std::to_wstring(count - 1) + L"_x64.exe";
+		std::wstring miss = L"C:\\Program Files\\Browser\\browser.exe";
+		for (auto&& [name, path] : { std::pair<const char*, const std::wstring&>{ "last rule", last }, { "no match", miss } })
+		{
+			if (MatchLoop(regexes, path) != set.Match(path))
+			{
+				std::printf("mismatch for %s\n", name);
+				return 1;
+			}
+			auto loopIterations = std::max<size_t>(1, iterations / count);
+			auto loop = MeasureNs(loopIterations, [&](size_t) { DoNotOptimize(MatchLoop(regexes, path)); });
+			auto merged = MeasureNs(iterations, [&](size_t) { DoNotOptimize(set.Match(path)); });
+			std::printf("%4zu patterns, %-9s: std::regex loop %9.2f us  RegexSet %6.3f us  (%.0fx)\n", count, name, loop / 1e3, merged / 1e3, loop / merged);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,99 @@
+﻿// 用 --replay --fast 的方式重现合成的事件记录，计时包括等待 VolumeLock 处理完所有事件
+//   只有后端：不创建 VolumeLock，只测模拟后端发出事件的开销
+//   不合并：debounce 为 0，每个音量事件都会纠正
+//   默认合并：VolumeLock::DefaultDebounce
+// 初始状态为若干设备，每个设备上一半会话是目标；事件为随机会话的音量变化，每隔一段切换一次默认设备
+// 目标会话的音量被反复修改，很快会被当作争夺而限流，写入次数主要反映限流和合并的效果
+// 参数：--events 200000 --devices 4 --sessions 50 --switch-every 1000
+
+#include <random>
+
+#include "EventTrace.h"
+#include "TraceReplay.h"
+#include "VolumeLock.h"
+#include "AudioSimulator.h"
+#include "BenchUtil.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	TraceRecord MakeRecord(uint64_t time, TraceKind kind, uint32_t pid, uint64_t device, int32_t volume)
+	{
+		return TraceRecord{ time, kind, pid, 0, device, volume, 0 };
+	}
+
+	Trace MakeTrace(size_t events, uint32_t devices, uint32_t sessions, size_t switchEvery)
+	{
+		Trace trace;
+		for (uint32_t d = 1; d <= devices; d++)
+		{
+			trace.Initial.push_back(MakeRecord(0, TraceKind::DeviceAdded, 0, d, 0));
+			for (uint32_t s = 0; s < sessions; s++)
+			{
+				auto pid = d * 10000 + s;
+				trace.Initial.push_back(MakeRecord(0, TraceKind::SessionAdded, pid, d, 100));
+				trace.Processes[{ pid, 0 }] = "/apps/" + std::string(s % 2 == 0 ? "game" : "tool") + std::to_string(s) + ".exe";
+			}
+		}
+		trace.Initial.push_back(MakeRecord(0, TraceKind::DefaultDeviceChanged, 0, 1, 0));
+
+		std::mt19937 rng(1);
+		for (size_t i = 0; i < events; i++)
+		{
+			auto time = static_cast<uint64_t>(i) * 1000;
+			if (switchEvery > 0 && i % switchEvery == switchEvery - 1)
+			{
+				trace.Events.push_back(MakeRecord(time, TraceKind::DefaultDeviceChanged, 0, 1 + rng() % devices, 0));
+				continue;
+			}
+			auto device = 1 + rng() % devices;
+			trace.Events.push_back(MakeRecord(time, TraceKind::VolumeChanged, device * 10000 + rng() % sessions, device, static_cast<int32_t>(rng() % 101)));
+		}
+		return trace;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto events = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--events", 200000)));
+	auto devices = static_cast<uint32_t>(std::max(1L, GetArg(argc, argv, "--devices", 4)));
+	auto sessions = static_cast<uint32_t>(std::max(1L, GetArg(argc, argv, "--sessions", 50)));
+	auto switchEvery = static_cast<size_t>(std::max(0L, GetArg(argc, argv, "--switch-every", 1000)));
+
+	BenchDir dir;
+	auto configpath = dir / "config.yaml";
+	WriteFile(configpath, "- {type: regex, path: '.*/game[0-9]+\\.exe', volume: 20}\n");
+	auto trace = MakeTrace(events, devices, sessions, switchEvery);
+
+	for (auto&& [name, debounce] : { std::pair{ "backend only", std::chrono::milliseconds(-1) }, std::pair{ "no debounce", 0ms }, std::pair{ "default debounce", VolumeLock::DefaultDebounce } })
+	{
+		std::atomic<uint64_t> writes{ 0 };
+		SimContext context;
+		context.OnWrite = [&writes](const std::shared_ptr<SimAudioSession>&, int) { writes++; };
+		SimAudioDeviceEnumerator enumerator(context);
+		TraceReplayer replayer(trace, enumerator);
+		replayer.ApplyInitialState();
+
+		ReplayStats stats;
+		if (debounce.count() < 0)
+		{
+			stats = replayer.Run(false);
+		}
+		else
+		{
+			VolumeLock lock(enumerator, configpath, debounce);
+			lock.Drain();
+			writes = 0;
+			auto start = BenchClock::now();
+			stats = replayer.Run(false);
+			lock.Drain();
+			stats.Elapsed = BenchClock::now() - start;
+		}
+		auto seconds = std::chrono::duration<double>(stats.Elapsed).count();
+		std::printf("%-16s %8zu events  %7.1f ms  %9.0f events/s  writes %7llu  skipped %zu\n", name, stats.Events, seconds * 1000, stats.Events / seconds,
+			static_cast<unsigned long long>(writes.load()), stats.Skipped);
+	}
+	return 0;
+}
@@ -0,0 +1,108 @@
+﻿// 新会话的规则匹配，--rules 条规则（45% 完整路径、45% 文件名、10% 正则）
+//   逐条：修改前的 GetConfig，每次都转换大小写并重新编译正则
+//   索引：RuleIndex::Find
+// 分别测量命中最后一条规则和都不命中的路径，后者是大多数会话的情况
+// 参数：--iterations 2000
+
+#include <cwctype>
+
+#include "RuleIndex.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	using Type = ConfigItem::PathType;
+
+	std::wstring Lower(std::wstring s)
+	{
+		for (auto&& c : s)
+		{
+			c = static_cast<wchar_t>(std::towlower(c));
+		}
+		return s;
+	}
+
+	const ConfigItem* FindLinear(const std::vector<ConfigItem>& configs, const std::filesystem::path& path)
+	{
+		for (auto&& item : configs)
+		{
+			if (item.Type == Type::FullPath)
+			{
+				if (Lower(path.wstring()) == Lower(item.Path))
+				{
+					return &item;
+				}
+			}
+			else if (item.Type == Type::FileName)
+			{
+				if (Lower(path.filename().wstring()) == Lower(item.Path))
+				{
+					return &item;
+				}
+			}
+			else if (item.Type == Type::Regex)
+			{
+				if (std::regex_match(path.wstring(), std::wregex(item.Path, std::regex::ECMAScript | std::regex::icase)))
+				{
+					return &item;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	std::vector<ConfigItem> MakeRules(size_t count)
+	{
+		std::vector<ConfigItem> configs;
+		for (size_t i = 0; i < count; i++)
+		{
+			auto n = std::to_wstring(i);
+			if (i % 10 == 9)
+			{
+				configs.push_back({ Type::Regex, L".*/vendor" + n + L"/.+\\.exe", 40 });
+			}
+			else if (i % 2 == 0)
+			{
+				configs.push_back({ Type::FullPath, L"/Games/Game" + n + L"/Game" + n + L".exe", 30 });
+			}
+			else
+			{
+				configs.push_back({ Type::FileName, L"Player" + n + L".exe", 20 });
+			}
+		}
+		return configs;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto iterations = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--iterations", 2000)));
+
+	for (size_t count : { 10, 100, 500 })
+	{
+		auto configs = MakeRules(count);
+		RuleIndex index(configs);
+		// 规则数为 10 的倍数，最后一条总是正则
+		std::filesystem::path last(L"/opt/Vendor" + std::to_wstring(count - 1) + L"/app.exe");
+		std::filesystem::path miss(L"/Program Files/Browser/browser.exe");
+
+		for (auto&& [name, path] : { std::pair<const char*, const std::filesystem::path&>{ "last rule", last }, { "no match", miss } })
+		{
+			// 索引持有规则的副本，比较规则内容
+			auto expected = FindLinear(configs, path);
+			auto actual = index.Find(path);
+			if ((expected == nullptr) != (actual == nullptr) || (expected && *expected != *actual))
+			{
+				std::printf("mismatch for %s\n", name);
+				return 1;
+			}
+			// 逐条匹配要为每条正则重新编译，次数相应减少
+			auto linearIterations = std::max<size_t>(1, iterations / count);
+			auto linear = MeasureNs(linearIterations, [&](size_t) { DoNotOptimize(FindLinear(configs, path)); });
+			auto indexed = MeasureNs(iterations * 100, [&](size_t) { DoNotOptimize(index.Find(path)); });
+			std::printf("%3zu rules, %-9s: linear %10.1f us  index %7.3f us  (%.0fx)\n", count, name, linear / 1e3, indexed / 1e3, linear / indexed);
+		}
+	}
+	return 0;
+}
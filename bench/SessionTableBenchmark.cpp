@@ -0,0 +1,89 @@
+﻿// 目标会话的查找和增删，10、100、10000 个会话
+//   修改前：set<shared_ptr<AudioSession>> 判断是否目标会话，map<pid, int> 取目标音量，每次音量事件查两次
+//   修改后：SessionTable::Get，一次查找得到会话的全部状态
+// 查找按随机顺序进行，增删为依次插入全部会话再全部删除
+// 参数：--lookups 2000000
+
+#include <set>
+#include <map>
+#include <random>
+
+#include "SessionTable.h"
+#include "AudioSimulator.h"
+#include "BenchUtil.h"
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto lookups = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--lookups", 2000000)));
+
+	SimAudioDeviceEnumerator enumerator;
+	auto device = enumerator.AddDevice(L"dev", L"Speakers");
+	for (size_t count : { 10, 100, 10000 })
+	{
+		std::vector<std::shared_ptr<AudioSession>> sessions;
+		for (size_t i = 0; i < count; i++)
+		{
+			sessions.push_back(device->AddSession(static_cast<uint32_t>(1000 + i), "/apps/app" + std::to_string(i) + ".exe"));
+		}
+		std::vector<uint32_t> order(lookups);
+		std::mt19937 rng(1);
+		for (auto&& i : order)
+		{
+			i = static_cast<uint32_t>(rng() % count);
+		}
+
+		std::set<std::shared_ptr<AudioSession>> targets;
+		std::map<uint32_t, int> pidToVolume;
+		SessionTable table;
+		for (auto&& s : sessions)
+		{
+			targets.insert(s);
+			pidToVolume[s->GetProcessId()] = 20;
+			table.Insert(s, device, 20);
+		}
+
+		auto old = MeasureNs(lookups, [&](size_t i) {
+			auto& s = sessions[order[i]];
+			if (targets.find(s) != targets.end())
+			{
+				DoNotOptimize(pidToVolume.find(s->GetProcessId())->second);
+			}
+		});
+		auto flat = MeasureNs(lookups, [&](size_t i) { DoNotOptimize(table.Get(sessions[order[i]])->TargetVolume); });
+
+		auto rounds = std::max<size_t>(1, 200000 / count);
+		auto oldChurn = MeasureNs(rounds, [&](size_t) {
+			std::set<std::shared_ptr<AudioSession>> t;
+			std::map<uint32_t, int> v;
+			for (auto&& s : sessions)
+			{
+				t.insert(s);
+				v[s->GetProcessId()] = 20;
+			}
+			for (auto&& s : sessions)
+			{
+				t.erase(s);
+				v.erase(s->GetProcessId());
+			}
+		}) / count;
+		auto flatChurn = MeasureNs(rounds, [&](size_t) {
+			SessionTable t;
+			for (auto&& s : sessions)
+			{
+				t.Insert(s, device, 20);
+			}
+			for (auto&& s : sessions)
+			{
+				t.Erase(t.Find(s.get()));
+			}
+		}) / count;
+
+		std::printf("%5zu sessions: lookup set+map %6.1f ns  table %5.1f ns  |  insert+erase set+map %6.1f ns  table %5.1f ns\n", count, old, flat, oldChurn, flatChurn);
+		for (auto&& s : sessions)
+		{
+			device->RemoveSession(std::static_pointer_cast<SimAudioSession>(s));
+		}
+	}
+	return 0;
+}
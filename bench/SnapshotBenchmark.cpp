@@ -0,0 +1,85 @@
+﻿// 启动时加载规则的耗时：解析 config.yaml（并写入快照）与直接读取快照的对比，另外给出建立 RuleIndex 的耗时
+// 规则数为 100/1000/10000，文件名、完整路径、前缀、通配符、正则各占一部分
+// 参数：--repeat 20
+
+#include <vector>
+#include <functional>
+
+#include "Config.h"
+#include "RuleIndex.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	std::string MakeConfig(long rules)
+	{
+		std::string yaml;
+		for (long i = 0; i < rules; i++)
+		{
+			auto n = std::to_string(i);
+			switch (i % 5)
+			{
+			case 0:
+				yaml += "- {type: filename, path: game" + n + ".exe, volume: 20}\n";
+				break;
+			case 1:
+				yaml += "- {type: fullpath, path: 'C:\\Program Files\\App" + n + "\\app.exe', volume: 30}\n";
+				break;
+			case 2:
+				yaml += "- {type: prefix, path: 'D:\\Games\\Studio" + n + "', volume: 40}\n";
+				break;
+			case 3:
+				yaml += "- {type: glob, path: '**\\vendor" + n + "\\*.exe', volume: 50}\n";
+				break;
+			default:
+				yaml += "- {type: regex, path: '.*\\\\tool" + n + "_[0-9]+\\.exe', volume: 60}\n";
+				break;
+			}
+		}
+		return yaml;
+	}
+
+	double MedianMs(long repeat, const std::function<void()>& fn)
+	{
+		std::vector<double> samples;
+		for (long r = 0; r < repeat; r++)
+		{
+			auto start = BenchClock::now();
+			fn();
+			samples.push_back(ElapsedNs(start, BenchClock::now()) / 1e6);
+		}
+		return Percentile(samples, 0.5);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto repeat = std::max(1L, GetArg(argc, argv, "--repeat", 20));
+	std::printf("repeat=%ld, median of runs\n", repeat);
+
+	for (long rules : { 100L, 1000L, 10000L })
+	{
+		BenchDir dir;
+		auto config = dir / "config.yaml";
+		auto cache = dir / "config.yaml.cache";
+		WriteFile(config, MakeConfig(rules));
+
+		// 每次先删除快照，走解析 YAML 并重新写入快照的路径，即配置修改后第一次启动
+		auto yaml = MedianMs(repeat, [&]() {
+			std::filesystem::remove(cache);
+			DoNotOptimize(LoadConfig(config));
+		});
+		auto snapshot = MedianMs(repeat, [&]() {
+			DoNotOptimize(LoadConfig(config));
+		});
+		auto configs = LoadConfig(config);
+		auto index = MedianMs(repeat, [&]() {
+			RuleIndex rules(configs);
+			DoNotOptimize(rules);
+		});
+		std::printf("rules=%-6ld yaml %8.2f ms  snapshot %7.2f ms  (%.1fx)  RuleIndex %7.2f ms  snapshot size %ju bytes\n", rules, yaml, snapshot, yaml / snapshot, index,
+			static_cast<uintmax_t>(std::filesystem::file_size(cache)));
+	}
+	return 0;
+}
@@ -0,0 +1,103 @@
+﻿// 会话元数据的内存占用
+//   模拟 50 个程序在 2 个设备上播放，设备切换 100 次，每次切换重新创建所有会话，共 10000 个会话
+//   每个会话保存显示名称、会话 ID、实例 ID 和图标路径，分别用独立的 std::wstring 和 InternedString 保存
+//   内存为 glibc 报告的已分配堆大小的差值，包括会话数组本身
+// 参数：--apps 50 --switches 100
+
+#include <malloc.h>
+
+#include "StringPool.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	struct PlainSession
+	{
+		std::wstring DisplayName;
+		std::wstring SessionId;
+		std::wstring InstanceId;
+		std::wstring IconPath;
+	};
+
+	struct InternedSession
+	{
+		InternedString DisplayName;
+		InternedString SessionId;
+		InternedString InstanceId;
+		InternedString IconPath;
+	};
+
+	// 与 IAudioSessionControl2 返回的格式相近
+	PlainSession MakeSession(size_t app, size_t device)
+	{
+		auto name = L"App" + std::to_wstring(app);
+		auto deviceId = L"{0.0.0.00000000}.{6f1c4a8e-2d3b-4c5e-9a7f-00000000000" + std::to_wstring(device) + L"}";
+		auto exe = L"\\Device\\HarddiskVolume3\\Program Files\\" + name + L"\\" + name + L".exe";
+		PlainSession s;
+		s.DisplayName = name + L" Media Player";
+		s.SessionId = deviceId + L"|" + exe + L"%b{00000000-0000-0000-0000-000000000000}";
+		s.InstanceId = s.SessionId + L"|1%b" + std::to_wstring(4000 + app);
+		s.IconPath = L"C:\\Program Files\\" + name + L"\\" + name + L".exe,-101";
+		return s;
+	}
+
+	size_t HeapBytes()
+	{
+		return mallinfo2().uordblks;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto apps = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--apps", 50)));
+	auto switches = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--switches", 100)));
+	const size_t devices = 2;
+	auto count = apps * devices * switches;
+
+	// 先生成所有源字符串，不计入两种方式的占用
+	std::vector<PlainSession> sources;
+	for (size_t round = 0; round < switches; round++)
+	{
+		for (size_t device = 0; device < devices; device++)
+		{
+			for (size_t app = 0; app < apps; app++)
+			{
+				sources.push_back(MakeSession(app, device));
+			}
+		}
+	}
+
+	auto before = HeapBytes();
+	auto start = BenchClock::now();
+	std::vector<PlainSession> plain;
+	plain.reserve(count);
+	for (auto&& s : sources)
+	{
+		plain.push_back(s);
+	}
+	auto plainNs = ElapsedNs(start, BenchClock::now()) / count;
+	auto plainBytes = HeapBytes() - before;
+
+	StringPool pool;
+	before = HeapBytes();
+	start = BenchClock::now();
+	std::vector<InternedSession> interned;
+	interned.reserve(count);
+	for (auto&& s : sources)
+	{
+		interned.push_back({ pool.Intern(s.DisplayName), pool.Intern(s.SessionId), pool.Intern(s.InstanceId), pool.Intern(s.IconPath) });
+	}
+	auto internedNs = ElapsedNs(start, BenchClock::now()) / count;
+	auto internedBytes = HeapBytes() - before;
+
+	// 比较两个会话是否属于同一个程序的同一个会话
+	auto plainEq = MeasureNs(count, [&](size_t i) { DoNotOptimize(plain[i].SessionId == plain[(i + apps * devices) % count].SessionId); });
+	auto internedEq = MeasureNs(count, [&](size_t i) { DoNotOptimize(interned[i].SessionId == interned[(i + apps * devices) % count].SessionId); });
+
+	std::printf("%zu sessions (%zu apps x %zu devices x %zu switches), %zu pool entries\n", count, apps, devices, switches, pool.Size());
+	std::printf("heap : wstring %6.2f MB  interned %6.2f MB\n", plainBytes / 1048576.0, internedBytes / 1048576.0);
+	std::printf("build: wstring %6.1f ns  interned %6.1f ns per session\n", plainNs, internedNs);
+	std::printf("equal: wstring %6.2f ns  interned %6.2f ns\n", plainEq, internedEq);
+	return 0;
+}
@@ -0,0 +1,95 @@
+﻿// UTF-8 到宽字符串的转换
+//   吞吐：约 1 MB 的 ASCII 路径和中英混合路径，Utf8ToWide 与 locale 的 codecvt 对比（codecvt 使用已构造好的 locale）
+//   单个字符串：配置中的每个字符串都要转换一次，修改前每次都按名称列表依次尝试构造 locale，
+//              这里把本机可用的 C.UTF-8 放在列表最后，代表前面的名称都不可用的情况
+// 参数：--runs 50 --strings 200000
+
+#include <locale>
+#include <optional>
+
+#include "Utf8.h"
+#include "BenchUtil.h"
+
+namespace
+{
+	// 修改前 VolumeLock.cpp 中的 StringToWide
+	std::optional<std::wstring> CodecvtToWide(const std::string& s, const std::locale& loc)
+	{
+		using Facet = std::codecvt<wchar_t, char, std::mbstate_t>;
+		std::mbstate_t state{};
+		const char* fromNext = nullptr;
+		std::vector<wchar_t> buf(s.size() + 1);
+		wchar_t* toNext = nullptr;
+		if (std::use_facet<Facet>(loc).in(state, s.data(), s.data() + s.size(), fromNext, buf.data(), buf.data() + buf.size(), toNext) != Facet::ok)
+		{
+			return {};
+		}
+		return std::wstring(buf.data(), toNext);
+	}
+
+	// 修改前的 Utf8ToWide
+	std::optional<std::wstring> ProbeToWide(const std::string& s)
+	{
+		for (auto name : { ".65001", "zh-CN.65001", "zh_CN.UTF-8", "en-US.65001", "en_US.UTF-8", "C.UTF-8" })
+		{
+			try
+			{
+				return CodecvtToWide(s, std::locale(name));
+			}
+			catch (...)
+			{
+				continue;
+			}
+		}
+		return {};
+	}
+
+	std::string Repeat(const std::string& s, size_t bytes)
+	{
+		std::string out;
+		while (out.size() < bytes)
+		{
+			out += s;
+			out += '\n';
+		}
+		return out;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	QuietLogs();
+	auto runs = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--runs", 50)));
+	auto strings = static_cast<size_t>(std::max(1L, GetArg(argc, argv, "--strings", 200000)));
+
+	std::locale utf8;
+	try
+	{
+		utf8 = std::locale("C.UTF-8");
+	}
+	catch (...)
+	{
+		std::printf("C.UTF-8 locale is not available\n");
+		return 1;
+	}
+
+	const std::string ascii = "C:\\Program Files (x86)\\Steam\\steamapps\\common\\Some Game\\Binaries\\Win64\\Game.exe";
+	const std::string mixed = "D:\\游戏\\原神\\Genshin Impact Game\\YuanShen.exe";
+	for (auto&& [name, line] : { std::pair<const char*, const std::string&>{ "ascii", ascii }, { "mixed", mixed } })
+	{
+		auto text = Repeat(line, 1 << 20);
+		if (CodecvtToWide(text, utf8) != Utf8ToWide(text))
+		{
+			std::printf("mismatch for %s\n", name);
+			return 1;
+		}
+		auto codecvt = MeasureNs(runs, [&](size_t) { DoNotOptimize(CodecvtToWide(text, utf8)); });
+		auto decoder = MeasureNs(runs, [&](size_t) { DoNotOptimize(Utf8ToWide(text)); });
+		std::printf("throughput %-5s: codecvt %7.0f MB/s  Utf8ToWide %7.0f MB/s\n", name, text.size() / codecvt * 1e3, text.size() / decoder * 1e3);
+	}
+
+	auto probe = MeasureNs(std::max<size_t>(1, strings / 100), [&](size_t) { DoNotOptimize(ProbeToWide(ascii)); });
+	auto decoder = MeasureNs(strings, [&](size_t) { DoNotOptimize(Utf8ToWide(ascii)); });
+	std::printf("one %zu-byte config string: locale probing %8.1f ns  Utf8ToWide %6.1f ns\n", ascii.size(), probe, decoder);
+	return 0;
+}
@@ -0,0 +1,98 @@
+﻿#include <gtest/gtest.h>
+
+#include <random>
+
+#include "CaseFold.h"
+
+namespace
+{
+	// 逐个字符折叠，作为批量折叠的参照
+	std::wstring FoldScalar(std::wstring_view s)
+	{
+		std::wstring out;
+		for (auto c : s)
+		{
+			out += FoldCase(c);
+		}
+		return out;
+	}
+}
+
+TEST(CaseFoldTest, FoldsUnicodeVectors)
+{
+	const std::pair<const wchar_t*, const wchar_t*> vectors[] = {
+		{ L"C:\\Program Files\\Game\\GAME.EXE", L"c:\\program files\\game\\game.exe" },
+		// Latin-1：ß 和 ÿ 没有一对一的大写形式，保持不变
+		{ L"ÀÉÎÕÜÝÞ ß ÿ ×÷", L"àéîõüýþ ß ÿ ×÷" },
+		// Latin Extended-A 中大小写交替排列
+		{ L"ĀĂĄĆŁŃŒŠŸŽ", L"āăąćłńœšÿž" },
+		{ L"ΑΒΓΔΣΩ ΆΈ", L"αβγδσω άέ" },
+		{ L"ЖЁЩЯ ЄЇЎ", L"жёщя єїў" },
+		{ L"ＡＢＣ＼ＸＹＺ", L"ａｂｃ＼ｘｙｚ" },
+		// 罗马数字和开尔文符号
+		{ L"ⅫⅠ \u212A", L"ⅻⅰ k" },
+		{ L"音乐播放器 ゲーム 게임", L"音乐播放器 ゲーム 게임" },
+		// 映射到多个字符的 İ 保持不变，与 Windows 文件名比较一致
+		{ L"\u0130", L"\u0130" },
+		{ L"", L"" },
+	};
+	for (auto&& [input, expected] : vectors)
+	{
+		EXPECT_EQ(FoldCase(input), expected);
+		EXPECT_EQ(FoldScalar(input), expected);
+	}
+}
+
+TEST(CaseFoldTest, KeepsSurrogatesAndPrivateUse)
+{
+	for (wchar_t c : { wchar_t(0xD800), wchar_t(0xDBFF), wchar_t(0xDC00), wchar_t(0xDFFF), wchar_t(0xE000), wchar_t(0xF8FF), wchar_t(0xFFFF) })
+	{
+		EXPECT_EQ(FoldCase(c), c);
+	}
+}
+
+// 长度和 ASCII/非 ASCII 混合方式随机，覆盖向量处理的每种尾部长度和中途切换
+TEST(CaseFoldTest, BatchMatchesScalar)
+{
+	const std::wstring alphabet = L"aZ09_\\/. @[`{ÀßĀΣЖＡ音\u212A";
+	std::mt19937 rng(9);
+	std::wstring out;
+	for (int round = 0; round < 20000; round++)
+	{
+		std::wstring s;
+		auto length = rng() % 40;
+		bool ascii = rng() % 2;
+		for (size_t i = 0; i < length; i++)
+		{
+			s += alphabet[rng() % (ascii ? 13 : alphabet.size())];
+		}
+		FoldCase(s, out);
+		ASSERT_EQ(out, FoldScalar(s)) << "round " << round;
+	}
+}
+
+TEST(CaseFoldTest, ReusesOutputBuffer)
+{
+	std::wstring out;
+	out.reserve(256);
+	auto data = out.data();
+	FoldCase(L"C:\\Program Files\\Browser\\BROWSER.EXE", out);
+	FoldCase(L"/APPS/GAME.EXE", out);
+	EXPECT_EQ(out, L"/apps/game.exe");
+	EXPECT_EQ(out.data(), data);
+}
+
+TEST(CaseFoldTest, KeysCompareIgnoringCase)
+{
+	FoldedKey a(L"C:\\Games\\ÉLAN.exe");
+	FoldedKey b(L"c:\\games\\élan.EXE");
+	FoldedKey c(L"c:\\games\\elan.exe");
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(a.Hash, b.Hash);
+	EXPECT_NE(a, c);
+	EXPECT_EQ(FoldedKeyHash()(a), a.Hash);
+
+	// 重新赋值后哈希随之更新
+	c.Assign(L"C:\\GAMES\\ÉLAN.EXE");
+	EXPECT_EQ(a, c);
+}
@@ -0,0 +1,156 @@
+﻿#include <gtest/gtest.h>
+
+#include <mutex>
+#include <vector>
+
+#include "DeferredReleaser.h"
+#include "Metrics.h"
+#include "TestUtil.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	// 代替 Core Audio 会话，析构时记录顺序和所在线程
+	struct FakeSession
+	{
+		struct Log
+		{
+			std::mutex Mutex;
+			std::vector<int> Order;
+			std::vector<std::thread::id> Threads;
+		};
+
+		FakeSession(int id, Log& log) : Id(id), Released(log)
+		{
+		}
+
+		~FakeSession()
+		{
+			std::lock_guard lock(Released.Mutex);
+			Released.Order.push_back(Id);
+			Released.Threads.push_back(std::this_thread::get_id());
+		}
+
+		int Id;
+		Log& Released;
+	};
+
+	size_t ReleasedCount(FakeSession::Log& log)
+	{
+		std::lock_guard lock(log.Mutex);
+		return log.Order.size();
+	}
+}
+
+TEST(DeferredReleaserTest, ReleasesLastReferenceOnWorker)
+{
+	FakeSession::Log log;
+	DeferredReleaser releaser;
+	auto session = std::make_shared<FakeSession>(1, log);
+	auto kept = session;
+	releaser.Release(std::move(session));
+	releaser.Release(std::move(kept));
+	ASSERT_TRUE(WaitFor([&] { return ReleasedCount(log) == 1; }));
+
+	std::lock_guard lock(log.Mutex);
+	EXPECT_NE(log.Threads[0], std::this_thread::get_id());
+}
+
+TEST(DeferredReleaserTest, RunsInDueOrder)
+{
+	FakeSession::Log log;
+	// 一个工作线程时执行顺序完全确定
+	DeferredReleaser releaser(1);
+	releaser.Release(std::make_shared<FakeSession>(3, log), 300ms);
+	releaser.Release(std::make_shared<FakeSession>(1, log), 100ms);
+	releaser.Release(std::make_shared<FakeSession>(2, log), 200ms);
+	releaser.Release(std::make_shared<FakeSession>(0, log));
+	ASSERT_TRUE(WaitFor([&] { return ReleasedCount(log) == 4; }));
+
+	std::lock_guard lock(log.Mutex);
+	EXPECT_EQ(log.Order, (std::vector<int>{ 0, 1, 2, 3 }));
+}
+
+TEST(DeferredReleaserTest, KeepsReferenceUntilDelayExpires)
+{
+	FakeSession::Log log;
+	DeferredReleaser releaser;
+	auto start = DeferredReleaser::Clock::now();
+	releaser.Release(std::make_shared<FakeSession>(1, log), 200ms);
+	std::this_thread::sleep_for(50ms);
+	EXPECT_EQ(ReleasedCount(log), 0u);
+	ASSERT_TRUE(WaitFor([&] { return ReleasedCount(log) == 1; }));
+	EXPECT_GE(DeferredReleaser::Clock::now() - start, 200ms);
+}
+
+TEST(DeferredReleaserTest, FlushesPendingOnDestruction)
+{
+	FakeSession::Log log;
+	auto start = DeferredReleaser::Clock::now();
+	{
+		DeferredReleaser releaser;
+		for (int i = 0; i < 10; i++)
+		{
+			releaser.Release(std::make_shared<FakeSession>(i, log), 10s);
+		}
+	}
+	// 析构时不再等待延迟
+	EXPECT_EQ(ReleasedCount(log), 10u);
+	EXPECT_LT(DeferredReleaser::Clock::now() - start, 5s);
+}
+
+TEST(DeferredReleaserTest, SurvivesThrowingTaskAndNestedPost)
+{
+	FakeSession::Log log;
+	DeferredReleaser releaser;
+	releaser.Post([]() { throw std::runtime_error("release failed"); });
+	// 任务中再次投递，与设备释放时再释放其会话相同
+	releaser.Post([&]() { releaser.Release(std::make_shared<FakeSession>(1, log)); });
+	ASSERT_TRUE(WaitFor([&] { return ReleasedCount(log) == 1; }));
+	ASSERT_TRUE(WaitFor([&] { return releaser.GetStats().Released == 3; }));
+}
+
+TEST(DeferredReleaserTest, ReportsStats)
+{
+	FakeSession::Log log;
+	DeferredReleaser releaser(1);
+	std::mutex gate;
+	std::unique_lock blocked(gate);
+	releaser.Post([&]() { std::lock_guard lock(gate); });
+	for (int i = 0; i < 5; i++)
+	{
+		releaser.Release(std::make_shared<FakeSession>(i, log));
+	}
+	// 唯一的工作线程被第一个任务卡住，其余的都在排队
+	ASSERT_TRUE(WaitFor([&] { return releaser.GetStats().QueueDepth == 5; }));
+	std::this_thread::sleep_for(50ms);
+	blocked.unlock();
+	ASSERT_TRUE(WaitFor([&] { return releaser.GetStats().Released == 6; }));
+
+	auto stats = releaser.GetStats();
+	EXPECT_EQ(stats.QueueDepth, 0u);
+	EXPECT_GE(stats.MaxLatency, 50ms);
+	EXPECT_GE(stats.TotalLatency, stats.MaxLatency);
+}
+
+TEST(DeferredReleaserTest, ExportsStatsAsMetrics)
+{
+	FakeSession::Log log;
+	DeferredReleaser releaser(1);
+	MetricsRegistry registry;
+	releaser.RegisterMetrics(registry);
+	EXPECT_EQ(GetMetric(registry, "volumelock_deferred_released_total"), 0);
+
+	for (int i = 0; i < 3; i++)
+	{
+		releaser.Release(std::make_shared<FakeSession>(i, log));
+	}
+	releaser.Release(std::make_shared<FakeSession>(3, log), 10s);
+	ASSERT_TRUE(WaitFor([&] { return releaser.GetStats().Released == 3; }));
+	EXPECT_EQ(GetMetric(registry, "volumelock_deferred_released_total"), 3);
+	EXPECT_EQ(GetMetric(registry, "volumelock_deferred_queue_depth"), 1);
+	// 再次导出时计数器不会重复累加
+	EXPECT_EQ(GetMetric(registry, "volumelock_deferred_released_total"), 3);
+	EXPECT_GE(GetMetric(registry, "volumelock_deferred_release_latency_microseconds_total"), GetMetric(registry, "volumelock_deferred_release_latency_max_microseconds"));
+}
@@ -0,0 +1,143 @@
+﻿#include <gtest/gtest.h>
+
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "EventLoop.h"
+#include "MpscQueue.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	// 在循环线程上执行一个空任务并等待，之前投递的任务都已执行完毕
+	void Drain(EventLoop& loop)
+	{
+		std::promise<void> done;
+		loop.Post([&done]() { done.set_value(); });
+		ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+	}
+}
+
+TEST(MpscQueueTest, KeepsOrderOfEachProducer)
+{
+	constexpr int Producers = 4;
+	constexpr int PerProducer = 20000;
+	MpscQueue<std::pair<int, int>> queue;
+
+	std::vector<std::thread> threads;
+	for (int p = 0; p < Producers; p++)
+	{
+		threads.emplace_back([&queue, p]() {
+			for (int i = 0; i < PerProducer; i++)
+			{
+				queue.Push({ p, i });
+			}
+		});
+	}
+
+	// 消费者与生产者同时运行，每个生产者的元素必须按投递顺序出现，且不丢失、不重复
+	std::vector<int> next(Producers, 0);
+	int received = 0;
+	while (received < Producers * PerProducer)
+	{
+		auto item = queue.Pop();
+		if (!item)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		auto [p, i] = *item;
+		ASSERT_EQ(i, next[p]);
+		next[p]++;
+		received++;
+	}
+	for (auto&& t : threads)
+	{
+		t.join();
+	}
+	EXPECT_TRUE(queue.IsEmpty());
+	EXPECT_FALSE(queue.Pop().has_value());
+}
+
+TEST(EventLoopTest, RunsTasksFromManyThreads)
+{
+	constexpr int Producers = 4;
+	constexpr int PerProducer = 10000;
+	EventLoop loop;
+	loop.Start();
+
+	// 只在循环线程上修改，不需要同步
+	int count = 0;
+	std::vector<std::thread> threads;
+	for (int p = 0; p < Producers; p++)
+	{
+		threads.emplace_back([&]() {
+			for (int i = 0; i < PerProducer; i++)
+			{
+				loop.Post([&count]() { count++; });
+			}
+		});
+	}
+	for (auto&& t : threads)
+	{
+		t.join();
+	}
+	Drain(loop);
+	EXPECT_EQ(count, Producers * PerProducer);
+}
+
+TEST(EventLoopTest, ContinuesAfterThrowingTask)
+{
+	EventLoop loop;
+	loop.Start();
+
+	bool ran = false;
+	loop.Post([]() { throw std::runtime_error("task failed"); });
+	loop.Post([]() { throw 42; });
+	loop.Post([&ran]() { ran = true; });
+	Drain(loop);
+	EXPECT_TRUE(ran);
+
+	// 定时任务抛出异常同样不影响循环
+	loop.PostDelayed(1ms, []() { throw std::runtime_error("timer failed"); });
+	std::promise<void> done;
+	loop.PostDelayed(5ms, [&done]() { done.set_value(); });
+	EXPECT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+}
+
+TEST(EventLoopTest, RunsDelayedTasksInDueOrder)
+{
+	EventLoop loop;
+	loop.Start();
+
+	std::vector<int> order;
+	std::promise<void> done;
+	loop.PostDelayed(30ms, [&]() {
+		order.push_back(3);
+		done.set_value();
+	});
+	// 到期时间相同的按投递顺序执行
+	loop.PostDelayed(10ms, [&]() { order.push_back(1); });
+	loop.PostDelayed(10ms, [&]() { order.push_back(2); });
+	loop.Post([&]() { order.push_back(0); });
+
+	ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+	EXPECT_EQ(order, (std::vector<int>{ 0, 1, 2, 3 }));
+}
+
+TEST(EventLoopTest, StopDiscardsPendingTimers)
+{
+	std::atomic<bool> ran{ false };
+	{
+		EventLoop loop;
+		loop.Start();
+		loop.PostDelayed(1h, [&ran]() { ran = true; });
+		Drain(loop);
+		loop.Stop();
+		EXPECT_FALSE(loop.IsRunning());
+	}
+	EXPECT_FALSE(ran.load());
+}
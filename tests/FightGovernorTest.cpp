@@ -0,0 +1,131 @@
+﻿#include <gtest/gtest.h>
+
+#include "FightGovernor.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	// 时间全部由测试传入，不读取真实时钟
+	using Governor = FightGovernor<int>;
+	using Verdict = Governor::Verdict;
+
+	Governor::Options TestOptions()
+	{
+		Governor::Options options;
+		options.Threshold = 5;
+		options.Window = 1000ms;
+		options.InitialBackoff = 250ms;
+		options.MaxBackoff = 1000ms;
+		return options;
+	}
+
+	class FightGovernorTest : public testing::Test
+	{
+	protected:
+		Verdict Request(int key)
+		{
+			return m_governor.Request(key, m_now, m_retryAfter);
+		}
+
+		// 在窗口内连续纠正到触发争夺
+		void StartFight(int key)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				ASSERT_EQ(Request(key), Verdict::Allow);
+				m_now += 10ms;
+			}
+			ASSERT_EQ(Request(key), Verdict::AllowFightDetected);
+		}
+
+		Governor m_governor{ TestOptions() };
+		Governor::TimePoint m_now{};
+		Governor::Duration m_retryAfter{};
+	};
+}
+
+TEST_F(FightGovernorTest, AllowsCorrectionsSpreadOverTime)
+{
+	for (int i = 0; i < 20; i++)
+	{
+		EXPECT_EQ(Request(1), Verdict::Allow);
+		// 窗口内最多 4 次
+		m_now += 300ms;
+	}
+	EXPECT_FALSE(m_governor.IsFighting(1));
+	EXPECT_EQ(m_governor.GetFightCount(1), 0u);
+}
+
+TEST_F(FightGovernorTest, DetectsFightAndBacksOff)
+{
+	StartFight(1);
+	EXPECT_TRUE(m_governor.IsFighting(1));
+	EXPECT_EQ(m_governor.GetFightCount(1), 1u);
+
+	m_now += 10ms;
+	EXPECT_EQ(Request(1), Verdict::Throttle);
+	EXPECT_EQ(m_retryAfter, 240ms);
+
+	// 对方仍在修改，每次允许的纠正之后退避时间加倍，直到上限
+	m_now += 240ms;
+	EXPECT_EQ(Request(1), Verdict::Allow);
+	EXPECT_EQ(Request(1), Verdict::Throttle);
+	EXPECT_EQ(m_retryAfter, 500ms);
+
+	m_now += 500ms;
+	EXPECT_EQ(Request(1), Verdict::Allow);
+	EXPECT_EQ(Request(1), Verdict::Throttle);
+	EXPECT_EQ(m_retryAfter, 1000ms);
+
+	m_now += 1000ms;
+	EXPECT_EQ(Request(1), Verdict::Allow);
+	EXPECT_EQ(Request(1), Verdict::Throttle);
+	EXPECT_EQ(m_retryAfter, 1000ms);
+	EXPECT_EQ(m_governor.GetThrottledCount(1), 4u);
+	// 同一场争夺只报告一次
+	EXPECT_EQ(m_governor.GetFightCount(1), 1u);
+}
+
+TEST_F(FightGovernorTest, FightEndsAfterQuietPeriod)
+{
+	StartFight(1);
+	// 超过退避时间加一个窗口没有纠正，视为对方已经停下
+	m_now += 250ms + 1000ms + 1ms;
+	EXPECT_EQ(Request(1), Verdict::Allow);
+	EXPECT_FALSE(m_governor.IsFighting(1));
+
+	// 再次争夺时重新检测并计数
+	m_now += 10ms;
+	for (int i = 0; i < 3; i++)
+	{
+		EXPECT_EQ(Request(1), Verdict::Allow);
+		m_now += 10ms;
+	}
+	EXPECT_EQ(Request(1), Verdict::AllowFightDetected);
+	EXPECT_EQ(m_governor.GetFightCount(1), 2u);
+}
+
+TEST_F(FightGovernorTest, KeysAreIndependent)
+{
+	StartFight(1);
+	m_now += 10ms;
+	EXPECT_EQ(Request(1), Verdict::Throttle);
+	EXPECT_EQ(Request(2), Verdict::Allow);
+	EXPECT_FALSE(m_governor.IsFighting(2));
+}
+
+TEST_F(FightGovernorTest, EraseReleasesState)
+{
+	StartFight(1);
+	Request(2);
+	EXPECT_EQ(m_governor.Size(), 2u);
+
+	m_governor.Erase(1);
+	EXPECT_EQ(m_governor.Size(), 1u);
+	EXPECT_FALSE(m_governor.IsFighting(1));
+	EXPECT_EQ(m_governor.GetFightCount(1), 0u);
+	// 之后出现的同一个键从头开始
+	m_now += 10ms;
+	EXPECT_EQ(Request(1), Verdict::Allow);
+}
@@ -0,0 +1,248 @@
+﻿#include <gtest/gtest.h>
+
+#include <random>
+
+#include "Glob.h"
+#include "CaseFold.h"
+
+namespace
+{
+	bool IsSeparator(wchar_t c)
+	{
+		return c == L'\\' || c == L'/';
+	}
+
+	bool Matches(std::wstring_view pattern, std::wstring_view path)
+	{
+		return Glob(pattern).Match(FoldCase(path));
+	}
+
+	// 直接在模式字符串上回溯匹配，作为编译后的自动机的参照
+	class ReferenceGlob
+	{
+	public:
+		ReferenceGlob(std::wstring_view pattern, std::wstring_view foldedPath) : m_pattern(pattern), m_path(foldedPath) {}
+
+		bool Match()
+		{
+			return Match(0, 0);
+		}
+
+	private:
+		bool Match(size_t p, size_t i)
+		{
+			if (p == m_pattern.size())
+			{
+				return i == m_path.size();
+			}
+			auto c = m_pattern[p];
+			if (c == L'*')
+			{
+				auto end = p;
+				while (end < m_pattern.size() && m_pattern[end] == L'*')
+				{
+					end++;
+				}
+				if (end - p == 1)
+				{
+					// * 不跨越分隔符
+					for (auto j = i;; j++)
+					{
+						if (Match(end, j))
+						{
+							return true;
+						}
+						if (j == m_path.size() || IsSeparator(m_path[j]))
+						{
+							return false;
+						}
+					}
+				}
+				if (end < m_pattern.size() && IsSeparator(m_pattern[end]))
+				{
+					// **\ 匹配零级目录，或任意字符后跟一个分隔符
+					if (Match(end + 1, i))
+					{
+						return true;
+					}
+					for (auto j = i; j < m_path.size(); j++)
+					{
+						if (IsSeparator(m_path[j]) && Match(end + 1, j + 1))
+						{
+							return true;
+						}
+					}
+					return false;
+				}
+				for (auto j = i; j <= m_path.size(); j++)
+				{
+					if (Match(end, j))
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+			if (i == m_path.size())
+			{
+				return false;
+			}
+			auto x = m_path[i];
+			if (c == L'[')
+			{
+				auto close = p + 1;
+				auto negated = close < m_pattern.size() && (m_pattern[close] == L'!' || m_pattern[close] == L'^');
+				if (negated)
+				{
+					close++;
+				}
+				auto found = false;
+				for (auto first = true; first || m_pattern[close] != L']'; first = false)
+				{
+					auto lo = m_pattern[close++];
+					auto hi = lo;
+					if (close + 1 < m_pattern.size() && m_pattern[close] == L'-' && m_pattern[close + 1] != L']')
+					{
+						hi = m_pattern[close + 1];
+						close += 2;
+					}
+					for (auto y = lo; y <= hi; y++)
+					{
+						found = found || FoldCase(y) == x;
+					}
+				}
+				return !IsSeparator(x) && found != negated && Match(close + 1, i + 1);
+			}
+			if (c == L'?')
+			{
+				return !IsSeparator(x) && Match(p + 1, i + 1);
+			}
+			if (IsSeparator(c))
+			{
+				return IsSeparator(x) && Match(p + 1, i + 1);
+			}
+			return FoldCase(c) == x && Match(p + 1, i + 1);
+		}
+
+		std::wstring_view m_pattern;
+		std::wstring_view m_path;
+	};
+}
+
+TEST(GlobTest, MatchesWildcards)
+{
+	EXPECT_TRUE(Matches(L"C:\\Games\\*.exe", L"C:\\Games\\game.exe"));
+	EXPECT_TRUE(Matches(L"C:\\Games\\*.exe", L"C:\\Games\\.exe"));
+	EXPECT_FALSE(Matches(L"C:\\Games\\*.exe", L"C:\\Games\\sub\\game.exe"));
+	EXPECT_FALSE(Matches(L"C:\\Games\\*.exe", L"C:\\Games\\game.exe.bak"));
+	EXPECT_TRUE(Matches(L"C:\\Games\\game?.exe", L"C:\\Games\\game2.exe"));
+	EXPECT_FALSE(Matches(L"C:\\Games\\game?.exe", L"C:\\Games\\game.exe"));
+	EXPECT_FALSE(Matches(L"C:\\Games?game.exe", L"C:\\Games\\game.exe"));
+	// 必须匹配整个路径
+	EXPECT_FALSE(Matches(L"Games\\*.exe", L"C:\\Games\\game.exe"));
+	EXPECT_TRUE(Matches(L"", L""));
+	EXPECT_FALSE(Matches(L"", L"a"));
+}
+
+TEST(GlobTest, DoubleStarCrossesDirectories)
+{
+	const wchar_t* pattern = L"**\\steamapps\\common\\*\\*.exe";
+	EXPECT_TRUE(Matches(pattern, L"D:\\SteamLibrary\\steamapps\\common\\Game\\game.exe"));
+	EXPECT_TRUE(Matches(pattern, L"steamapps\\common\\Game\\game.exe"));
+	EXPECT_FALSE(Matches(pattern, L"D:\\steamapps\\common\\Game\\bin\\game.exe"));
+	EXPECT_FALSE(Matches(pattern, L"D:\\mysteamapps\\common\\Game\\game.exe"));
+
+	// **\ 匹配零到多级目录
+	EXPECT_TRUE(Matches(L"C:\\Apps\\**\\app.exe", L"C:\\Apps\\app.exe"));
+	EXPECT_TRUE(Matches(L"C:\\Apps\\**\\app.exe", L"C:\\Apps\\a\\b\\c\\app.exe"));
+	EXPECT_FALSE(Matches(L"C:\\Apps\\**\\app.exe", L"C:\\Apps\\myapp.exe"));
+	// 不跟分隔符的 ** 可以匹配目录名的一部分
+	EXPECT_TRUE(Matches(L"C:\\Apps**.exe", L"C:\\Apps2\\x\\myapp.exe"));
+	EXPECT_TRUE(Matches(L"C:\\Program Files*\\**\\*[Pp]layer*.exe", L"C:\\Program Files (x86)\\VideoLAN\\VLC\\MediaPlayer.exe"));
+}
+
+TEST(GlobTest, MatchesCharacterClasses)
+{
+	EXPECT_TRUE(Matches(L"/bin/[abc].exe", L"/bin/b.exe"));
+	EXPECT_FALSE(Matches(L"/bin/[abc].exe", L"/bin/d.exe"));
+	EXPECT_TRUE(Matches(L"/bin/v[0-9].exe", L"/bin/v7.exe"));
+	EXPECT_FALSE(Matches(L"/bin/v[!0-9].exe", L"/bin/v7.exe"));
+	EXPECT_TRUE(Matches(L"/bin/v[^0-9].exe", L"/bin/vx.exe"));
+	// 字符类和 ? 都不匹配分隔符，即使取反
+	EXPECT_FALSE(Matches(L"/bin[!a]x.exe", L"/bin/x.exe"));
+	// 开头的 ] 是普通字符，字面的 [ 写作 [[]
+	EXPECT_TRUE(Matches(L"/bin/[]]", L"/bin/]"));
+	EXPECT_TRUE(Matches(L"/bin/[[]x]", L"/bin/[x]"));
+	EXPECT_TRUE(Matches(L"/bin/[a-]", L"/bin/-"));
+	EXPECT_TRUE(Matches(L"/音乐/[播放]器.exe", L"/音乐/播器.exe"));
+	EXPECT_TRUE(Matches(L"/音乐/?器.exe", L"/音乐/播器.exe"));
+	EXPECT_FALSE(Matches(L"/音乐/[!播放]器.exe", L"/音乐/播器.exe"));
+}
+
+TEST(GlobTest, IgnoresCase)
+{
+	EXPECT_TRUE(Matches(L"C:\\GAMES\\*.EXE", L"c:\\games\\Game.exe"));
+	// 字符类的范围按折叠后的字符比较
+	EXPECT_TRUE(Matches(L"/bin/[A-C].exe", L"/bin/b.exe"));
+	EXPECT_TRUE(Matches(L"/bin/[a-c].exe", L"/bin/B.EXE"));
+	EXPECT_FALSE(Matches(L"/bin/[!A-C].exe", L"/bin/b.exe"));
+	EXPECT_TRUE(Matches(L"/ÉLAN/[À-Ý]*", L"/élan/éx"));
+	EXPECT_TRUE(Matches(L"/ＧＡＭＥ/*", L"/ｇａｍｅ/x"));
+}
+
+TEST(GlobTest, SupportsLongPatterns)
+{
+	// 记号数超过 64 个时状态跨越多个字
+	std::wstring dir(150, L'd');
+	EXPECT_TRUE(Matches(L"/" + dir + L"/**/*.exe", L"/" + dir + L"/a/b/c.exe"));
+	EXPECT_FALSE(Matches(L"/" + dir + L"/**/*.exe", L"/" + dir + L"x/a/b/c.exe"));
+	EXPECT_TRUE(Matches(L"**/" + dir + L"?*", L"/x/y/" + dir + L"zz"));
+	EXPECT_NO_THROW(Glob(std::wstring(Glob::MaxTokens, L'a')));
+}
+
+TEST(GlobTest, RejectsInvalidPatterns)
+{
+	EXPECT_THROW(Glob(L"/bin/[abc"), GlobError);
+	EXPECT_THROW(Glob(L"/bin/[]"), GlobError);
+	EXPECT_THROW(Glob(L"/bin/[z-a]"), GlobError);
+	EXPECT_THROW(Glob(std::wstring(Glob::MaxTokens + 1, L'a')), GlobError);
+	try
+	{
+		Glob(L"/bin/[abc");
+		FAIL();
+	}
+	catch (const GlobError& e)
+	{
+		EXPECT_STREQ(e.what(), "通配符的字符类缺少 ]，位于第 6 个字符");
+	}
+}
+
+// 随机拼接模式片段和路径，与回溯匹配的参照实现对比
+TEST(GlobTest, AgreesWithReference)
+{
+	const std::vector<std::wstring> pieces{ L"a", L"B", L"ab", L"游", L"?", L"*", L"**", L"**/", L"***\\", L"/", L"\\", L"[a-c]", L"[!b]", L"[]a]", L"[^游/]" };
+	const std::wstring alphabet = L"aAbBcx/\\游]";
+	std::mt19937 rng(25);
+	size_t matched = 0;
+	for (int round = 0; round < 100000; round++)
+	{
+		std::wstring pattern;
+		auto count = rng() % 7;
+		for (size_t i = 0; i < count; i++)
+		{
+			pattern += pieces[rng() % pieces.size()];
+		}
+		std::wstring path;
+		auto length = rng() % 10;
+		for (size_t i = 0; i < length; i++)
+		{
+			path += alphabet[rng() % alphabet.size()];
+		}
+		auto folded = FoldCase(path);
+		auto expected = ReferenceGlob(pattern, folded).Match();
+		matched += expected;
+		ASSERT_EQ(Glob(pattern).Match(folded), expected) << testing::PrintToString(pattern) << " " << testing::PrintToString(path);
+	}
+	// 匹配和不匹配都有足够多的样本
+	EXPECT_GT(matched, 5000u);
+}
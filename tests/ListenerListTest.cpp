@@ -0,0 +1,152 @@
+﻿#include <gtest/gtest.h>
+
+#include <thread>
+#include <future>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include "ListenerList.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	struct Listener
+	{
+		std::atomic<bool> Alive{ true };
+		std::atomic<int> Calls{ 0 };
+	};
+}
+
+TEST(ListenerListTest, AddsAndRemovesInOrder)
+{
+	ListenerList<Listener> list;
+	Listener a, b, c;
+	EXPECT_TRUE(list.Add(&a));
+	EXPECT_TRUE(list.Add(&b));
+	EXPECT_FALSE(list.Add(&a));
+	EXPECT_TRUE(list.Add(&c));
+	EXPECT_TRUE(list.Remove(&b));
+	EXPECT_FALSE(list.Remove(&b));
+
+	std::vector<Listener*> seen;
+	list.ForEach([&](auto listener) { seen.push_back(listener); });
+	EXPECT_EQ(seen, (std::vector<Listener*>{ &a, &c }));
+}
+
+TEST(ListenerListTest, RemoveWaitsForRunningDispatch)
+{
+	ListenerList<Listener> list;
+	Listener listener;
+	list.Add(&listener);
+
+	std::promise<void> entered;
+	std::promise<void> release;
+	auto released = release.get_future().share();
+	std::thread dispatcher([&]() {
+		list.ForEach([&](auto) {
+			entered.set_value();
+			released.wait();
+		});
+	});
+	entered.get_future().wait();
+
+	auto removed = std::async(std::launch::async, [&]() { return list.Remove(&listener); });
+	// 分发还在回调中，注销不能返回
+	EXPECT_EQ(removed.wait_for(50ms), std::future_status::timeout);
+	release.set_value();
+	EXPECT_TRUE(removed.get());
+	dispatcher.join();
+}
+
+TEST(ListenerListTest, RemovesItselfFromCallback)
+{
+	ListenerList<Listener> list;
+	Listener a, b;
+	list.Add(&a);
+	list.Add(&b);
+
+	// 在回调中注销不等待自己，分发照常完成
+	int calls = 0;
+	list.ForEach([&](auto listener) {
+		calls++;
+		list.Remove(listener);
+	});
+	EXPECT_EQ(calls, 2);
+	list.ForEach([&](auto) { calls++; });
+	EXPECT_EQ(calls, 2);
+}
+
+TEST(ListenerListTest, ReaderCountSurvivesThrowingCallback)
+{
+	ListenerList<Listener> list;
+	Listener listener;
+	list.Add(&listener);
+	EXPECT_THROW(list.ForEach([](auto) { throw std::runtime_error("callback failed"); }), std::runtime_error);
+
+	// 读者已经注销，否则这里会一直等待
+	auto removed = std::async(std::launch::async, [&]() { return list.Remove(&listener); });
+	ASSERT_EQ(removed.wait_for(5s), std::future_status::ready);
+	EXPECT_TRUE(removed.get());
+}
+
+// 多个线程持续分发，回调中还会注册和注销其他回调；写线程反复注册新回调、注销后立即标记为已释放，
+// 分发中不能再调用到已标记的回调
+TEST(ListenerListTest, NoDispatchAfterRemoveUnderStress)
+{
+	constexpr int Dispatchers = 3;
+	constexpr int Rounds = 300;
+	ListenerList<Listener> list;
+	Listener churn;
+	std::atomic<bool> stop{ false };
+	std::atomic<int> violations{ 0 };
+	std::atomic<uint64_t> dispatches{ 0 };
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < Dispatchers; t++)
+	{
+		threads.emplace_back([&, t]() {
+			uint64_t n = 0;
+			while (!stop.load())
+			{
+				list.ForEach([&](auto listener) {
+					if (!listener->Alive.load())
+					{
+						violations++;
+					}
+					listener->Calls++;
+				});
+				// 回调中也会注册和注销，不能与正在等待读者的写者互相等待
+				if (++n % 64 == static_cast<uint64_t>(t))
+				{
+					list.ForEach([&](auto) {
+						list.Add(&churn);
+						list.Remove(&churn);
+					});
+				}
+				dispatches++;
+			}
+		});
+	}
+
+	std::vector<std::unique_ptr<Listener>> listeners;
+	listeners.reserve(Rounds);
+	for (int i = 0; i < Rounds; i++)
+	{
+		listeners.push_back(std::make_unique<Listener>());
+		auto listener = listeners.back().get();
+		list.Add(listener);
+		std::this_thread::yield();
+		ASSERT_TRUE(list.Remove(listener));
+		listener->Alive.store(false);
+	}
+	stop.store(true);
+	for (auto&& t : threads)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(violations.load(), 0);
+	EXPECT_GT(dispatches.load(), 0u);
+}
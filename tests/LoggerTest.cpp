@@ -0,0 +1,121 @@
+﻿#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "Logger.h"
+#include "Utf8.h"
+#include "TestUtil.h"
+
+namespace
+{
+	LogEntry MakeEntry()
+	{
+		LogEntry entry;
+		entry.Length = 0;
+		return entry;
+	}
+
+	std::wstring Text(const LogEntry& entry)
+	{
+		return std::wstring(entry.Text, entry.Length);
+	}
+
+	std::wstring Lossy(std::string_view s, size_t capacity = 64)
+	{
+		std::wstring out(capacity, L'\0');
+		out.resize(DecodeUtf8Lossy(s, out.data(), capacity));
+		return out;
+	}
+}
+
+TEST(LoggerTest, DecodesUtf8Messages)
+{
+	auto entry = MakeEntry();
+	entry.Append(L"重新加载配置失败：");
+	entry.Append(std::runtime_error("无法打开配置文件").what());
+	entry.Append(std::string(" (code "));
+	entry.Append(-42);
+	entry.Append(")");
+	EXPECT_EQ(Text(entry), L"重新加载配置失败：无法打开配置文件 (code -42)");
+}
+
+TEST(LoggerTest, ReplacesInvalidBytes)
+{
+	EXPECT_EQ(Lossy("a\xff" "b"), L"a�b");
+	// 合法的前缀与出错的字节分开，各自一个替换字符
+	EXPECT_EQ(Lossy("\xe4\xb8" "x"), L"�x");
+	EXPECT_EQ(Lossy("\xe0\x80\x80"), L"���");
+	// 末尾被截断的序列整段算一个
+	EXPECT_EQ(Lossy("ok\xf0\x9f\x98"), L"ok�");
+	EXPECT_EQ(Lossy("\xed\xa0\x80"), L"���");
+	EXPECT_EQ(Lossy("\xf0\x9f\x98\x80"), std::wstring(L"\U0001F600"));
+}
+
+TEST(LoggerTest, TruncatesAtCharacterBoundary)
+{
+	// 输出满时停止，不写出半个字符
+	EXPECT_EQ(Lossy("abc", 2), L"ab");
+	EXPECT_EQ(Lossy("中文", 1), L"中");
+	EXPECT_EQ(Lossy(std::string(40, 'x') + "中", 40), std::wstring(40, L'x'));
+	if constexpr (sizeof(wchar_t) == 2)
+	{
+		// 代理对放不下时整个字符都不写入
+		EXPECT_EQ(Lossy("a\xf0\x9f\x98\x80", 2), L"a");
+	}
+
+	auto entry = MakeEntry();
+	std::string longText;
+	for (size_t i = 0; i < LogEntry::MaxLength + 10; i++)
+	{
+		longText += "中";
+	}
+	entry.Append(longText);
+	EXPECT_EQ(entry.Length, LogEntry::MaxLength);
+	EXPECT_EQ(Text(entry), std::wstring(LogEntry::MaxLength, L'中'));
+	entry.Append(123);
+	EXPECT_EQ(entry.Length, LogEntry::MaxLength);
+}
+
+TEST(LoggerTest, WritesUtf8ExceptionMessageToFile)
+{
+	TempDir dir;
+	auto& logger = Logger::Instance();
+	logger.SetFile(dir / "log.txt");
+	logger.Write(LogLevel::Error, L"无法监视设备：", std::runtime_error("会话已失效").what());
+	logger.Flush();
+	logger.SetFile({});
+	logger.Write(LogLevel::Debug, L"关闭日志文件");
+	logger.Flush();
+
+	std::ifstream in(dir / "log.txt", std::ios::binary);
+	std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	EXPECT_NE(content.find("无法监视设备：会话已失效"), std::string::npos) << content;
+}
+
+TEST(LoggerTest, AppliesRotationSettingsOfCurrentFile)
+{
+	TempDir dir;
+	auto& logger = Logger::Instance();
+	logger.SetFile(dir / "small.txt", 64, 1);
+	for (int i = 0; i < 10; i++)
+	{
+		logger.Write(LogLevel::Info, L"第 ", i, L" 行");
+	}
+	logger.Flush();
+	// 切换文件后使用新文件的设置，不再按旧的大小限制轮转
+	logger.SetFile(dir / "large.txt");
+	for (int i = 0; i < 10; i++)
+	{
+		logger.Write(LogLevel::Info, L"第 ", i, L" 行");
+	}
+	logger.Flush();
+	logger.SetFile({});
+	logger.Flush();
+
+	EXPECT_TRUE(std::filesystem::exists(dir / "small.txt.1"));
+	EXPECT_FALSE(std::filesystem::exists(dir / "small.txt.2"));
+	EXPECT_FALSE(std::filesystem::exists(dir / "large.txt.1"));
+	EXPECT_GT(std::filesystem::file_size(dir / "large.txt"), 64u);
+}
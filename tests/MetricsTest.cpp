@@ -0,0 +1,130 @@
+﻿#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+#include "Metrics.h"
+#include "TestUtil.h"
+
+using namespace std::chrono_literals;
+
+TEST(MetricsTest, WritesPrometheusText)
+{
+	MetricsRegistry registry;
+	registry.AddCounter("test_events_total", "Events seen.").Add(3);
+	registry.AddGauge("test_sessions", "Sessions locked.").Set(-2);
+	auto& histogram = registry.AddHistogram("test_latency_seconds", "Latency.");
+	histogram.Observe(50us);
+	histogram.Observe(2ms);
+	histogram.Observe(10s);
+
+	std::ostringstream out;
+	out.imbue(std::locale::classic());
+	registry.WritePrometheus(out);
+	auto text = out.str();
+	EXPECT_NE(text.find("# HELP test_events_total Events seen.\n# TYPE test_events_total counter\ntest_events_total 3\n"), std::string::npos);
+	EXPECT_NE(text.find("# TYPE test_sessions gauge\ntest_sessions -2\n"), std::string::npos);
+	EXPECT_NE(text.find("# TYPE test_latency_seconds histogram\n"), std::string::npos);
+	// 桶是累计的，超出上限的只计入 +Inf
+	EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"0.0001\"} 1\n"), std::string::npos);
+	EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"0.001\"} 1\n"), std::string::npos);
+	EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"0.005\"} 2\n"), std::string::npos);
+	EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"5\"} 2\n"), std::string::npos);
+	EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"+Inf\"} 3\n"), std::string::npos);
+	EXPECT_NE(text.find("test_latency_seconds_count 3\n"), std::string::npos);
+	EXPECT_DOUBLE_EQ(GetMetric(registry, "test_latency_seconds_sum"), 10.00205);
+}
+
+TEST(MetricsTest, WritesLabeledCounters)
+{
+	MetricsRegistry registry;
+	auto& family = registry.AddCounterFamily("test_fights_total", "Fights by process.", "pid");
+	family.Add("4000");
+	family.Add("12", 3);
+	family.Add("4000");
+	family.Add("a\"b\\c\nd");
+
+	std::ostringstream out;
+	registry.WritePrometheus(out);
+	// 序列按标签值排序，HELP 和 TYPE 只写一次
+	EXPECT_NE(out.str().find("# TYPE test_fights_total counter\ntest_fights_total{pid=\"12\"} 3\ntest_fights_total{pid=\"4000\"} 2\ntest_fights_total{pid=\"a\\\"b\\\\c\\nd\"} 1\n"), std::string::npos) << out.str();
+	EXPECT_EQ(family.Get("4000"), 2u);
+	EXPECT_EQ(family.Get("1"), 0u);
+
+	family.Remove("4000");
+	EXPECT_EQ(GetMetric(registry, "test_fights_total{pid=\"4000\"}"), -1);
+	EXPECT_EQ(GetMetric(registry, "test_fights_total{pid=\"12\"}"), 3);
+	family.Add("4000");
+	EXPECT_EQ(GetMetric(registry, "test_fights_total{pid=\"4000\"}"), 1);
+}
+
+TEST(MetricsTest, HistogramBucketsIncludeUpperBound)
+{
+	Histogram histogram;
+	histogram.Observe(100us);
+	histogram.Observe(101us);
+	histogram.Observe(-1ms);
+	EXPECT_EQ(histogram.GetBucket(0), 2u);
+	EXPECT_EQ(histogram.GetBucket(1), 1u);
+	// 负的耗时（时钟回拨）不计入总和
+	EXPECT_EQ(histogram.GetSum(), 101us + 100us);
+}
+
+TEST(MetricsTest, CountsFromManyThreads)
+{
+	MetricsRegistry registry;
+	auto& counter = registry.AddCounter("test_total", "Total.");
+	auto& histogram = registry.AddHistogram("test_seconds", "Seconds.");
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&]() {
+			for (int i = 0; i < 10000; i++)
+			{
+				counter.Add();
+				histogram.Observe(1ms);
+			}
+		});
+	}
+	for (auto&& t : threads)
+	{
+		t.join();
+	}
+	EXPECT_EQ(GetMetric(registry, "test_total"), 40000);
+	EXPECT_EQ(GetMetric(registry, "test_seconds_count"), 40000);
+}
+
+TEST(MetricsTest, ExporterReplacesFileAtomically)
+{
+	TempDir dir;
+	MetricsRegistry registry;
+	auto& counter = registry.AddCounter("test_total", "Total.");
+	auto path = dir / "metrics.prom";
+	{
+		MetricsExporter exporter(registry, path, 20ms);
+		counter.Add(5);
+		ASSERT_TRUE(WaitFor([&] {
+			std::ifstream in(path);
+			std::stringstream ss;
+			ss << in.rdbuf();
+			return ss.str().find("test_total 5\n") != std::string::npos;
+		}));
+		counter.Add(2);
+	}
+	// 退出前再写一次，且不留下临时文件
+	std::ifstream in(path);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	EXPECT_NE(ss.str().find("test_total 7\n"), std::string::npos);
+	EXPECT_FALSE(std::filesystem::exists(dir / "metrics.prom.tmp"));
+}
+
+TEST(MetricsTest, CollectorsRunBeforeEachExport)
+{
+	MetricsRegistry registry;
+	auto& gauge = registry.AddGauge("test_depth", "Depth.");
+	int calls = 0;
+	registry.AddCollector([&]() { gauge.Set(++calls * 10); });
+	EXPECT_EQ(GetMetric(registry, "test_depth"), 10);
+	EXPECT_EQ(GetMetric(registry, "test_depth"), 20);
+}
@@ -0,0 +1,152 @@
+﻿#include <gtest/gtest.h>
+
+#include <random>
+
+#include "PathTrie.h"
+#include "CaseFold.h"
+
+namespace
+{
+	std::vector<std::wstring> Split(std::wstring_view path)
+	{
+		std::vector<std::wstring> components;
+		std::wstring current;
+		for (auto c : path)
+		{
+			if (c == L'\\' || c == L'/')
+			{
+				if (!current.empty())
+				{
+					components.push_back(std::move(current));
+					current.clear();
+				}
+			}
+			else
+			{
+				current += c;
+			}
+		}
+		if (!current.empty())
+		{
+			components.push_back(std::move(current));
+		}
+		return components;
+	}
+
+	// 逐条检查每个前缀的分量是否都与路径开头的分量相同，取分量最多的，相同时取最先添加的
+	size_t MatchLinear(const std::vector<std::wstring>& prefixes, std::wstring_view path)
+	{
+		auto components = Split(FoldCase(path));
+		auto best = PathTrie::npos;
+		size_t bestDepth = 0;
+		for (size_t i = 0; i < prefixes.size(); i++)
+		{
+			auto prefix = Split(FoldCase(prefixes[i]));
+			if (prefix.size() > components.size() || !std::equal(prefix.begin(), prefix.end(), components.begin()))
+			{
+				continue;
+			}
+			if (best == PathTrie::npos || prefix.size() > bestDepth)
+			{
+				best = i;
+				bestDepth = prefix.size();
+			}
+		}
+		return best;
+	}
+}
+
+TEST(PathTrieTest, MatchesWholeComponents)
+{
+	PathTrie trie;
+	EXPECT_TRUE(trie.IsEmpty());
+	trie.Add(L"D:\\Games", 0);
+	EXPECT_FALSE(trie.IsEmpty());
+	EXPECT_EQ(trie.Match(L"d:\\games\\game\\game.exe"), 0u);
+	EXPECT_EQ(trie.Match(L"d:\\games"), 0u);
+	// 名称开头相同的兄弟目录不匹配
+	EXPECT_EQ(trie.Match(L"d:\\gamesold\\game.exe"), PathTrie::npos);
+	EXPECT_EQ(trie.Match(L"d:\\game"), PathTrie::npos);
+	EXPECT_EQ(trie.Match(L"c:\\games\\game.exe"), PathTrie::npos);
+	EXPECT_EQ(trie.Match(L""), PathTrie::npos);
+}
+
+TEST(PathTrieTest, NormalizesSeparatorsAndCase)
+{
+	PathTrie trie;
+	trie.Add(L"C:/Program Files//Steam\\", 0);
+	EXPECT_EQ(trie.Match(L"c:\\program files\\steam\\steam.exe"), 0u);
+	EXPECT_EQ(trie.Match(L"c:/program files/steam/steamapps/common/x.exe"), 0u);
+	EXPECT_EQ(trie.Match(L"\\\\c:\\\\program files\\steam"), 0u);
+	// 查找的输入必须已经折叠过大小写
+	EXPECT_EQ(trie.Match(L"C:\\Program Files\\Steam\\steam.exe"), PathTrie::npos);
+	EXPECT_EQ(trie.Match(L"c:\\ＰＲＯＧＲＡＭ files\\steam"), PathTrie::npos);
+
+	PathTrie wide;
+	wide.Add(L"D:\\游戏\\ＧＡＭＥＳ", 3);
+	EXPECT_EQ(wide.Match(FoldCase(L"D:\\游戏\\ｇａｍｅｓ\\原神.exe")), 3u);
+}
+
+TEST(PathTrieTest, LongestPrefixWins)
+{
+	PathTrie trie;
+	trie.Add(L"/games", 5);
+	trie.Add(L"/games/shooter", 9);
+	trie.Add(L"/games/shooter/beta", 2);
+	// 重复的前缀保留最先添加的 id
+	trie.Add(L"/Games/", 7);
+	EXPECT_EQ(trie.Match(L"/games/puzzle/p.exe"), 5u);
+	EXPECT_EQ(trie.Match(L"/games/shooter/s.exe"), 9u);
+	EXPECT_EQ(trie.Match(L"/games/shooter/beta/s.exe"), 2u);
+	EXPECT_EQ(trie.Match(L"/games/shooter/betaold/s.exe"), 9u);
+}
+
+TEST(PathTrieTest, EmptyPrefixMatchesEverything)
+{
+	PathTrie trie;
+	trie.Add(L"\\", 4);
+	trie.Add(L"/apps", 1);
+	EXPECT_EQ(trie.Match(L"/other/x.exe"), 4u);
+	EXPECT_EQ(trie.Match(L"/apps/x.exe"), 1u);
+	EXPECT_EQ(trie.Match(L""), 4u);
+}
+
+// 随机的前缀和路径，与逐条比较分量的结果对比
+TEST(PathTrieTest, AgreesWithLinearScan)
+{
+	const std::vector<std::wstring> components{ L"a", L"A", L"ab", L"games", L"GAMES", L"游戏" };
+	const std::vector<std::wstring> separators{ L"/", L"\\", L"//", L"\\/" };
+	std::mt19937 rng(24);
+	auto pick = [&](auto&& v) -> auto&& { return v[rng() % v.size()]; };
+	auto makePath = [&](size_t maxDepth) {
+		std::wstring path;
+		auto depth = rng() % (maxDepth + 1);
+		for (size_t i = 0; i < depth; i++)
+		{
+			path += pick(separators);
+			path += pick(components);
+		}
+		if (rng() % 3 == 0)
+		{
+			path += pick(separators);
+		}
+		return path;
+	};
+
+	for (int round = 0; round < 500; round++)
+	{
+		std::vector<std::wstring> prefixes;
+		PathTrie trie;
+		auto count = rng() % 10;
+		for (size_t i = 0; i < count; i++)
+		{
+			prefixes.push_back(makePath(3));
+			trie.Add(prefixes.back(), i);
+		}
+		for (int i = 0; i < 50; i++)
+		{
+			auto path = makePath(5);
+			ASSERT_EQ(trie.Match(FoldCase(path)), MatchLinear(prefixes, path)) << "round " << round;
+		}
+	}
+}
@@ -0,0 +1,164 @@
+﻿#include <gtest/gtest.h>
+
+#include <map>
+
+#include "ProcessInfoCache.h"
+
+namespace
+{
+	// 进程表由测试直接修改，同时记录查询路径的次数
+	class FakeResolver : public ProcessResolver
+	{
+	public:
+		struct Process
+		{
+			uint64_t StartTime;
+			std::optional<std::wstring> Path;
+		};
+
+		virtual std::optional<uint64_t> GetStartTime(uint32_t pid) override
+		{
+			auto it = Processes.find(pid);
+			if (it == Processes.end())
+			{
+				return {};
+			}
+			return it->second.StartTime;
+		}
+
+		virtual std::optional<std::wstring> GetImagePath(uint32_t pid) override
+		{
+			PathQueries++;
+			auto it = Processes.find(pid);
+			if (it == Processes.end())
+			{
+				return {};
+			}
+			return it->second.Path;
+		}
+
+		std::map<uint32_t, Process> Processes;
+		size_t PathQueries = 0;
+	};
+
+	class ProcessInfoCacheTest : public testing::Test
+	{
+	protected:
+		void Spawn(uint32_t pid, uint64_t startTime, std::optional<std::wstring> path)
+		{
+			m_resolver->Processes[pid] = { startTime, std::move(path) };
+		}
+
+		std::shared_ptr<FakeResolver> m_resolver = std::make_shared<FakeResolver>();
+	};
+}
+
+TEST_F(ProcessInfoCacheTest, CachesByPidAndStartTime)
+{
+	ProcessInfoCache cache(m_resolver);
+	Spawn(100, 1, L"/Apps/Game.exe");
+	auto first = cache.Get(100);
+	EXPECT_EQ(first->Pid, 100u);
+	EXPECT_EQ(first->StartTime, 1u);
+	EXPECT_EQ(first->Path, std::filesystem::path(L"/Apps/Game.exe"));
+	EXPECT_EQ(first->FoldedPath.Text, L"/apps/game.exe");
+	EXPECT_EQ(first->FoldedFileName.Text, L"game.exe");
+
+	auto second = cache.Get(100);
+	EXPECT_EQ(second, first);
+	EXPECT_EQ(m_resolver->PathQueries, 1u);
+	auto stats = cache.GetStats();
+	EXPECT_EQ(stats.Hits, 1u);
+	EXPECT_EQ(stats.Misses, 1u);
+	EXPECT_EQ(stats.Size, 1u);
+}
+
+TEST_F(ProcessInfoCacheTest, ReusedPidGetsFreshEntry)
+{
+	ProcessInfoCache cache(m_resolver);
+	Spawn(100, 1, L"/apps/game.exe");
+	auto old = cache.Get(100);
+	// 进程退出后 pid 被另一个程序复用，启动时间不同
+	Spawn(100, 2, L"/apps/chat.exe");
+	auto reused = cache.Get(100);
+	EXPECT_NE(reused, old);
+	EXPECT_EQ(reused->Path, std::filesystem::path(L"/apps/chat.exe"));
+	EXPECT_EQ(reused->StartTime, 2u);
+	EXPECT_EQ(m_resolver->PathQueries, 2u);
+	EXPECT_EQ(cache.GetStats().Misses, 2u);
+	EXPECT_EQ(cache.GetStats().Size, 2u);
+}
+
+TEST_F(ProcessInfoCacheTest, EvictsLeastRecentlyUsed)
+{
+	ProcessInfoCache cache(m_resolver, 3);
+	for (uint32_t pid = 1; pid <= 4; pid++)
+	{
+		Spawn(pid, pid, L"/apps/app" + std::to_wstring(pid) + L".exe");
+	}
+	cache.Get(1);
+	cache.Get(2);
+	cache.Get(3);
+	// 访问 1 使其变为最近使用，插入 4 时淘汰 2
+	cache.Get(1);
+	cache.Get(4);
+	EXPECT_EQ(cache.GetStats().Size, 3u);
+	auto queries = m_resolver->PathQueries;
+	cache.Get(1);
+	cache.Get(3);
+	cache.Get(4);
+	EXPECT_EQ(m_resolver->PathQueries, queries);
+	cache.Get(2);
+	EXPECT_EQ(m_resolver->PathQueries, queries + 1);
+	// 重新插入 2 淘汰此时最久未使用的 1
+	cache.Get(3);
+	cache.Get(4);
+	cache.Get(1);
+	EXPECT_EQ(m_resolver->PathQueries, queries + 2);
+	EXPECT_EQ(cache.GetStats().Size, 3u);
+}
+
+TEST_F(ProcessInfoCacheTest, DoesNotCacheExitedProcess)
+{
+	ProcessInfoCache cache(m_resolver);
+	auto info = cache.Get(100);
+	EXPECT_EQ(info->Pid, 100u);
+	EXPECT_TRUE(info->Path.empty());
+	// 查不到启动时间时不会查询路径
+	EXPECT_EQ(m_resolver->PathQueries, 0u);
+	EXPECT_EQ(cache.GetStats().Misses, 1u);
+	EXPECT_EQ(cache.GetStats().Size, 0u);
+
+	// 进程之后出现时正常查询
+	Spawn(100, 1, L"/apps/game.exe");
+	EXPECT_EQ(cache.Get(100)->Path, std::filesystem::path(L"/apps/game.exe"));
+	EXPECT_EQ(cache.GetStats().Size, 1u);
+}
+
+TEST_F(ProcessInfoCacheTest, DoesNotCacheFailedPathQuery)
+{
+	ProcessInfoCache cache(m_resolver);
+	// 例如无权访问的进程，路径暂时查不到
+	Spawn(100, 1, std::nullopt);
+	auto info = cache.Get(100);
+	EXPECT_TRUE(info->Path.empty());
+	EXPECT_EQ(info->StartTime, 1u);
+	EXPECT_EQ(cache.GetStats().Size, 0u);
+
+	// 下次会重新查询，成功后才缓存
+	Spawn(100, 1, L"/apps/game.exe");
+	EXPECT_EQ(cache.Get(100)->Path, std::filesystem::path(L"/apps/game.exe"));
+	EXPECT_EQ(m_resolver->PathQueries, 2u);
+	EXPECT_EQ(cache.GetStats().Size, 1u);
+	EXPECT_EQ(cache.GetStats().Misses, 2u);
+}
+
+TEST_F(ProcessInfoCacheTest, SystemIdleProcessIsNotQueried)
+{
+	ProcessInfoCache cache(m_resolver);
+	auto info = cache.Get(0);
+	EXPECT_EQ(info->Pid, 0u);
+	EXPECT_TRUE(info->Path.empty());
+	EXPECT_EQ(m_resolver->PathQueries, 0u);
+	EXPECT_EQ(cache.GetStats().Hits + cache.GetStats().Misses, 0u);
+}
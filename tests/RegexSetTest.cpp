@@ -0,0 +1,179 @@
+﻿#include <gtest/gtest.h>
+
+#include <regex>
+#include <random>
+
+#include "RegexSet.h"
+
+namespace
+{
+	bool StdMatch(const std::wstring& pattern, const std::wstring& s)
+	{
+		return std::regex_match(s, std::wregex(pattern, std::regex::ECMAScript | std::regex::icase));
+	}
+
+	// 从支持的语法子集中随机生成表达式
+	class PatternGenerator
+	{
+	public:
+		explicit PatternGenerator(uint32_t seed) : m_rng(seed)
+		{
+		}
+
+		std::wstring Next()
+		{
+			return Alternation(2);
+		}
+
+	private:
+		std::wstring Alternation(int depth)
+		{
+			auto s = Sequence(depth);
+			while (m_rng() % 4 == 0)
+			{
+				s += L"|" + Sequence(depth);
+			}
+			return s;
+		}
+
+		std::wstring Sequence(int depth)
+		{
+			std::wstring s;
+			auto count = 1 + m_rng() % 4;
+			for (size_t i = 0; i < count; i++)
+			{
+				auto atom = Atom(depth);
+				// 分组只加 ?，嵌套的重复会让 std::regex 的回溯呈指数增长，测试太慢
+				s += atom + (atom.back() == L')' ? (m_rng() % 3 ? L"" : L"?") : Quantifier());
+			}
+			return s;
+		}
+
+		std::wstring Atom(int depth)
+		{
+			static const wchar_t* atoms[] = { L"a", L"B", L"c", L"/", L"\\.", L".", L"[a-c]", L"[^a/]", L"\\d", L"\\w", L"\\D", L"[A-B1]", L"\\x41", L"\\u0062" };
+			if (depth > 0 && m_rng() % 5 == 0)
+			{
+				return (m_rng() % 2 ? L"(" : L"(?:") + Alternation(depth - 1) + L")";
+			}
+			return atoms[m_rng() % std::size(atoms)];
+		}
+
+		std::wstring Quantifier()
+		{
+			static const wchar_t* quantifiers[] = { L"", L"", L"", L"*", L"+", L"?", L"{2}", L"{1,3}", L"{0,}", L"*?", L"+?" };
+			return quantifiers[m_rng() % std::size(quantifiers)];
+		}
+
+		std::mt19937 m_rng;
+	};
+}
+
+TEST(RegexSetTest, MatchesWholeStringIgnoringCase)
+{
+	RegexSet set;
+	ASSERT_TRUE(set.Add(L".*/Tools/.+\\.exe", 0));
+	EXPECT_EQ(set.Match(L"/opt/tools/mixer.EXE"), 0u);
+	EXPECT_EQ(set.Match(L"/opt/tools/.exe"), RegexSet::npos);
+	// 完整匹配，不接受部分匹配
+	EXPECT_EQ(set.Match(L"/opt/tools/mixer.exe.bak"), RegexSet::npos);
+	EXPECT_TRUE(RegexSet().IsEmpty());
+	EXPECT_FALSE(set.IsEmpty());
+}
+
+TEST(RegexSetTest, ReportsLowestMatchingId)
+{
+	RegexSet set;
+	ASSERT_TRUE(set.Add(L".*/games/.*", 2));
+	ASSERT_TRUE(set.Add(L".*\\.exe", 5));
+	ASSERT_TRUE(set.Add(L"/games/(a|b)\\.exe", 7));
+	EXPECT_EQ(set.Match(L"/games/a.exe"), 2u);
+	EXPECT_EQ(set.Match(L"/apps/a.exe"), 5u);
+	EXPECT_EQ(set.Match(L"/apps/a.dll"), RegexSet::npos);
+}
+
+// . 不匹配任何行终止符，与 std::wregex 一致
+TEST(RegexSetTest, DotExcludesLineTerminators)
+{
+	const std::wstring patterns[] = { L".", L"a.b", L".*", L"[^a]", L"\\D" };
+	const std::wstring inputs[] = { L"x", L"\n", L"\r", L"\u2028", L"\u2029", L"\u0085", L"a\u2028b", L"a\u2029b", L"axb", L"ab\u2028" };
+	for (auto&& pattern : patterns)
+	{
+		RegexSet set;
+		ASSERT_TRUE(set.Add(pattern, 0));
+		for (auto&& input : inputs)
+		{
+			EXPECT_EQ(set.Match(input) == 0, StdMatch(pattern, input)) << testing::PrintToString(pattern) << " " << testing::PrintToString(input);
+		}
+	}
+}
+
+TEST(RegexSetTest, RejectsUnsupportedSyntax)
+{
+	RegexSet set;
+	// 反向引用、先行断言、单词边界和 POSIX 字符类需要回退到 std::wregex
+	for (auto pattern : { L"(a)\\1", L"a(?=b)", L"a(?!b)", L"\\bgame", L"a\\B", L"[[:alpha:]]+" })
+	{
+		EXPECT_FALSE(set.Add(pattern, 0)) << std::string(pattern, pattern + wcslen(pattern));
+	}
+	EXPECT_TRUE(set.IsEmpty());
+	// 字符类中的 \b 是退格
+	EXPECT_TRUE(set.Add(L"[\\b]", 0));
+}
+
+TEST(RegexSetTest, AgreesWithStdRegexOnRandomPatterns)
+{
+	const std::wstring alphabet = L"abcAB/.1_ ";
+	PatternGenerator generator(7);
+	std::mt19937 rng(11);
+	size_t supported = 0;
+	for (int round = 0; round < 300; round++)
+	{
+		std::vector<std::wstring> patterns;
+		RegexSet set;
+		for (size_t id = 0; id < 4; id++)
+		{
+			patterns.push_back(generator.Next());
+			supported += set.Add(patterns.back(), id);
+		}
+
+		for (int input = 0; input < 60; input++)
+		{
+			std::wstring s;
+			auto length = rng() % 8;
+			for (size_t i = 0; i < length; i++)
+			{
+				s += alphabet[rng() % alphabet.size()];
+			}
+			auto expected = RegexSet::npos;
+			for (size_t id = 0; id < patterns.size(); id++)
+			{
+				if (StdMatch(patterns[id], s))
+				{
+					expected = id;
+					break;
+				}
+			}
+			ASSERT_EQ(set.Match(s), expected) << "round " << round << " input " << std::string(s.begin(), s.end());
+		}
+	}
+	// 生成的表达式都在支持的子集内
+	EXPECT_EQ(supported, 300u * 4);
+}
+
+TEST(RegexSetTest, SurvivesDfaCacheReset)
+{
+	// 足够多的不同前缀使 DFA 状态超过缓存上限，清空重建后结果不变
+	RegexSet set;
+	ASSERT_TRUE(set.Add(L"(a|b)*a(a|b){11}", 0));
+	std::mt19937 rng(3);
+	for (int i = 0; i < 2000; i++)
+	{
+		std::wstring s;
+		for (int k = 0; k < 20; k++)
+		{
+			s += rng() % 2 ? L'a' : L'b';
+		}
+		ASSERT_EQ(set.Match(s) == 0, StdMatch(L"(a|b)*a(a|b){11}", s)) << std::string(s.begin(), s.end());
+	}
+}
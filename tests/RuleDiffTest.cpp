@@ -0,0 +1,118 @@
+﻿#include <gtest/gtest.h>
+
+#include "RuleDiff.h"
+
+namespace
+{
+	using Type = ConfigItem::PathType;
+
+	// 内存中的会话表，代替设备上的会话
+	struct FakeSession
+	{
+		std::string Name;
+		std::shared_ptr<const ProcessInfo> Info;
+	};
+
+	std::vector<FakeSession> MakeSessions()
+	{
+		std::vector<FakeSession> sessions;
+		uint32_t pid = 100;
+		for (auto path : { "/apps/game.exe", "/apps/player.exe", "/apps/chat.exe", "/tools/mixer.exe", "/apps/browser.exe" })
+		{
+			sessions.push_back({ path, ProcessInfoCache::MakeInfo(pid++, 0, path) });
+		}
+		return sessions;
+	}
+
+	std::vector<SessionChange<FakeSession>> Reevaluate(const std::vector<FakeSession>& sessions, const std::vector<ConfigItem>& oldConfigs, const std::vector<ConfigItem>& newConfigs)
+	{
+		return ReevaluateSessions(sessions, RuleIndex(oldConfigs), RuleIndex(newConfigs), [](const FakeSession& s) -> const ProcessInfo& { return *s.Info; });
+	}
+
+	const std::vector<ConfigItem> BaseRules{
+		{ Type::FileName, L"game.exe", 20 },
+		{ Type::FileName, L"player.exe", 30 },
+		{ Type::Regex, L".*/tools/.+\\.exe", 40 },
+	};
+}
+
+TEST(RuleDiffTest, CountsAddedAndRemovedRules)
+{
+	auto diff = DiffRules(BaseRules, BaseRules);
+	EXPECT_FALSE(diff.Changed);
+	EXPECT_EQ(diff.Added, 0u);
+	EXPECT_EQ(diff.Removed, 0u);
+
+	auto configs = BaseRules;
+	configs[1].Volume = 35;
+	configs.push_back({ Type::FullPath, L"/apps/chat.exe", 50 });
+	diff = DiffRules(BaseRules, configs);
+	EXPECT_TRUE(diff.Changed);
+	// 修改音量相当于删除一条再新增一条
+	EXPECT_EQ(diff.Added, 2u);
+	EXPECT_EQ(diff.Removed, 1u);
+
+	diff = DiffRules(BaseRules, {});
+	EXPECT_EQ(diff.Removed, 3u);
+}
+
+TEST(RuleDiffTest, ReorderingIsAChange)
+{
+	// 首个匹配的规则优先，顺序变化可能改变结果
+	auto configs = BaseRules;
+	std::swap(configs[0], configs[2]);
+	auto diff = DiffRules(BaseRules, configs);
+	EXPECT_TRUE(diff.Changed);
+	EXPECT_EQ(diff.Added, 0u);
+	EXPECT_EQ(diff.Removed, 0u);
+}
+
+TEST(RuleDiffTest, ReturnsOnlyAffectedSessions)
+{
+	auto sessions = MakeSessions();
+	auto configs = BaseRules;
+	// player 音量变化，game 不再是目标，chat 成为目标，mixer 和 browser 不变
+	configs.erase(configs.begin());
+	configs[0].Volume = 35;
+	configs.push_back({ Type::FullPath, L"/APPS/CHAT.EXE", 50 });
+
+	auto changes = Reevaluate(sessions, BaseRules, configs);
+	ASSERT_EQ(changes.size(), 3u);
+	EXPECT_EQ(changes[0].Session.Name, "/apps/game.exe");
+	EXPECT_EQ(changes[0].OldVolume, 20);
+	EXPECT_EQ(changes[0].NewVolume, std::nullopt);
+	EXPECT_EQ(changes[1].Session.Name, "/apps/player.exe");
+	EXPECT_EQ(changes[1].OldVolume, 30);
+	EXPECT_EQ(changes[1].NewVolume, 35);
+	EXPECT_EQ(changes[2].Session.Name, "/apps/chat.exe");
+	EXPECT_EQ(changes[2].OldVolume, std::nullopt);
+	EXPECT_EQ(changes[2].NewVolume, 50);
+}
+
+TEST(RuleDiffTest, IgnoresChangesThatKeepTheVolume)
+{
+	auto sessions = MakeSessions();
+	// 换了匹配的规则，但目标音量相同，不需要处理
+	std::vector<ConfigItem> configs{
+		{ Type::FullPath, L"/apps/game.exe", 20 },
+		{ Type::Regex, L".*/(player|unused)\\.exe", 30 },
+		{ Type::Regex, L".*/tools/.+\\.exe", 40 },
+	};
+	EXPECT_TRUE(DiffRules(BaseRules, configs).Changed);
+	EXPECT_TRUE(Reevaluate(sessions, BaseRules, configs).empty());
+}
+
+TEST(RuleDiffTest, ReorderChangesFirstMatch)
+{
+	auto sessions = MakeSessions();
+	std::vector<ConfigItem> oldConfigs{
+		{ Type::FileName, L"mixer.exe", 10 },
+		{ Type::Regex, L".*/tools/.+\\.exe", 40 },
+	};
+	std::vector<ConfigItem> newConfigs{ oldConfigs[1], oldConfigs[0] };
+	auto changes = Reevaluate(sessions, oldConfigs, newConfigs);
+	ASSERT_EQ(changes.size(), 1u);
+	EXPECT_EQ(changes[0].Session.Name, "/tools/mixer.exe");
+	EXPECT_EQ(changes[0].OldVolume, 10);
+	EXPECT_EQ(changes[0].NewVolume, 40);
+}
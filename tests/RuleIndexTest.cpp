@@ -0,0 +1,175 @@
+﻿#include <gtest/gtest.h>
+
+#include <random>
+#include <cwctype>
+
+#include "RuleIndex.h"
+
+namespace
+{
+	using Type = ConfigItem::PathType;
+
+	std::wstring Lower(std::wstring s)
+	{
+		for (auto&& c : s)
+		{
+			c = static_cast<wchar_t>(std::towlower(c));
+		}
+		return s;
+	}
+
+	// 修改前 VolumeLock::GetConfig 的做法：按顺序逐条比较，每次都重新转换大小写和编译正则
+	const ConfigItem* FindLinear(const std::vector<ConfigItem>& configs, const std::filesystem::path& path)
+	{
+		for (auto&& item : configs)
+		{
+			switch (item.Type)
+			{
+			case Type::FullPath:
+				if (Lower(path.wstring()) == Lower(item.Path))
+				{
+					return &item;
+				}
+				break;
+			case Type::FileName:
+				if (Lower(path.filename().wstring()) == Lower(item.Path))
+				{
+					return &item;
+				}
+				break;
+			case Type::Regex:
+				if (std::regex_match(path.wstring(), std::wregex(item.Path, std::regex::ECMAScript | std::regex::icase)))
+				{
+					return &item;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+		return nullptr;
+	}
+
+	int FindVolume(const RuleIndex& index, const std::filesystem::path& path)
+	{
+		auto config = index.Find(path);
+		return config ? config->Volume : -1;
+	}
+}
+
+TEST(RuleIndexTest, MatchesIgnoringCase)
+{
+	RuleIndex index({
+		{ Type::FullPath, L"/Games/Launcher/Launcher.EXE", 10 },
+		{ Type::FileName, L"Player.exe", 20 },
+		{ Type::Regex, L".*/tools/.+\\.exe", 30 },
+	});
+	EXPECT_EQ(FindVolume(index, L"/games/launcher/launcher.exe"), 10);
+	EXPECT_EQ(FindVolume(index, L"/any/dir/PLAYER.EXE"), 20);
+	EXPECT_EQ(FindVolume(index, L"/opt/TOOLS/Mixer.exe"), 30);
+	EXPECT_EQ(FindVolume(index, L"/games/launcher.exe"), -1);
+	EXPECT_EQ(FindVolume(index, L"/opt/tools/"), -1);
+	EXPECT_TRUE(RuleIndex().IsEmpty());
+	EXPECT_EQ(RuleIndex().Find(std::filesystem::path(L"/a.exe")), nullptr);
+}
+
+TEST(RuleIndexTest, ReturnsFirstMatchInConfigOrder)
+{
+	// 同一路径被多条规则匹配时，靠前的规则优先，与规则类型无关
+	RuleIndex index({
+		{ Type::Regex, L".*/music/.*", 1 },
+		{ Type::FileName, L"a.exe", 2 },
+		{ Type::FullPath, L"/music/a.exe", 3 },
+		{ Type::FullPath, L"/games/a.exe", 4 },
+		{ Type::FileName, L"b.exe", 5 },
+		{ Type::FileName, L"B.EXE", 6 },
+		{ Type::Regex, L".*\\.exe", 7 },
+	});
+	EXPECT_EQ(FindVolume(index, L"/music/a.exe"), 1);
+	EXPECT_EQ(FindVolume(index, L"/games/a.exe"), 2);
+	EXPECT_EQ(FindVolume(index, L"/games/b.exe"), 5);
+	EXPECT_EQ(FindVolume(index, L"/games/c.exe"), 7);
+}
+
+TEST(RuleIndexTest, LongestPrefixCompetesInConfigOrder)
+{
+	RuleIndex index({
+		{ Type::FileName, L"launcher.exe", 1 },
+		{ Type::Prefix, L"/Games", 2 },
+		{ Type::Regex, L".*/beta/.*", 3 },
+		{ Type::Prefix, L"/games/Shooter", 4 },
+		{ Type::FullPath, L"/games/shooter/s.exe", 5 },
+	});
+	EXPECT_EQ(FindVolume(index, L"/games/puzzle/p.exe"), 2);
+	// 更长的前缀覆盖父目录，即使它排在后面
+	EXPECT_EQ(FindVolume(index, L"/GAMES/shooter/s.exe"), 4);
+	// 最长的前缀仍按自己的位置与其他类型的规则比较
+	EXPECT_EQ(FindVolume(index, L"/games/shooter/beta/s.exe"), 3);
+	EXPECT_EQ(FindVolume(index, L"/games/shooter/launcher.exe"), 1);
+	EXPECT_EQ(FindVolume(index, L"/gamesold/s.exe"), -1);
+}
+
+TEST(RuleIndexTest, GlobRulesKeepConfigOrder)
+{
+	RuleIndex index({
+		{ Type::FileName, L"launcher.exe", 1 },
+		{ Type::Glob, L"**\\steamapps\\common\\*\\*.exe", 2 },
+		{ Type::Prefix, L"/SteamLibrary", 3 },
+		{ Type::Glob, L"/**/*.EXE", 4 },
+	});
+	// 通配符中的 \ 也匹配 /
+	EXPECT_EQ(FindVolume(index, L"/SteamLibrary/steamapps/common/Game/Game.exe"), 2);
+	EXPECT_EQ(FindVolume(index, L"/SteamLibrary/steamapps/common/Game/launcher.exe"), 1);
+	EXPECT_EQ(FindVolume(index, L"/SteamLibrary/steamapps/other.exe"), 3);
+	EXPECT_EQ(FindVolume(index, L"/Tools/x.exe"), 4);
+	EXPECT_EQ(FindVolume(index, L"/tools/x.bin"), -1);
+}
+
+TEST(RuleIndexTest, RejectsInvalidPatternsAtLoad)
+{
+	EXPECT_THROW(RuleIndex({ { Type::Regex, L"(unclosed", 1 } }), std::regex_error);
+	EXPECT_THROW(RuleIndex({ { Type::Glob, L"[unclosed", 1 } }), GlobError);
+}
+
+// 随机生成规则和路径，与逐条匹配的结果对比
+TEST(RuleIndexTest, AgreesWithLinearScan)
+{
+	const std::vector<std::wstring> dirs{ L"/apps", L"/Apps/Sub", L"/games", L"/tools" };
+	const std::vector<std::wstring> names{ L"a.exe", L"A.exe", L"b.exe", L"chrome.exe", L"game.exe", L"x.bin" };
+	const std::vector<std::wstring> regexes{ L".*\\.exe", L".*/games/.*", L".*/(a|b)\\.exe", L"/apps/[a-c]\\.exe", L".*chrome.*" };
+
+	std::mt19937 rng(42);
+	auto pick = [&](auto&& v) -> auto&& { return v[rng() % v.size()]; };
+	for (int round = 0; round < 200; round++)
+	{
+		std::vector<ConfigItem> configs;
+		auto count = rng() % 8;
+		for (size_t i = 0; i < count; i++)
+		{
+			switch (rng() % 3)
+			{
+			case 0:
+				configs.push_back({ Type::FullPath, pick(dirs) + L"/" + pick(names), static_cast<int>(i) });
+				break;
+			case 1:
+				configs.push_back({ Type::FileName, pick(names), static_cast<int>(i) });
+				break;
+			default:
+				configs.push_back({ Type::Regex, pick(regexes), static_cast<int>(i) });
+				break;
+			}
+		}
+
+		RuleIndex index(configs);
+		for (auto&& dir : dirs)
+		{
+			for (auto&& name : names)
+			{
+				std::filesystem::path path(dir + L"/" + name);
+				auto expected = FindLinear(configs, path);
+				auto actual = index.Find(path);
+				ASSERT_EQ(expected ? expected->Volume : -1, actual ? actual->Volume : -1) << "round " << round;
+			}
+		}
+	}
+}
@@ -0,0 +1,145 @@
+﻿#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+#include "RuleSnapshot.h"
+#include "Config.h"
+#include "TestUtil.h"
+
+namespace
+{
+	std::vector<ConfigItem> SampleRules()
+	{
+		std::vector<ConfigItem> configs(4);
+		configs[0] = { ConfigItem::PathType::FileName, L"game.exe", 20 };
+		configs[1] = { ConfigItem::PathType::FullPath, L"C:\\Program Files\\播放器\\player.exe", 40 };
+		configs[2] = { ConfigItem::PathType::Regex, L".*\\\\tools\\\\.+\\.exe", 60 };
+		configs[3] = { ConfigItem::PathType::Glob, L"**\\steam\\*.exe", 0 };
+		return configs;
+	}
+
+	std::string ReadBytes(const std::filesystem::path& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	}
+
+	void ExpectSameRules(const std::vector<ConfigItem>& actual, const std::vector<ConfigItem>& expected)
+	{
+		ASSERT_EQ(actual.size(), expected.size());
+		for (size_t i = 0; i < actual.size(); i++)
+		{
+			EXPECT_EQ(actual[i].Type, expected[i].Type);
+			EXPECT_EQ(actual[i].Path, expected[i].Path);
+			EXPECT_EQ(actual[i].Volume, expected[i].Volume);
+		}
+	}
+
+	// 文件头中版本和规则数所在的偏移
+	constexpr size_t VersionOffset = 4;
+	constexpr size_t CountOffset = 12;
+	constexpr size_t HeaderSize = 32;
+}
+
+TEST(RuleSnapshotTest, RoundTrips)
+{
+	TempDir dir;
+	auto rules = SampleRules();
+	ASSERT_TRUE(SaveRuleSnapshot(dir / "rules.cache", 42, rules));
+	auto loaded = LoadRuleSnapshot(dir / "rules.cache", 42);
+	ASSERT_TRUE(loaded.has_value());
+	ExpectSameRules(*loaded, rules);
+}
+
+TEST(RuleSnapshotTest, RejectsOtherSource)
+{
+	TempDir dir;
+	ASSERT_TRUE(SaveRuleSnapshot(dir / "rules.cache", 42, SampleRules()));
+	EXPECT_FALSE(LoadRuleSnapshot(dir / "rules.cache", 43).has_value());
+	EXPECT_FALSE(LoadRuleSnapshot(dir / "missing.cache", 42).has_value());
+}
+
+TEST(RuleSnapshotTest, RejectsEveryTruncation)
+{
+	TempDir dir;
+	ASSERT_TRUE(SaveRuleSnapshot(dir / "rules.cache", 42, SampleRules()));
+	auto bytes = ReadBytes(dir / "rules.cache");
+	for (size_t size = 0; size < bytes.size(); size++)
+	{
+		WriteFile(dir / "cut.cache", std::string_view(bytes).substr(0, size));
+		EXPECT_FALSE(LoadRuleSnapshot(dir / "cut.cache", 42).has_value()) << "size " << size;
+	}
+}
+
+TEST(RuleSnapshotTest, RejectsCorruptPayload)
+{
+	TempDir dir;
+	ASSERT_TRUE(SaveRuleSnapshot(dir / "rules.cache", 42, SampleRules()));
+	auto bytes = ReadBytes(dir / "rules.cache");
+	for (size_t i = HeaderSize; i < bytes.size(); i++)
+	{
+		auto corrupt = bytes;
+		corrupt[i] ^= 0x5a;
+		WriteFile(dir / "bad.cache", corrupt);
+		EXPECT_FALSE(LoadRuleSnapshot(dir / "bad.cache", 42).has_value()) << "offset " << i;
+	}
+}
+
+// 校验值不覆盖文件头，损坏的规则数不能导致按它预留内存
+TEST(RuleSnapshotTest, RejectsCorruptCount)
+{
+	TempDir dir;
+	ASSERT_TRUE(SaveRuleSnapshot(dir / "rules.cache", 42, SampleRules()));
+	auto bytes = ReadBytes(dir / "rules.cache");
+	for (uint32_t count : { 0u, 3u, 5u, 1000u, 0x7fffffffu, 0xffffffffu })
+	{
+		auto corrupt = bytes;
+		std::memcpy(corrupt.data() + CountOffset, &count, sizeof(count));
+		WriteFile(dir / "bad.cache", corrupt);
+		std::optional<std::vector<ConfigItem>> loaded;
+		EXPECT_NO_THROW(loaded = LoadRuleSnapshot(dir / "bad.cache", 42)) << "count " << count;
+		EXPECT_FALSE(loaded.has_value()) << "count " << count;
+	}
+}
+
+TEST(RuleSnapshotTest, LoadConfigWritesAndReusesSnapshot)
+{
+	TempDir dir;
+	WriteFile(dir / "config.yaml", "- {type: filename, path: game.exe, volume: 20}\n- {type: glob, path: '**\\steam\\*.exe', volume: 0}\n");
+	auto fromYaml = LoadConfig(dir / "config.yaml");
+	ASSERT_TRUE(std::filesystem::exists(dir / "config.yaml.cache"));
+	auto fromSnapshot = LoadConfig(dir / "config.yaml");
+	ExpectSameRules(fromSnapshot, fromYaml);
+
+	// 快照损坏时回退到解析 YAML，并重新写入快照
+	WriteFile(dir / "config.yaml.cache", "garbage");
+	ExpectSameRules(LoadConfig(dir / "config.yaml"), fromYaml);
+	EXPECT_GT(std::filesystem::file_size(dir / "config.yaml.cache"), HeaderSize);
+
+	// 配置文件修改后不使用旧快照
+	WriteFile(dir / "config.yaml", "- {type: filename, path: other.exe, volume: 30}\n");
+	auto changed = LoadConfig(dir / "config.yaml");
+	ASSERT_EQ(changed.size(), 1u);
+	EXPECT_EQ(changed[0].Path, L"other.exe");
+}
+
+// 规则类型的取值变化后，其他版本的快照不能被按新的取值解释
+TEST(RuleSnapshotTest, RebuildsSnapshotOfOtherVersion)
+{
+	TempDir dir;
+	WriteFile(dir / "config.yaml", "- {type: prefix, path: '/games', volume: 20}\n- {type: glob, path: '**/steam/*.exe', volume: 0}\n");
+	auto fromYaml = LoadConfig(dir / "config.yaml");
+	auto bytes = ReadBytes(dir / "config.yaml.cache");
+	uint32_t version;
+	std::memcpy(&version, bytes.data() + VersionOffset, sizeof(version));
+
+	auto old = bytes;
+	auto oldVersion = version - 1;
+	std::memcpy(old.data() + VersionOffset, &oldVersion, sizeof(oldVersion));
+	WriteFile(dir / "config.yaml.cache", old);
+	// 旧快照被拒绝，从 YAML 重新解析并写回当前版本的快照
+	ExpectSameRules(LoadConfig(dir / "config.yaml"), fromYaml);
+	EXPECT_EQ(ReadBytes(dir / "config.yaml.cache"), bytes);
+}
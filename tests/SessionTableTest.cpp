@@ -0,0 +1,129 @@
+﻿#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+#include "SessionTable.h"
+#include "AudioSimulator.h"
+
+namespace
+{
+	class SessionTableTest : public testing::Test
+	{
+	protected:
+		void AddSessions(size_t count)
+		{
+			for (size_t i = m_sessions.size(); i < count; i++)
+			{
+				m_sessions.push_back(m_device->AddSession(static_cast<uint32_t>(1000 + i), "/apps/app" + std::to_string(i) + ".exe"));
+			}
+		}
+
+		SimAudioDeviceEnumerator m_enumerator;
+		std::shared_ptr<SimAudioDevice> m_device = m_enumerator.AddDevice(L"dev", L"Speakers");
+		std::vector<std::shared_ptr<AudioSession>> m_sessions;
+		SessionTable m_table;
+	};
+}
+
+TEST_F(SessionTableTest, InsertsFindsAndErases)
+{
+	AddSessions(3);
+	auto handle = m_table.Insert(m_sessions[0], m_device, 20);
+	m_table.Insert(m_sessions[1], m_device, 30);
+	EXPECT_EQ(m_table.Size(), 2u);
+
+	auto entry = m_table.Get(m_sessions[0]);
+	ASSERT_NE(entry, nullptr);
+	EXPECT_EQ(entry->TargetVolume, 20);
+	EXPECT_EQ(entry->Pid, 1000u);
+	EXPECT_EQ(entry->Device, m_device);
+	EXPECT_EQ(m_table.Find(m_sessions[0].get()), handle);
+	// 不在表中的会话不会被插入，也不会得到默认的目标音量
+	EXPECT_EQ(m_table.Get(m_sessions[2]), nullptr);
+	EXPECT_EQ(m_table.Size(), 2u);
+
+	// 重复插入返回已有的项
+	EXPECT_EQ(m_table.Insert(m_sessions[0], m_device, 90), handle);
+	EXPECT_EQ(m_table.Get(handle)->TargetVolume, 20);
+
+	EXPECT_TRUE(m_table.Erase(handle));
+	EXPECT_FALSE(m_table.Erase(handle));
+	EXPECT_EQ(m_table.Get(m_sessions[0]), nullptr);
+	EXPECT_EQ(m_table.Get(m_sessions[1])->TargetVolume, 30);
+	EXPECT_EQ(m_table.Size(), 1u);
+}
+
+TEST_F(SessionTableTest, HandleDoesNotFollowReusedSlot)
+{
+	AddSessions(2);
+	auto old = m_table.Insert(m_sessions[0], m_device, 20);
+	m_table.Erase(old);
+	// 新会话复用同一个槽位，旧句柄（例如排队中的重试）不会指向它
+	auto reused = m_table.Insert(m_sessions[1], m_device, 30);
+	EXPECT_EQ(reused.Index, old.Index);
+	EXPECT_EQ(m_table.Get(old), nullptr);
+	EXPECT_EQ(m_table.Get(reused)->Session, m_sessions[1]);
+	EXPECT_EQ(m_table.Get(SessionHandle{}), nullptr);
+}
+
+TEST_F(SessionTableTest, HandlesSurviveGrowth)
+{
+	AddSessions(1000);
+	std::vector<SessionHandle> handles;
+	for (size_t i = 0; i < m_sessions.size(); i++)
+	{
+		handles.push_back(m_table.Insert(m_sessions[i], m_device, static_cast<int>(i % 101)));
+	}
+	for (size_t i = 0; i < m_sessions.size(); i++)
+	{
+		auto entry = m_table.Get(handles[i]);
+		ASSERT_NE(entry, nullptr);
+		EXPECT_EQ(entry->Session, m_sessions[i]);
+		EXPECT_EQ(entry->TargetVolume, static_cast<int>(i % 101));
+	}
+
+	size_t visited = 0;
+	m_table.ForEach([&](SessionHandle handle, SessionEntry& entry) {
+		EXPECT_EQ(m_table.Get(handle), &entry);
+		visited++;
+	});
+	EXPECT_EQ(visited, m_sessions.size());
+}
+
+// 随机插入和删除，与 std::map 对比，覆盖删除时后移补位的各种回绕情况
+TEST_F(SessionTableTest, AgreesWithMapUnderChurn)
+{
+	AddSessions(300);
+	std::map<AudioSession*, int> model;
+	std::mt19937 rng(5);
+	for (int op = 0; op < 200000; op++)
+	{
+		auto& session = m_sessions[rng() % m_sessions.size()];
+		if (rng() % 2)
+		{
+			auto volume = static_cast<int>(rng() % 101);
+			m_table.Insert(session, m_device, volume);
+			model.emplace(session.get(), volume);
+		}
+		else
+		{
+			EXPECT_EQ(m_table.Erase(m_table.Find(session.get())), model.erase(session.get()) == 1);
+		}
+
+		if (op % 1000 == 0)
+		{
+			ASSERT_EQ(m_table.Size(), model.size());
+			for (auto&& s : m_sessions)
+			{
+				auto entry = m_table.Get(s);
+				auto it = model.find(s.get());
+				ASSERT_EQ(entry != nullptr, it != model.end()) << "op " << op;
+				if (entry)
+				{
+					ASSERT_EQ(entry->TargetVolume, it->second);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,420 @@
+﻿#include <gtest/gtest.h>
+
+#include "VolumeLock.h"
+#include "AudioSimulator.h"
+#include "TestUtil.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	// 在模拟后端上运行 VolumeLock，不合并音量事件，便于用 Drain 同步
+	class SimulatorTest : public testing::Test
+	{
+	protected:
+		void WriteConfig(std::string_view yaml)
+		{
+			WriteFile(m_dir / "config.yaml", yaml);
+		}
+
+		std::unique_ptr<VolumeLock> Start()
+		{
+			auto lock = std::make_unique<VolumeLock>(m_enumerator, m_dir / "config.yaml", 0ms);
+			lock->Drain();
+			return lock;
+		}
+
+		TempDir m_dir;
+		SimAudioDeviceEnumerator m_enumerator;
+	};
+}
+
+TEST_F(SimulatorTest, LocksExistingTargetOnStartup)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto game = device->AddSession(100, "/apps/game.exe", 80);
+	auto other = device->AddSession(101, "/apps/other.exe", 50);
+
+	auto lock = Start();
+	EXPECT_EQ(game->GetVolume(), 20);
+	// 非目标会话恢复到 100
+	EXPECT_EQ(other->GetVolume(), 100);
+	EXPECT_EQ(game->GetWriteCount(), 1u);
+}
+
+TEST_F(SimulatorTest, CorrectsVolumeChanges)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto game = device->AddSession(100, "/apps/game.exe", 20);
+
+	auto lock = Start();
+	EXPECT_EQ(game->GetWriteCount(), 0u);
+	game->ChangeVolume(70);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 20);
+	EXPECT_EQ(game->GetWriteCount(), 1u);
+}
+
+TEST_F(SimulatorTest, LocksSessionsAddedLater)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+
+	auto lock = Start();
+	auto game = device->AddSession(100, "/apps/game.exe", 90);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 20);
+}
+
+TEST_F(SimulatorTest, StopsEnforcingRemovedSessions)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto game = device->AddSession(100, "/apps/game.exe", 20);
+
+	auto lock = Start();
+	device->RemoveSession(game);
+	lock->Drain();
+	game->ChangeVolume(70);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 70);
+}
+
+TEST_F(SimulatorTest, ReattachesReenabledDevice)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto game = device->AddSession(100, "/apps/game.exe", 20);
+
+	auto lock = Start();
+	m_enumerator.SetDeviceState(device, DeviceState::Disabled);
+	lock->Drain();
+	game->ChangeVolume(70);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 70);
+
+	m_enumerator.SetDeviceState(device, DeviceState::Active);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 20);
+}
+
+TEST_F(SimulatorTest, ReportsWritesThroughContext)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	std::atomic<int> writes{ 0 };
+	std::atomic<int> lastVolume{ -1 };
+	SimContext context;
+	context.OnWrite = [&](const std::shared_ptr<SimAudioSession>&, int volume) {
+		writes++;
+		lastVolume = volume;
+	};
+	SimAudioDeviceEnumerator enumerator(context);
+	auto device = enumerator.AddDevice(L"dev", L"Speakers");
+	device->AddSession(100, "/apps/game.exe", 80);
+
+	VolumeLock lock(enumerator, m_dir / "config.yaml", 0ms);
+	lock.Drain();
+	EXPECT_EQ(writes.load(), 1);
+	EXPECT_EQ(lastVolume.load(), 20);
+}
+
+TEST_F(SimulatorTest, SkipsExpiredSessionOnAttach)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto dead = device->AddSession(100, "/apps/game.exe", 80);
+	auto game = device->AddSession(101, "/apps/game.exe", 80);
+	dead->Expire();
+
+	// 失效的会话只跳过它自己，同一设备上的其他会话和之后新增的会话照常处理
+	auto lock = Start();
+	EXPECT_EQ(game->GetVolume(), 20);
+	auto later = device->AddSession(102, "/apps/game.exe", 90);
+	lock->Drain();
+	EXPECT_EQ(later->GetVolume(), 20);
+}
+
+TEST_F(SimulatorTest, SurvivesSessionExpiringWhileQueued)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto dead = device->AddSession(100, "/apps/game.exe", 20);
+	auto game = device->AddSession(101, "/apps/game.exe", 20);
+
+	// 纠正失效会话的音量时后端抛出异常，事件循环记录后继续处理后面的事件
+	auto lock = Start();
+	dead->ChangeVolume(70);
+	dead->Expire();
+	game->ChangeVolume(70);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 20);
+}
+
+// 模拟另一个同样锁定音量的程序：每次本程序写入后立即改回 100
+TEST_F(SimulatorTest, ThrottlesSessionThatFightsBack)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	std::atomic<SimAudioSession*> adversary{ nullptr };
+	SimContext context;
+	context.OnWrite = [&](const std::shared_ptr<SimAudioSession>& session, int) {
+		if (session.get() == adversary.load())
+		{
+			session->ChangeVolume(100);
+		}
+	};
+	SimAudioDeviceEnumerator enumerator(context);
+	auto device = enumerator.AddDevice(L"dev", L"Speakers");
+	auto fighter = device->AddSession(100, "/apps/game.exe", 80);
+	// 同一进程的另一个会话
+	auto peer = device->AddSession(100, "/apps/game.exe", 20);
+	adversary = fighter.get();
+
+	VolumeLock lock(enumerator, m_dir / "config.yaml", 0ms);
+	std::this_thread::sleep_for(1s);
+	lock.Drain();
+
+	// 不限流时一秒内会有成千上万次写入。检测前 5 次，之后按 250ms、500ms 退避
+	auto writes = fighter->GetWriteCount();
+	EXPECT_GE(writes, 5u);
+	EXPECT_LE(writes, 10u);
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_fights_detected_total"), 1);
+	EXPECT_GT(GetMetric(lock.GetMetrics(), "volumelock_throttled_total"), 0);
+	// 按进程统计的计数与总数一致
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_pid_fights_detected_total{pid=\"100\"}"), 1);
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_pid_throttled_total{pid=\"100\"}"), GetMetric(lock.GetMetrics(), "volumelock_throttled_total"));
+
+	// 退避只针对争夺的会话，同一进程的其他会话照常立即纠正
+	peer->ChangeVolume(70);
+	lock.Drain();
+	EXPECT_EQ(peer->GetVolume(), 20);
+
+	// 会话移除后状态随之释放，同一进程新建的会话不继承退避
+	adversary = nullptr;
+	device->RemoveSession(fighter);
+	auto next = device->AddSession(100, "/apps/game.exe", 80);
+	lock.Drain();
+	EXPECT_EQ(next->GetVolume(), 20);
+	EXPECT_EQ(next->GetWriteCount(), 1u);
+
+	// 进程仍有会话被锁定时保留按进程统计的序列，全部移除后删除
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_pid_fights_detected_total{pid=\"100\"}"), 1);
+	device->RemoveSession(peer);
+	device->RemoveSession(next);
+	lock.Drain();
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_pid_fights_detected_total{pid=\"100\"}"), -1);
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_pid_throttled_total{pid=\"100\"}"), -1);
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_fights_detected_total"), 1);
+}
+
+TEST_F(SimulatorTest, LocksSessionsOnEveryActiveDevice)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto speakers = m_enumerator.AddDevice(L"speakers", L"Speakers");
+	auto headset = m_enumerator.AddDevice(L"headset", L"Headset");
+	auto hdmi = m_enumerator.AddDevice(L"hdmi", L"HDMI");
+	m_enumerator.SetDeviceState(hdmi, DeviceState::Disabled);
+	auto onSpeakers = speakers->AddSession(100, "/apps/game.exe", 80);
+	auto onHeadset = headset->AddSession(101, "/apps/game.exe", 80);
+	auto onHdmi = hdmi->AddSession(102, "/apps/game.exe", 80);
+
+	auto lock = Start();
+	EXPECT_EQ(onSpeakers->GetVolume(), 20);
+	EXPECT_EQ(onHeadset->GetVolume(), 20);
+	EXPECT_EQ(onHdmi->GetVolume(), 80);
+
+	// 切换默认设备不重新处理已经监视的会话
+	m_enumerator.SetDefaultDevice(headset);
+	lock->Drain();
+	EXPECT_EQ(onSpeakers->GetWriteCount(), 1u);
+	EXPECT_EQ(onHeadset->GetWriteCount(), 1u);
+	onHeadset->ChangeVolume(60);
+	lock->Drain();
+	EXPECT_EQ(onHeadset->GetVolume(), 20);
+
+	// 移除一个设备只停止监视该设备上的会话
+	m_enumerator.RemoveDevice(speakers);
+	lock->Drain();
+	onSpeakers->ChangeVolume(60);
+	onHeadset->ChangeVolume(60);
+	lock->Drain();
+	EXPECT_EQ(onSpeakers->GetVolume(), 60);
+	EXPECT_EQ(onHeadset->GetVolume(), 20);
+}
+
+TEST_F(SimulatorTest, SkipsDeviceWhoseStateCannotBeRead)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto broken = m_enumerator.AddDevice(L"broken", L"Broken driver");
+	auto speakers = m_enumerator.AddDevice(L"speakers", L"Speakers");
+	m_enumerator.SetDefaultDevice(speakers);
+	auto game = speakers->AddSession(100, "/apps/game.exe", 80);
+	broken->AddSession(101, "/apps/game.exe", 80);
+	broken->Fail();
+
+	auto lock = Start();
+	EXPECT_EQ(game->GetVolume(), 20);
+
+	// 之后添加的异常设备同样不影响其他设备
+	auto late = m_enumerator.AddDevice(L"late", L"Late driver");
+	late->Fail();
+	game->ChangeVolume(60);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 20);
+}
+
+// 设备名称读不到时仍然监视设备，日志改用设备 ID，后续的设备和事件照常处理
+TEST_F(SimulatorTest, MonitorsDeviceWhoseNameCannotBeRead)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto nameless = m_enumerator.AddDevice(L"nameless", L"Vanishing headset");
+	auto speakers = m_enumerator.AddDevice(L"speakers", L"Speakers");
+	m_enumerator.SetDefaultDevice(nameless);
+	auto first = nameless->AddSession(100, "/apps/game.exe", 80);
+	auto second = speakers->AddSession(101, "/apps/game.exe", 80);
+	nameless->FailProperties();
+
+	auto lock = Start();
+	EXPECT_EQ(first->GetVolume(), 20);
+	EXPECT_EQ(second->GetVolume(), 20);
+
+	auto late = m_enumerator.AddDevice(L"late", L"Late headset");
+	late->FailProperties();
+	auto third = late->AddSession(102, "/apps/game.exe", 80);
+	m_enumerator.SetDefaultDevice(late);
+	lock->Drain();
+	EXPECT_EQ(third->GetVolume(), 20);
+
+	// 拔出时同样要停止监视
+	m_enumerator.SetDeviceState(late, DeviceState::Unplugged);
+	lock->Drain();
+	third->ChangeVolume(60);
+	lock->Drain();
+	EXPECT_EQ(third->GetVolume(), 60);
+	EXPECT_EQ(GetMetric(lock->GetMetrics(), "volumelock_target_sessions"), 2);
+}
+
+TEST_F(SimulatorTest, CoalescesSliderDrag)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto game = device->AddSession(100, "/apps/game.exe", 20);
+
+	VolumeLock lock(m_enumerator, m_dir / "config.yaml", 200ms);
+	lock.Drain();
+	// 窗口内拖动滑块产生的一串事件只纠正一次；模拟后端和 Core Audio 一样不通知自己的写入
+	for (int volume = 30; volume <= 80; volume += 5)
+	{
+		game->ChangeVolume(volume);
+	}
+	lock.Drain();
+	EXPECT_EQ(game->GetWriteCount(), 0u);
+	ASSERT_TRUE(WaitFor([&] { return game->GetWriteCount() == 1; }));
+	EXPECT_EQ(game->GetVolume(), 20);
+	std::this_thread::sleep_for(300ms);
+	EXPECT_EQ(game->GetWriteCount(), 1u);
+	EXPECT_EQ(GetMetric(lock.GetMetrics(), "volumelock_corrections_total"), 1);
+}
+
+TEST_F(SimulatorTest, HotReloadsChangedRules)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n- {type: filename, path: player.exe, volume: 30}\n");
+	auto device = m_enumerator.AddDevice(L"dev", L"Speakers");
+	auto game = device->AddSession(100, "/apps/game.exe", 80);
+	auto player = device->AddSession(101, "/apps/player.exe", 80);
+	auto chat = device->AddSession(102, "/apps/chat.exe", 80);
+	auto lock = Start();
+	ASSERT_EQ(game->GetVolume(), 20);
+	ASSERT_EQ(player->GetVolume(), 30);
+	ASSERT_EQ(chat->GetVolume(), 100);
+
+	// 修改时间可能与上次写入相同，手动推后，确保下一次轮询能发现变化
+	auto touch = [this]() {
+		auto path = m_dir / "config.yaml";
+		std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + 2s);
+	};
+	WriteConfig("- {type: filename, path: player.exe, volume: 35}\n- {type: filename, path: chat.exe, volume: 10}\n");
+	touch();
+	ASSERT_TRUE(WaitFor([&] { return GetMetric(lock->GetMetrics(), "volumelock_config_reloads_total") == 1; }));
+	lock->Drain();
+	// game 不再是目标，恢复到 100 且不再纠正
+	EXPECT_EQ(game->GetVolume(), 100);
+	EXPECT_EQ(player->GetVolume(), 35);
+	EXPECT_EQ(chat->GetVolume(), 10);
+	game->ChangeVolume(60);
+	lock->Drain();
+	EXPECT_EQ(game->GetVolume(), 60);
+
+	// 解析失败时保留原有规则
+	WriteConfig("- {type: filename, path: player.exe, volume: [\n");
+	touch();
+	ASSERT_TRUE(WaitFor([&] { return GetMetric(lock->GetMetrics(), "volumelock_config_reload_errors_total") == 1; }));
+	player->ChangeVolume(90);
+	lock->Drain();
+	EXPECT_EQ(player->GetVolume(), 35);
+	EXPECT_EQ(GetMetric(lock->GetMetrics(), "volumelock_config_reloads_total"), 1);
+}
+
+// 设备反复禁用、启用和切换默认设备时，重新检查的会话都命中缓存的判定且音量已正确，不写入后端
+TEST_F(SimulatorTest, RepeatedDeviceSwitchesDoNotRewriteVolumes)
+{
+	WriteConfig("- {type: filename, path: game.exe, volume: 20}\n- {type: regex, path: '.*/tools/.+\\.exe', volume: 40}\n");
+	auto speakers = m_enumerator.AddDevice(L"speakers", L"Speakers");
+	auto headset = m_enumerator.AddDevice(L"headset", L"Headset");
+	std::vector<std::shared_ptr<SimAudioSession>> sessions;
+	// 每个设备上两个目标会话、一个音量不是 100 的非目标会话，其余非目标会话已经是 100
+	for (auto&& device : { speakers, headset })
+	{
+		sessions.push_back(device->AddSession(100, "/apps/game.exe", 80));
+		sessions.push_back(device->AddSession(101, "/opt/tools/mixer.exe", 40));
+		sessions.push_back(device->AddSession(102, "/apps/chat.exe", 60));
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			sessions.push_back(device->AddSession(200 + i, "/apps/player" + std::to_string(i) + ".exe"));
+		}
+	}
+	auto writes = [&]() {
+		uint64_t total = 0;
+		for (auto&& session : sessions)
+		{
+			total += session->GetWriteCount();
+		}
+		return total;
+	};
+
+	auto lock = Start();
+	// 启动时只写入需要修改的会话：每个设备上的 game 和 chat
+	EXPECT_EQ(writes(), 4u);
+	EXPECT_EQ(GetMetric(lock->GetMetrics(), "volumelock_resets_avoided_total"), 16);
+
+	for (int round = 0; round < 10; round++)
+	{
+		m_enumerator.SetDeviceState(speakers, DeviceState::Disabled);
+		m_enumerator.SetDefaultDevice(headset);
+		m_enumerator.SetDeviceState(speakers, DeviceState::Active);
+		m_enumerator.SetDefaultDevice(speakers);
+		m_enumerator.SetDeviceState(headset, DeviceState::Unplugged);
+		m_enumerator.SetDeviceState(headset, DeviceState::Active);
+		lock->Drain();
+	}
+	// 每轮两个设备各重新检查一次，9 个非目标会话都跳过重置
+	EXPECT_EQ(writes(), 4u);
+	EXPECT_EQ(GetMetric(lock->GetMetrics(), "volumelock_resets_avoided_total"), 16 + 10 * 2 * 9);
+	EXPECT_EQ(GetMetric(lock->GetMetrics(), "volumelock_resets_total"), 2);
+	EXPECT_EQ(GetMetric(lock->GetMetrics(), "volumelock_target_sessions"), 4);
+
+	// 修改配置后缓存的判定失效，会话按新规则重新定位
+	WriteConfig("- {type: filename, path: game.exe, volume: 30}\n- {type: regex, path: '.*/apps/chat\\.exe', volume: 10}\n");
+	auto path = m_dir / "config.yaml";
+	std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + 2s);
+	ASSERT_TRUE(WaitFor([&] { return GetMetric(lock->GetMetrics(), "volumelock_config_reloads_total") == 1; }));
+	lock->Drain();
+	for (size_t i = 0; i < sessions.size(); i += 11)
+	{
+		EXPECT_EQ(sessions[i]->GetVolume(), 30);
+		EXPECT_EQ(sessions[i + 1]->GetVolume(), 100);
+		EXPECT_EQ(sessions[i + 2]->GetVolume(), 10);
+	}
+	EXPECT_EQ(writes(), 10u);
+}
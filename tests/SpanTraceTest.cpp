@@ -0,0 +1,194 @@
+﻿#include <gtest/gtest.h>
+
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+#include "SpanTrace.h"
+#include "VolumeLock.h"
+#include "AudioSimulator.h"
+#include "TestUtil.h"
+
+using namespace std::chrono_literals;
+
+#ifndef VOLUMELOCK_ENABLE_SPANS
+#error SpanTraceTest must be compiled with VOLUMELOCK_ENABLE_SPANS
+#endif
+
+namespace
+{
+	// 区间按结束的顺序记录，外层区间总是在内层之后；
+	// 每个区间的父节点是之后第一个包含它的区间
+	struct SpanNode
+	{
+		std::string Name;
+		std::vector<SpanNode> Children;
+	};
+
+	std::vector<SpanNode> BuildTree(const std::vector<SpanEvent>& events)
+	{
+		std::vector<size_t> parent(events.size(), SIZE_MAX);
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			for (size_t j = i + 1; j < events.size(); j++)
+			{
+				if (events[j].StartNs <= events[i].StartNs && events[j].StartNs + events[j].DurationNs >= events[i].StartNs + events[i].DurationNs)
+				{
+					parent[i] = j;
+					break;
+				}
+			}
+		}
+		// 从根开始按开始时间的顺序展开
+		std::function<std::vector<SpanNode>(size_t)> children = [&](size_t p) {
+			std::vector<size_t> items;
+			for (size_t i = 0; i < events.size(); i++)
+			{
+				if (parent[i] == p)
+				{
+					items.push_back(i);
+				}
+			}
+			std::stable_sort(items.begin(), items.end(), [&](size_t a, size_t b) { return events[a].StartNs < events[b].StartNs; });
+			std::vector<SpanNode> nodes;
+			for (auto i : items)
+			{
+				nodes.push_back({ events[i].Name, children(i) });
+			}
+			return nodes;
+		};
+		return children(SIZE_MAX);
+	}
+
+	// 缩进表示层级，便于比较和输出
+	void Format(const std::vector<SpanNode>& nodes, std::string& out, int depth = 0)
+	{
+		for (auto&& node : nodes)
+		{
+			out += std::string(depth * 2, ' ') + node.Name + "\n";
+			Format(node.Children, out, depth + 1);
+		}
+	}
+
+	std::string FormatThread(const std::vector<SpanEvent>& events)
+	{
+		std::string out;
+		Format(BuildTree(events), out);
+		return out;
+	}
+
+	// 找到记录了指定区间的线程
+	const std::vector<SpanEvent>* FindThread(const std::vector<std::vector<SpanEvent>>& threads, std::string_view name)
+	{
+		for (auto&& events : threads)
+		{
+			for (auto&& e : events)
+			{
+				if (e.Name == name)
+				{
+					return &events;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	class SpanTraceTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			SpanCollector::Instance().Clear();
+		}
+	};
+}
+
+TEST_F(SpanTraceTest, RecordsNestedSpans)
+{
+	{
+		TRACE_SPAN("Outer");
+		{
+			TRACE_SPAN("First");
+			TRACE_SPAN("Inner");
+		}
+		TRACE_SPAN("Second");
+	}
+	auto threads = SpanCollector::Instance().GetEvents();
+	auto events = FindThread(threads, "Outer");
+	ASSERT_NE(events, nullptr);
+	EXPECT_EQ(FormatThread(*events), "Outer\n  First\n    Inner\n  Second\n");
+}
+
+TEST_F(SpanTraceTest, KeepsBuffersOfExitedThreads)
+{
+	std::thread([]() { TRACE_SPAN("Worker"); }).join();
+	auto threads = SpanCollector::Instance().GetEvents();
+	auto events = FindThread(threads, "Worker");
+	ASSERT_NE(events, nullptr);
+	EXPECT_EQ(events->size(), 1u);
+}
+
+TEST_F(SpanTraceTest, DropsBeyondPerThreadLimit)
+{
+	std::thread([]() {
+		for (size_t i = 0; i < SpanCollector::MaxEventsPerThread + 10; i++)
+		{
+			TRACE_SPAN("Busy");
+		}
+	}).join();
+	EXPECT_EQ(SpanCollector::Instance().GetDroppedCount(), 10u);
+	SpanCollector::Instance().Clear();
+	EXPECT_EQ(SpanCollector::Instance().GetDroppedCount(), 0u);
+}
+
+TEST_F(SpanTraceTest, WritesChromeTraceEvents)
+{
+	auto& collector = SpanCollector::Instance();
+	collector.Add("Handle", 1234567, 2500);
+	std::ostringstream out;
+	out.imbue(std::locale::classic());
+	collector.WriteChromeTrace(out);
+	auto text = out.str();
+	EXPECT_EQ(text.rfind("{\"traceEvents\":[", 0), 0u);
+	// 时间单位为微秒，保留一位小数
+	EXPECT_NE(text.find("{\"name\":\"Handle\",\"ph\":\"X\",\"pid\":1,\"tid\":"), std::string::npos);
+	EXPECT_NE(text.find(",\"ts\":1234.5,\"dur\":2.5}"), std::string::npos);
+	EXPECT_NE(text.find("],\"displayTimeUnit\":\"ms\"}"), std::string::npos);
+}
+
+// 切换到一个尚未监视的设备，事件循环线程上的区间应当按调用关系嵌套
+TEST_F(SpanTraceTest, TracesDeviceSwitch)
+{
+	TempDir dir;
+	WriteFile(dir / "config.yaml", "- {type: filename, path: game.exe, volume: 20}\n");
+	SimAudioDeviceEnumerator enumerator;
+	auto speakers = enumerator.AddDevice(L"speakers", L"Speakers");
+	speakers->AddSession(100, "/apps/game.exe", 20);
+	auto headset = enumerator.AddDevice(L"headset", L"Headset");
+	auto game = headset->AddSession(101, "/apps/game.exe", 80);
+	enumerator.SetDeviceState(headset, DeviceState::Disabled);
+
+	VolumeLock lock(enumerator, dir / "config.yaml", 0ms);
+	lock.Drain();
+	SpanCollector::Instance().Clear();
+
+	enumerator.SetDefaultDevice(headset);
+	lock.Drain();
+	ASSERT_EQ(game->GetVolume(), 20);
+
+	auto threads = SpanCollector::Instance().GetEvents();
+	auto loop = FindThread(threads, "HandleDefaultDeviceChanged");
+	ASSERT_NE(loop, nullptr);
+	EXPECT_EQ(FormatThread(*loop),
+		"HandleDefaultDeviceChanged\n"
+		"  AttachDevice\n"
+		"    HandleSessionAdded\n"
+		"      EnforceVolume\n"
+		"        SetVolume\n");
+	// 通知线程上只投递事件
+	auto notify = FindThread(threads, "OnDefaultDeviceChanged");
+	ASSERT_NE(notify, nullptr);
+	EXPECT_NE(notify, loop);
+	EXPECT_EQ(FormatThread(*notify), "OnDefaultDeviceChanged\n");
+}
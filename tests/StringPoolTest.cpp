@@ -0,0 +1,115 @@
+﻿#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+#include "StringPool.h"
+#include "AudioSimulator.h"
+
+TEST(StringPoolTest, SharesEqualStrings)
+{
+	StringPool pool;
+	auto a = pool.Intern(L"{0.0.0.00000000}|\\Device\\HarddiskVolume3\\Games\\game.exe");
+	auto b = pool.Intern(std::wstring(L"{0.0.0.00000000}|\\Device\\HarddiskVolume3\\Games\\game.exe"));
+	auto c = pool.Intern(L"{0.0.0.00000000}|\\Device\\HarddiskVolume3\\Games\\GAME.exe");
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(&a.Get(), &b.Get());
+	// 驻留区分大小写，只合并完全相同的内容
+	EXPECT_NE(a, c);
+	EXPECT_EQ(c.Get(), L"{0.0.0.00000000}|\\Device\\HarddiskVolume3\\Games\\GAME.exe");
+	EXPECT_EQ(pool.Size(), 2u);
+}
+
+TEST(StringPoolTest, EmptyStringNeedsNoEntry)
+{
+	StringPool pool;
+	auto empty = pool.Intern(L"");
+	EXPECT_EQ(empty, InternedString());
+	EXPECT_EQ(empty.Get(), L"");
+	EXPECT_EQ(pool.Size(), 0u);
+}
+
+TEST(StringPoolTest, LastHandleRemovesEntry)
+{
+	StringPool pool;
+	{
+		auto a = pool.Intern(L"Speakers");
+		InternedString copy(a);
+		InternedString moved(std::move(a));
+		EXPECT_EQ(a, InternedString());
+		EXPECT_EQ(copy, moved);
+		EXPECT_EQ(pool.Size(), 1u);
+
+		// 赋值释放原来的字符串
+		copy = pool.Intern(L"Headset");
+		EXPECT_EQ(pool.Size(), 2u);
+		moved = copy;
+		EXPECT_EQ(pool.Size(), 1u);
+		EXPECT_EQ(moved.Get(), L"Headset");
+	}
+	EXPECT_EQ(pool.Size(), 0u);
+
+	// 移除后再次驻留得到新的项
+	auto again = pool.Intern(L"Speakers");
+	EXPECT_EQ(again.Get(), L"Speakers");
+	EXPECT_EQ(pool.Size(), 1u);
+}
+
+// 多个线程同时驻留、复制和释放同一组字符串，最后一个句柄释放与 Intern 找到同一项的竞争不能丢失或重复释放
+TEST(StringPoolTest, ConcurrentInternAndRelease)
+{
+	StringPool pool;
+	const std::vector<std::wstring> names{ L"game.exe", L"player.exe", L"chat.exe", L"browser.exe" };
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&pool, &names, t]() {
+			std::mt19937 rng(t);
+			std::vector<InternedString> held(8);
+			for (int i = 0; i < 50000; i++)
+			{
+				auto& slot = held[rng() % held.size()];
+				auto& name = names[rng() % names.size()];
+				switch (rng() % 3)
+				{
+				case 0:
+					slot = pool.Intern(name);
+					break;
+				case 1:
+					slot = held[rng() % held.size()];
+					break;
+				default:
+					slot = InternedString();
+					break;
+				}
+				if (slot != InternedString())
+				{
+					ASSERT_NE(std::find(names.begin(), names.end(), slot.Get()), names.end());
+				}
+			}
+		});
+	}
+	for (auto&& t : threads)
+	{
+		t.join();
+	}
+	EXPECT_EQ(pool.Size(), 0u);
+}
+
+TEST(StringPoolTest, SimulatedSessionsShareMetadata)
+{
+	SimAudioDeviceEnumerator enumerator;
+	auto device = enumerator.AddDevice(L"speakers", L"Speakers");
+	auto a = device->AddSession(100, "/apps/game.exe");
+	auto b = device->AddSession(101, "/other/game.exe");
+	auto c = device->AddSession(102, "/apps/chat.exe");
+	EXPECT_EQ(&a->GetDisplayName(), &b->GetDisplayName());
+	EXPECT_NE(&a->GetDisplayName(), &c->GetDisplayName());
+	EXPECT_EQ(a->GetDisplayName(), L"game.exe");
+
+	// 名称相同的设备（例如两个同型号的耳机）共用一份字符串
+	auto other = enumerator.AddDevice(L"speakers2", L"Speakers");
+	EXPECT_EQ(&device->GetFriendlyName(), &other->GetFriendlyName());
+	EXPECT_NE(&device->GetId(), &other->GetId());
+}
@@ -0,0 +1,10 @@
+﻿#include <gtest/gtest.h>
+
+#include "Logger.h"
+
+int main(int argc, char** argv)
+{
+	Logger::Instance().SetConsole(false);
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#include "Metrics.h"
+
+// 测试结束时删除的临时目录
+class TempDir
+{
+public:
+	TempDir()
+	{
+		static std::atomic<uint32_t> counter{ 0 };
+		auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+		m_path = std::filesystem::temp_directory_path() / ("volumelock_test_" + std::to_string(stamp) + "_" + std::to_string(counter++));
+		std::filesystem::create_directories(m_path);
+	}
+
+	~TempDir()
+	{
+		std::error_code ec;
+		std::filesystem::remove_all(m_path, ec);
+	}
+
+	TempDir(const TempDir&) = delete;
+	TempDir& operator=(const TempDir&) = delete;
+
+	const std::filesystem::path& Path() const
+	{
+		return m_path;
+	}
+
+	std::filesystem::path operator/(std::string_view name) const
+	{
+		return m_path / name;
+	}
+
+private:
+	std::filesystem::path m_path;
+};
+
+inline void WriteFile(const std::filesystem::path& path, std::string_view content)
+{
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write(content.data(), content.size());
+}
+
+// 轮询等待条件成立，超时返回 false，用于等待其他线程上的异步处理
+template <typename F>
+bool WaitFor(F&& condition, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (!condition())
+	{
+		if (std::chrono::steady_clock::now() > deadline)
+		{
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return true;
+}
+
+// 从 Prometheus 文本中读取一个计数器或仪表的值，不存在时返回 -1
+inline double GetMetric(const MetricsRegistry& registry, std::string_view name)
+{
+	std::ostringstream out;
+	registry.WritePrometheus(out);
+	std::istringstream in(out.str());
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.size() > name.size() && line.compare(0, name.size(), name) == 0 && line[name.size()] == ' ')
+		{
+			return std::stod(line.substr(name.size() + 1));
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,297 @@
+﻿#include <gtest/gtest.h>
+
+#include <map>
+#include <functional>
+#include <cwchar>
+#include <thread>
+#include <atomic>
+
+#include "EventTrace.h"
+#include "TraceReplay.h"
+#include "VolumeLock.h"
+#include "AudioSimulator.h"
+#include "TestUtil.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	// 重现时设备 ID 为记录中的哈希
+	std::wstring ReplayedDeviceId(const std::wstring& id)
+	{
+		wchar_t buf[17];
+		std::swprintf(buf, 17, L"%016llx", static_cast<unsigned long long>(HashDeviceId(id)));
+		return buf;
+	}
+
+	// 按进程记下本程序的每次写入，不同会话的写入可能并行，只比较各进程内部的顺序
+	using Writes = std::map<uint32_t, std::vector<int>>;
+
+	class WriteLog
+	{
+	public:
+		SimContext MakeContext()
+		{
+			SimContext context;
+			context.OnWrite = [this](const std::shared_ptr<SimAudioSession>& session, int volume) {
+				std::lock_guard lock(m_mutex);
+				m_writes[session->GetProcessId()].push_back(volume);
+			};
+			return context;
+		}
+
+		Writes Get()
+		{
+			std::lock_guard lock(m_mutex);
+			return m_writes;
+		}
+
+	private:
+		Writes m_writes;
+		std::mutex m_mutex;
+	};
+
+	class TraceReplayTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			WriteFile(m_dir / "config.yaml", "- {type: filename, path: game.exe, volume: 20}\n- {type: regex, path: '.*/tools/.+\\.exe', volume: 40}\n");
+		}
+
+		// 按 --replay --fast 的方式重现：先创建初始状态，再启动 VolumeLock，尽快发出所有事件
+		// inspect 在所有事件处理完之后调用，用于检查模拟后端的状态
+		Writes Replay(const Trace& trace, ReplayStats& stats, const std::function<void(SimAudioDeviceEnumerator&)>& inspect = nullptr)
+		{
+			WriteLog log;
+			SimAudioDeviceEnumerator enumerator(log.MakeContext());
+			TraceReplayer replayer(trace, enumerator);
+			replayer.ApplyInitialState();
+			VolumeLock lock(enumerator, m_dir / "config.yaml", 0ms);
+			lock.Drain();
+			stats = replayer.Run(false);
+			lock.Drain();
+			if (inspect)
+			{
+				inspect(enumerator);
+			}
+			return log.Get();
+		}
+
+		TempDir m_dir;
+	};
+}
+
+TEST_F(TraceReplayTest, ReplaysRecordedSessionWrites)
+{
+	WriteLog log;
+	SimAudioDeviceEnumerator enumerator(log.MakeContext());
+	auto speakers = enumerator.AddDevice(L"speakers", L"Speakers");
+	auto headset = enumerator.AddDevice(L"headset", L"Headset");
+	auto game = speakers->AddSession(100, "/apps/game.exe", 80);
+	auto chat = speakers->AddSession(101, "/apps/chat.exe", 50);
+
+	TraceRecorder recorder;
+	{
+		VolumeLock lock(enumerator, m_dir / "config.yaml", 0ms, &recorder);
+		lock.Drain();
+		game->ChangeVolume(70);
+		lock.Drain();
+		headset->AddSession(102, "/opt/tools/mixer.exe", 90);
+		enumerator.SetDefaultDevice(headset);
+		lock.Drain();
+		game->ChangeVolume(30);
+		speakers->RemoveSession(chat);
+		lock.Drain();
+		enumerator.SetDeviceState(headset, DeviceState::Disabled);
+		lock.Drain();
+		enumerator.SetDeviceState(headset, DeviceState::Active);
+		lock.Drain();
+	}
+	auto recorded = log.Get();
+	// game 和 mixer 锁定音量，chat 恢复到 100
+	// 快速重现不等 VolumeLock 处理完新会话，所以这里只改初始会话的音量
+	ASSERT_EQ(recorded, (Writes{ { 100, { 20, 20, 20 } }, { 101, { 100 } }, { 102, { 40 } } }));
+
+	ASSERT_TRUE(recorder.Save(m_dir / "events.trace"));
+	EXPECT_EQ(recorder.GetDroppedCount(), 0u);
+	auto trace = LoadTrace(m_dir / "events.trace");
+	ASSERT_TRUE(trace.has_value());
+	// 两个设备、两个会话和默认设备
+	EXPECT_EQ(trace->Initial.size(), 5u);
+	EXPECT_EQ(trace->Processes.size(), 3u);
+	std::vector<TraceKind> kinds;
+	for (auto&& record : trace->Events)
+	{
+		kinds.push_back(record.Kind);
+	}
+	EXPECT_EQ(kinds, (std::vector<TraceKind>{ TraceKind::VolumeChanged, TraceKind::SessionAdded, TraceKind::DefaultDeviceChanged, TraceKind::VolumeChanged,
+		TraceKind::SessionRemoved, TraceKind::DeviceStateChanged, TraceKind::DeviceStateChanged }));
+
+	ReplayStats stats;
+	auto replayed = Replay(*trace, stats);
+	EXPECT_EQ(stats.Events, 7u);
+	EXPECT_EQ(stats.Skipped, 0u);
+	EXPECT_EQ(replayed, recorded);
+}
+
+TEST_F(TraceReplayTest, ReplaysVolumeChangeOnRecordedDevice)
+{
+	WriteLog log;
+	SimAudioDeviceEnumerator enumerator(log.MakeContext());
+	auto speakers = enumerator.AddDevice(L"speakers", L"Speakers");
+	auto headset = enumerator.AddDevice(L"headset", L"Headset");
+	speakers->AddSession(100, "/apps/game.exe", 80);
+	auto onHeadset = headset->AddSession(100, "/apps/game.exe", 80);
+
+	TraceRecorder recorder;
+	{
+		VolumeLock lock(enumerator, m_dir / "config.yaml", 0ms, &recorder);
+		lock.Drain();
+		onHeadset->ChangeVolume(70);
+		lock.Drain();
+	}
+	ASSERT_EQ(log.Get(), (Writes{ { 100, { 20, 20, 20 } } }));
+
+	ASSERT_TRUE(recorder.Save(m_dir / "events.trace"));
+	auto trace = LoadTrace(m_dir / "events.trace");
+	ASSERT_TRUE(trace.has_value());
+	ASSERT_EQ(trace->Events.size(), 1u);
+	EXPECT_EQ(trace->Events[0].Device, HashDeviceId(L"headset"));
+
+	ReplayStats stats;
+	uint64_t speakersWrites = 0;
+	uint64_t headsetWrites = 0;
+	Replay(*trace, stats, [&](SimAudioDeviceEnumerator& replayed) {
+		auto count = [&](const std::wstring& id) {
+			auto device = replayed.GetDeviceById(ReplayedDeviceId(id));
+			EXPECT_TRUE(device.has_value());
+			uint64_t writes = 0;
+			for (auto&& session : device.value()->GetAllSession())
+			{
+				writes += std::static_pointer_cast<SimAudioSession>(session)->GetWriteCount();
+			}
+			return writes;
+		};
+		speakersWrites = count(L"speakers");
+		headsetWrites = count(L"headset");
+	});
+	EXPECT_EQ(stats.Events, 1u);
+	EXPECT_EQ(speakersWrites, 1u);
+	EXPECT_EQ(headsetWrites, 2u);
+}
+
+TEST_F(TraceReplayTest, KeepsPathsOfReusedPids)
+{
+	WriteLog log;
+	SimAudioDeviceEnumerator enumerator(log.MakeContext());
+	auto speakers = enumerator.AddDevice(L"speakers", L"Speakers");
+	auto game = speakers->AddSession(100, "/apps/game.exe", 80, 1);
+
+	TraceRecorder recorder;
+	{
+		VolumeLock lock(enumerator, m_dir / "config.yaml", 0ms, &recorder);
+		lock.Drain();
+		speakers->RemoveSession(game, SessionExpiredReason);
+		lock.Drain();
+		// 同一个 pid 被新进程复用
+		speakers->AddSession(100, "/apps/chat.exe", 50, 2);
+		lock.Drain();
+	}
+	auto recorded = log.Get();
+	ASSERT_EQ(recorded, (Writes{ { 100, { 20, 100 } } }));
+
+	ASSERT_TRUE(recorder.Save(m_dir / "events.trace"));
+	auto trace = LoadTrace(m_dir / "events.trace");
+	ASSERT_TRUE(trace.has_value());
+	EXPECT_EQ(trace->Processes, (std::map<std::pair<uint32_t, uint64_t>, std::filesystem::path>{ { { 100, 1 }, "/apps/game.exe" }, { { 100, 2 }, "/apps/chat.exe" } }));
+
+	ReplayStats stats;
+	EXPECT_EQ(Replay(*trace, stats), recorded);
+	EXPECT_EQ(stats.Skipped, 0u);
+}
+
+TEST_F(TraceReplayTest, RejectsDamagedFile)
+{
+	TraceRecorder recorder;
+	recorder.Record(TraceKind::DeviceAdded, 0, 0, 1, 0, 0);
+	ASSERT_TRUE(recorder.Save(m_dir / "events.trace"));
+	ASSERT_TRUE(LoadTrace(m_dir / "events.trace").has_value());
+
+	auto size = std::filesystem::file_size(m_dir / "events.trace");
+	std::filesystem::resize_file(m_dir / "events.trace", size - 1);
+	EXPECT_FALSE(LoadTrace(m_dir / "events.trace").has_value());
+	WriteFile(m_dir / "events.trace", "not a trace");
+	EXPECT_FALSE(LoadTrace(m_dir / "events.trace").has_value());
+	EXPECT_FALSE(LoadTrace(m_dir / "missing.trace").has_value());
+}
+
+TEST_F(TraceReplayTest, KeepsMostRecentEventsWhenFull)
+{
+	TraceRecorder recorder(4);
+	for (int32_t i = 0; i < 10; i++)
+	{
+		recorder.Record(TraceKind::VolumeChanged, 100, 0, 1, i, 0);
+	}
+	EXPECT_EQ(recorder.GetDroppedCount(), 6u);
+	ASSERT_TRUE(recorder.Save(m_dir / "events.trace"));
+	auto trace = LoadTrace(m_dir / "events.trace");
+	ASSERT_TRUE(trace.has_value());
+	ASSERT_EQ(trace->Events.size(), 4u);
+	for (size_t i = 0; i < 4; i++)
+	{
+		EXPECT_EQ(trace->Events[i].Volume, static_cast<int32_t>(6 + i));
+	}
+}
+
+TEST_F(TraceReplayTest, SavesPeriodicallyWhileRecording)
+{
+	TraceRecorder recorder;
+	recorder.RecordInitial(TraceKind::DeviceAdded, 0, 0, 1, 0, 0);
+	TraceSaver saver(recorder, m_dir / "events.trace", 10ms);
+	for (int32_t i = 0; i < 3; i++)
+	{
+		recorder.Record(TraceKind::VolumeChanged, 100, 0, 1, i, 0);
+	}
+	// 不等待退出，运行期间的文件已经可以读取
+	EXPECT_TRUE(WaitFor([&] {
+		auto trace = LoadTrace(m_dir / "events.trace");
+		return trace.has_value() && trace->Initial.size() == 1 && trace->Events.size() == 3;
+	}));
+	EXPECT_FALSE(std::filesystem::exists(m_dir / "events.trace.tmp"));
+}
+
+TEST_F(TraceReplayTest, SavesConsistentRecordsWhileRecording)
+{
+	TraceRecorder recorder(256);
+	std::atomic<bool> stop{ false };
+	std::vector<std::thread> threads;
+	for (uint32_t t = 1; t <= 4; t++)
+	{
+		threads.emplace_back([&recorder, &stop, t]() {
+			for (int32_t i = 0; !stop; i++)
+			{
+				recorder.Record(TraceKind::VolumeChanged, t, i, t, i, i);
+			}
+		});
+	}
+	for (int i = 0; i < 50; i++)
+	{
+		ASSERT_TRUE(recorder.Save(m_dir / "events.trace"));
+		auto trace = LoadTrace(m_dir / "events.trace");
+		ASSERT_TRUE(trace.has_value());
+		EXPECT_LE(trace->Events.size(), 256u);
+		// 写了一半的记录会被跳过，保存的每条记录都是完整的
+		for (auto&& record : trace->Events)
+		{
+			ASSERT_EQ(record.Device, record.Pid);
+			ASSERT_EQ(static_cast<uint64_t>(record.Volume), record.StartTime);
+			ASSERT_EQ(record.Volume, record.Reason);
+		}
+	}
+	stop = true;
+	for (auto&& thread : threads)
+	{
+		thread.join();
+	}
+}
@@ -0,0 +1,239 @@
+﻿#include <gtest/gtest.h>
+
+#include <random>
+
+#include "Utf8.h"
+#include "Config.h"
+#include "TestUtil.h"
+
+namespace
+{
+	std::string Encode(uint32_t cp)
+	{
+		std::string s;
+		if (cp < 0x80)
+		{
+			s += static_cast<char>(cp);
+		}
+		else if (cp < 0x800)
+		{
+			s += static_cast<char>(0xc0 | (cp >> 6));
+			s += static_cast<char>(0x80 | (cp & 0x3f));
+		}
+		else if (cp < 0x10000)
+		{
+			s += static_cast<char>(0xe0 | (cp >> 12));
+			s += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+			s += static_cast<char>(0x80 | (cp & 0x3f));
+		}
+		else
+		{
+			s += static_cast<char>(0xf0 | (cp >> 18));
+			s += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+			s += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+			s += static_cast<char>(0x80 | (cp & 0x3f));
+		}
+		return s;
+	}
+
+	// wchar_t 为 16 位时补充平面的字符编码为代理对
+	std::wstring Wide(uint32_t cp)
+	{
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			if (cp >= 0x10000)
+			{
+				cp -= 0x10000;
+				return { static_cast<wchar_t>(0xd800 | (cp >> 10)), static_cast<wchar_t>(0xdc00 | (cp & 0x3ff)) };
+			}
+		}
+		return std::wstring(1, static_cast<wchar_t>(cp));
+	}
+
+	// 解码失败时返回出错的位置，成功时返回 -1
+	long ErrorOffset(std::string_view s)
+	{
+		std::wstring out;
+		size_t offset = 0;
+		return DecodeUtf8(s, out, offset) ? -1 : static_cast<long>(offset);
+	}
+
+	// 按 Unicode 表 3-7 逐字节检查，返回与 DecodeUtf8 约定相同的出错位置，合法时返回 -1
+	long ReferenceErrorOffset(std::string_view s)
+	{
+		for (size_t i = 0; i < s.size();)
+		{
+			auto c = static_cast<unsigned char>(s[i]);
+			if (c < 0x80)
+			{
+				i++;
+				continue;
+			}
+			// 序列长度和第二个字节的范围
+			size_t length = 0;
+			unsigned char lo = 0x80;
+			unsigned char hi = 0xbf;
+			if (c >= 0xc2 && c <= 0xdf)
+			{
+				length = 2;
+			}
+			else if (c >= 0xe0 && c <= 0xef)
+			{
+				length = 3;
+				lo = c == 0xe0 ? 0xa0 : 0x80;
+				hi = c == 0xed ? 0x9f : 0xbf;
+			}
+			else if (c >= 0xf0 && c <= 0xf4)
+			{
+				length = 4;
+				lo = c == 0xf0 ? 0x90 : 0x80;
+				hi = c == 0xf4 ? 0x8f : 0xbf;
+			}
+			else
+			{
+				return static_cast<long>(i);
+			}
+			for (size_t k = 1; k < length; k++)
+			{
+				if (i + k >= s.size())
+				{
+					return static_cast<long>(i);
+				}
+				auto b = static_cast<unsigned char>(s[i + k]);
+				if (b < (k == 1 ? lo : 0x80) || b > (k == 1 ? hi : 0xbf))
+				{
+					return static_cast<long>(i + k);
+				}
+			}
+			i += length;
+		}
+		return -1;
+	}
+}
+
+TEST(Utf8Test, RoundTripsEveryScalarValue)
+{
+	std::string all;
+	std::wstring expected;
+	for (uint32_t cp = 0; cp <= 0x10ffff; cp++)
+	{
+		if (cp >= 0xd800 && cp < 0xe000)
+		{
+			continue;
+		}
+		all += Encode(cp);
+		expected += Wide(cp);
+	}
+	EXPECT_EQ(Utf8ToWide(all), expected);
+}
+
+TEST(Utf8Test, DecodesBoundaryValues)
+{
+	EXPECT_EQ(Utf8ToWide(""), L"");
+	EXPECT_EQ(Utf8ToWide(std::string("a\0b", 3)), std::wstring(L"a\0b", 3));
+	EXPECT_EQ(Utf8ToWide("\x7f\xc2\x80\xdf\xbf"), L"\u007f\u0080\u07ff");
+	EXPECT_EQ(Utf8ToWide("\xe0\xa0\x80\xed\x9f\xbf\xee\x80\x80\xef\xbf\xbd\xef\xbf\xbf"), L"\u0800\ud7ff\ue000\ufffd\uffff");
+	EXPECT_EQ(Utf8ToWide("\xf0\x90\x80\x80"), Wide(0x10000));
+	EXPECT_EQ(Utf8ToWide("\xf4\x8f\xbf\xbf"), Wide(0x10ffff));
+	EXPECT_EQ(Utf8ToWide("D:\\游戏\\原神.exe"), L"D:\\游戏\\原神.exe");
+}
+
+TEST(Utf8Test, RejectsMalformedSequences)
+{
+	const std::pair<const char*, long> cases[] = {
+		// 单独的后续字节和不可能出现的字节
+		{ "\x80", 0 },
+		{ "ab\xbf", 2 },
+		{ "\xfe", 0 },
+		{ "\xff", 0 },
+		{ "\xf5\x80\x80\x80", 0 },
+		// 过长编码
+		{ "\xc0\x80", 0 },
+		{ "\xc1\xbf", 0 },
+		{ "\xe0\x80\x80", 1 },
+		{ "\xe0\x9f\xbf", 1 },
+		{ "\xf0\x80\x80\x80", 1 },
+		{ "\xf0\x8f\xbf\xbf", 1 },
+		// 代理项和超出 U+10FFFF 的码点
+		{ "\xed\xa0\x80", 1 },
+		{ "\xed\xbf\xbf", 1 },
+		{ "x\xf4\x90\x80\x80", 2 },
+		// 序列中间出现非后续字节
+		{ "\xe4\x41\x80", 1 },
+		{ "\xf0\x9f\x98\x41", 3 },
+		// 字符串结尾的不完整序列指向序列开头
+		{ "abc\xe4\xb8", 3 },
+		{ "\xf0\x9f\x98", 0 },
+		{ "\xc3", 0 },
+	};
+	for (auto&& [input, offset] : cases)
+	{
+		EXPECT_EQ(ErrorOffset(input), offset) << testing::PrintToString(std::string(input));
+	}
+}
+
+TEST(Utf8Test, ReportsOffsetAfterAsciiRun)
+{
+	// 错误出现在批量复制的 ASCII 块中间和之后的位置都准确
+	for (size_t prefix : { 0, 1, 15, 16, 17, 31, 32, 40, 100 })
+	{
+		std::string s(prefix, 'a');
+		s += "\xff";
+		s += std::string(20, 'b');
+		EXPECT_EQ(ErrorOffset(s), static_cast<long>(prefix)) << prefix;
+	}
+	try
+	{
+		Utf8ToWide(std::string(40, 'a') + "\xc0\x80");
+		FAIL();
+	}
+	catch (const Utf8Error& e)
+	{
+		EXPECT_EQ(e.GetOffset(), 40u);
+		EXPECT_STREQ(e.what(), "无效的 UTF-8 编码，位于字符串的第 41 个字节");
+	}
+}
+
+// 随机拼接合法和非法的片段，与参照实现对比出错位置
+TEST(Utf8Test, AgreesWithReferenceOnRandomInput)
+{
+	const std::vector<std::string> pieces{
+		"a", "Program Files\\Some Game\\", Encode(0xe9), Encode(0x6e38), Encode(0x1f600), Encode(0x10ffff),
+		"\x80", "\xbf", "\xc0\xaf", "\xe0\x80", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xe4\xb8", "\xf0\x9f", "\xf5", "\xff",
+	};
+	std::mt19937 rng(17);
+	size_t failures = 0;
+	for (int round = 0; round < 50000; round++)
+	{
+		std::string s;
+		auto count = rng() % 12;
+		for (size_t i = 0; i < count; i++)
+		{
+			s += pieces[rng() % pieces.size()];
+		}
+		auto expected = ReferenceErrorOffset(s);
+		failures += expected >= 0;
+		ASSERT_EQ(ErrorOffset(s), expected) << testing::PrintToString(s);
+	}
+	// 两种结果都有足够多的样本
+	EXPECT_GT(failures, 10000u);
+	EXPECT_LT(failures, 45000u);
+}
+
+TEST(Utf8Test, ConfigReportsInvalidUtf8Position)
+{
+	TempDir dir;
+	WriteFile(dir / "config.yaml", "- {type: filename, path: \"game\xff.exe\", volume: 20}\n");
+	try
+	{
+		LoadConfig(dir / "config.yaml");
+		FAIL();
+	}
+	catch (const std::exception& e)
+	{
+		std::string message = e.what();
+		// 同时给出 YAML 的行列和字符串内的字节位置
+		EXPECT_NE(message.find("line 1"), std::string::npos) << message;
+		EXPECT_NE(message.find("第 5 个字节"), std::string::npos) << message;
+	}
+}
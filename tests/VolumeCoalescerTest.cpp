@@ -0,0 +1,132 @@
+﻿#include <gtest/gtest.h>
+
+#include <string>
+
+#include "VolumeCoalescer.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+	// 只提供类型的时钟，时间全部由测试推进
+	struct FakeClock
+	{
+		using duration = std::chrono::milliseconds;
+		using rep = duration::rep;
+		using period = duration::period;
+		using time_point = std::chrono::time_point<FakeClock>;
+		static constexpr bool is_steady = true;
+	};
+
+	using Coalescer = VolumeCoalescer<std::string, FakeClock>;
+
+	class VolumeCoalescerTest : public testing::Test
+	{
+	protected:
+		std::vector<std::pair<std::string, int>> Flush()
+		{
+			std::vector<std::pair<std::string, int>> flushed;
+			m_coalescer.Flush(m_now, [&](const std::string& key, int volume) { flushed.emplace_back(key, volume); });
+			return flushed;
+		}
+
+		Coalescer m_coalescer{ 50ms };
+		FakeClock::time_point m_now{ 1000ms };
+	};
+
+	using Flushed = std::vector<std::pair<std::string, int>>;
+}
+
+TEST_F(VolumeCoalescerTest, KeepsLastValueUntilWindowEnds)
+{
+	// 拖动滑块：窗口内连续的变化只在结束时处理一次，使用最后的值
+	EXPECT_TRUE(m_coalescer.Observe("game", 70, m_now));
+	for (int volume = 65; volume > 40; volume -= 5)
+	{
+		m_now += 8ms;
+		EXPECT_FALSE(m_coalescer.Observe("game", volume, m_now));
+		EXPECT_TRUE(Flush().empty());
+	}
+	EXPECT_EQ(m_now, FakeClock::time_point(1040ms));
+	m_now += 9ms;
+	EXPECT_TRUE(Flush().empty());
+	m_now += 1ms;
+	EXPECT_EQ(Flush(), (Flushed{ { "game", 45 } }));
+	EXPECT_EQ(m_coalescer.GetPendingCount(), 0u);
+	EXPECT_TRUE(Flush().empty());
+}
+
+TEST_F(VolumeCoalescerTest, WindowStartsAtFirstEvent)
+{
+	// 持续的事件不会无限推迟纠正
+	m_coalescer.Observe("game", 10, m_now);
+	for (int i = 0; i < 5; i++)
+	{
+		m_now += 10ms;
+		m_coalescer.Observe("game", 11 + i, m_now);
+	}
+	EXPECT_EQ(m_coalescer.NextDeadline(), FakeClock::time_point(1050ms));
+	EXPECT_EQ(Flush(), (Flushed{ { "game", 15 } }));
+	// 之后的事件开启新的窗口
+	m_now += 5ms;
+	EXPECT_TRUE(m_coalescer.Observe("game", 30, m_now));
+	EXPECT_EQ(m_coalescer.NextDeadline(), FakeClock::time_point(1105ms));
+}
+
+TEST_F(VolumeCoalescerTest, TracksSessionsIndependently)
+{
+	EXPECT_FALSE(m_coalescer.NextDeadline().has_value());
+	m_coalescer.Observe("a", 10, m_now);
+	m_now += 20ms;
+	m_coalescer.Observe("b", 20, m_now);
+	m_coalescer.Observe("a", 11, m_now);
+	EXPECT_EQ(m_coalescer.GetPendingCount(), 2u);
+	EXPECT_EQ(m_coalescer.NextDeadline(), FakeClock::time_point(1050ms));
+
+	m_now = FakeClock::time_point(1050ms);
+	EXPECT_EQ(Flush(), (Flushed{ { "a", 11 } }));
+	EXPECT_EQ(m_coalescer.NextDeadline(), FakeClock::time_point(1070ms));
+	m_now = FakeClock::time_point(1100ms);
+	EXPECT_EQ(Flush(), (Flushed{ { "b", 20 } }));
+}
+
+TEST_F(VolumeCoalescerTest, CallbackMayObserveAgain)
+{
+	m_coalescer.Observe("game", 10, m_now);
+	m_now += 50ms;
+	// 纠正时会话又发生了变化，开启新窗口
+	m_coalescer.Flush(m_now, [&](const std::string& key, int volume) {
+		EXPECT_EQ(volume, 10);
+		EXPECT_TRUE(m_coalescer.Observe(key, 90, m_now));
+	});
+	EXPECT_EQ(m_coalescer.GetPendingCount(), 1u);
+	m_now += 50ms;
+	EXPECT_EQ(Flush(), (Flushed{ { "game", 90 } }));
+}
+
+TEST_F(VolumeCoalescerTest, ErasedSessionIsNotFlushed)
+{
+	m_coalescer.Observe("a", 10, m_now);
+	m_coalescer.Observe("b", 20, m_now);
+	m_coalescer.Erase("a");
+	m_now += 50ms;
+	EXPECT_EQ(Flush(), (Flushed{ { "b", 20 } }));
+
+	m_coalescer.Observe("c", 30, m_now);
+	m_coalescer.Clear();
+	m_now += 50ms;
+	EXPECT_TRUE(Flush().empty());
+	EXPECT_FALSE(m_coalescer.NextDeadline().has_value());
+}
+
+TEST_F(VolumeCoalescerTest, ZeroWindowFlushesImmediately)
+{
+	Coalescer coalescer(0ms);
+	EXPECT_TRUE(coalescer.Observe("game", 10, m_now));
+	int calls = 0;
+	coalescer.Flush(m_now, [&](const std::string&, int volume) {
+		EXPECT_EQ(volume, 10);
+		calls++;
+	});
+	EXPECT_EQ(calls, 1);
+}
@@ -0,0 +1,120 @@
+﻿#include <gtest/gtest.h>
+
+#include <set>
+#include <stdexcept>
+
+#include "WorkerPool.h"
+#include "AudioSimulator.h"
+
+using namespace std::chrono_literals;
+
+TEST(WorkerPoolTest, RunsEveryIndexOnce)
+{
+	WorkerPool pool(4);
+	std::vector<std::atomic<int>> hits(1000);
+	pool.Run(hits.size(), [&](size_t i) { hits[i]++; });
+	for (auto&& h : hits)
+	{
+		EXPECT_EQ(h.load(), 1);
+	}
+	pool.Run(0, [](size_t) { FAIL(); });
+}
+
+TEST(WorkerPoolTest, ReusesThreadsAcrossRuns)
+{
+	std::atomic<int> inits{ 0 };
+	std::atomic<int> releases{ 0 };
+	{
+		WorkerPool pool(3, [&]() {
+			inits++;
+			return std::shared_ptr<void>(nullptr, [&](void*) { releases++; });
+		});
+
+		std::mutex mutex;
+		std::set<std::thread::id> threads;
+		for (int run = 0; run < 20; run++)
+		{
+			pool.Run(30, [&](size_t) {
+				std::lock_guard lock(mutex);
+				threads.insert(std::this_thread::get_id());
+			});
+		}
+		// 每个工作线程只初始化一次，也不会为每次调用创建新线程
+		EXPECT_LE(threads.size(), pool.Size());
+		EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+		EXPECT_EQ(inits.load(), 3);
+	}
+	EXPECT_EQ(releases.load(), 3);
+}
+
+TEST(WorkerPoolTest, RethrowsAfterAllTasksComplete)
+{
+	WorkerPool pool(4);
+	std::atomic<int> done{ 0 };
+	EXPECT_THROW(pool.Run(100, [&](size_t i) {
+		if (i % 10 == 7)
+		{
+			throw std::runtime_error("task failed");
+		}
+		done++;
+	}), std::runtime_error);
+	// 失败的任务不影响其他任务，池也可以继续使用
+	EXPECT_EQ(done.load(), 90);
+	pool.Run(10, [&](size_t) { done++; });
+	EXPECT_EQ(done.load(), 100);
+}
+
+TEST(WorkerPoolTest, RunsNestedCallsInline)
+{
+	WorkerPool pool(2);
+	std::atomic<int> inner{ 0 };
+	pool.Run(4, [&](size_t) {
+		pool.Run(3, [&](size_t) { inner++; });
+	});
+	EXPECT_EQ(inner.load(), 12);
+}
+
+TEST(WorkerPoolTest, SerializesConcurrentCallers)
+{
+	WorkerPool pool(2);
+	std::atomic<int> total{ 0 };
+	std::vector<std::thread> callers;
+	for (int t = 0; t < 4; t++)
+	{
+		callers.emplace_back([&]() {
+			for (int run = 0; run < 50; run++)
+			{
+				pool.Run(20, [&](size_t) { total++; });
+			}
+		});
+	}
+	for (auto&& c : callers)
+	{
+		c.join();
+	}
+	EXPECT_EQ(total.load(), 4 * 50 * 20);
+}
+
+// 与构造 Core Audio 会话相同，每个任务的大部分时间在等待跨进程调用
+TEST(WorkerPoolTest, OverlapsSlowBackendCalls)
+{
+	SimContext context;
+	context.Latency.GetVolume = 25ms;
+	SimAudioDeviceEnumerator enumerator(context);
+	auto device = enumerator.AddDevice(L"dev", L"Speakers");
+	std::vector<std::shared_ptr<SimAudioSession>> sessions;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		sessions.push_back(device->AddSession(100 + i, "/apps/app" + std::to_string(i) + ".exe", 50));
+	}
+
+	WorkerPool pool(4);
+	std::vector<int> volumes(sessions.size());
+	auto start = std::chrono::steady_clock::now();
+	pool.Run(sessions.size(), [&](size_t i) { volumes[i] = sessions[i]->GetVolume(); });
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	// 依次执行需要 400ms，4 个线程约 100ms
+	EXPECT_LT(elapsed, 300ms);
+	EXPECT_EQ(volumes, std::vector<int>(sessions.size(), 50));
+}